@@ -0,0 +1,441 @@
+#include "ECBatchElevatorSim.h"
+#include <algorithm>
+#include <climits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace {
+bool RequestMadeEarlier(const ECElevatorSimRequest &lhs, const ECElevatorSimRequest &rhs) {
+    return lhs.GetTime() < rhs.GetTime();
+}
+
+//*****************************************************************************
+// Kernels: for each of the LANES cars, pick the next floor the way
+// ECElevatorSim::UpdateDirection and ExecuteMove do and move there.
+//
+//   no stop requests        -> STOPPED, stay
+//   going up, any above     -> nearest above
+//   going down, any below   -> nearest below
+//   otherwise               -> nearest either way, the lower one on a tie
+//
+// The current floor is never in the request bitmap at this point (it was just
+// served). Adds one to the move count of every car that moved.
+
+void MoveCarsScalar(int *floor, int *direction, const unsigned int *active, int *moves) {
+    for (int lane = 0; lane < ECBatchElevatorSim::LANES; ++lane) {
+        unsigned int requested = active[lane];
+        if (requested == 0) {
+            direction[lane] = EC_ELEVATOR_STOPPED;
+            continue;
+        }
+        int cur = floor[lane];
+        unsigned int above = requested & ~((2u << cur) - 1);
+        unsigned int below = requested & ((1u << cur) - 1);
+        int upFloor = above ? __builtin_ctz(above) : 0;
+        int downFloor = below ? 31 - __builtin_clz(below) : 0;
+
+        bool fUp;
+        if (direction[lane] == EC_ELEVATOR_UP && above) {
+            fUp = true;
+        } else if (direction[lane] == EC_ELEVATOR_DOWN && below) {
+            fUp = false;
+        } else {
+            fUp = above && (!below || upFloor - cur < cur - downFloor);
+        }
+        floor[lane] = fUp ? upFloor : downFloor;
+        direction[lane] = fUp ? EC_ELEVATOR_UP : EC_ELEVATOR_DOWN;
+        moves[lane]++;
+    }
+}
+
+// Lanes with a request due by time or someone to let on or off at the car's floor
+unsigned int LanesWithWorkScalar(const int *floor, const unsigned int *stopAt, const int *nextArrival, int time) {
+    unsigned int work = 0;
+    for (int lane = 0; lane < ECBatchElevatorSim::LANES; ++lane) {
+        if (nextArrival[lane] <= time || ((stopAt[lane] >> floor[lane]) & 1)) {
+            work |= 1u << lane;
+        }
+    }
+    return work;
+}
+
+#if defined(__AVX2__)
+// Index of the single set bit, from the exponent of its float value
+inline __m256i BitIndex(__m256i powerOfTwo) {
+    __m256i bits = _mm256_castps_si256(_mm256_cvtepi32_ps(powerOfTwo));
+    return _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+}
+
+void MoveCars8(int *floor, int *direction, const unsigned int *active, int *moves) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(floor));
+    __m256i dir = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(direction));
+    __m256i requested = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(active));
+
+    __m256i atOrBelowCur = _mm256_sub_epi32(_mm256_sllv_epi32(_mm256_set1_epi32(2), cur), one);
+    __m256i belowCur = _mm256_sub_epi32(_mm256_sllv_epi32(one, cur), one);
+    __m256i above = _mm256_andnot_si256(atOrBelowCur, requested);
+    __m256i below = _mm256_and_si256(requested, belowCur);
+
+    // Nearest above: lowest set bit. Nearest below: highest set bit, isolated by smearing it down.
+    __m256i upFloor = BitIndex(_mm256_and_si256(above, _mm256_sub_epi32(zero, above)));
+    __m256i smear = below;
+    smear = _mm256_or_si256(smear, _mm256_srli_epi32(smear, 1));
+    smear = _mm256_or_si256(smear, _mm256_srli_epi32(smear, 2));
+    smear = _mm256_or_si256(smear, _mm256_srli_epi32(smear, 4));
+    smear = _mm256_or_si256(smear, _mm256_srli_epi32(smear, 8));
+    smear = _mm256_or_si256(smear, _mm256_srli_epi32(smear, 16));
+    __m256i downFloor = BitIndex(_mm256_xor_si256(smear, _mm256_srli_epi32(smear, 1)));
+
+    __m256i noneAbove = _mm256_cmpeq_epi32(above, zero);
+    __m256i noneBelow = _mm256_cmpeq_epi32(below, zero);
+    __m256i noneRequested = _mm256_cmpeq_epi32(requested, zero);
+    __m256i keepUp = _mm256_andnot_si256(noneAbove, _mm256_cmpeq_epi32(dir, _mm256_set1_epi32(EC_ELEVATOR_UP)));
+    __m256i keepDown = _mm256_andnot_si256(noneBelow, _mm256_cmpeq_epi32(dir, _mm256_set1_epi32(EC_ELEVATOR_DOWN)));
+    __m256i upCloser = _mm256_cmpgt_epi32(_mm256_sub_epi32(cur, downFloor), _mm256_sub_epi32(upFloor, cur));
+    __m256i preferUp = _mm256_andnot_si256(noneAbove, _mm256_or_si256(noneBelow, upCloser));
+    __m256i goUp = _mm256_or_si256(keepUp, _mm256_andnot_si256(keepDown, preferUp));
+
+    __m256i next = _mm256_blendv_epi8(downFloor, upFloor, goUp);
+    __m256i nextDir = _mm256_blendv_epi8(_mm256_set1_epi32(EC_ELEVATOR_DOWN), _mm256_set1_epi32(EC_ELEVATOR_UP), goUp);
+    cur = _mm256_blendv_epi8(next, cur, noneRequested);
+    dir = _mm256_blendv_epi8(nextDir, _mm256_set1_epi32(EC_ELEVATOR_STOPPED), noneRequested);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(floor), cur);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(direction), dir);
+
+    // noneRequested is -1 where the car stayed
+    __m256i moveCount = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(moves));
+    moveCount = _mm256_add_epi32(_mm256_add_epi32(moveCount, one), noneRequested);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(moves), moveCount);
+}
+
+void MoveCarsAVX2(int *floor, int *direction, const unsigned int *active, int *moves) {
+    MoveCars8(floor, direction, active, moves);
+    MoveCars8(floor + 8, direction + 8, active + 8, moves + 8);
+}
+
+unsigned int LanesWithWork8(const int *floor, const unsigned int *stopAt, const int *nextArrival, int time) {
+    __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(floor));
+    __m256i stops = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(stopAt));
+    __m256i arrivals = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(nextArrival));
+    __m256i due = _mm256_cmpgt_epi32(_mm256_set1_epi32(time + 1), arrivals);
+    __m256i stopHere = _mm256_slli_epi32(_mm256_srlv_epi32(stops, cur), 31);   // the floor's bit, moved to the sign
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(due, stopHere)));
+}
+
+unsigned int LanesWithWorkAVX2(const int *floor, const unsigned int *stopAt, const int *nextArrival, int time) {
+    return LanesWithWork8(floor, stopAt, nextArrival, time) | (LanesWithWork8(floor + 8, stopAt + 8, nextArrival + 8, time) << 8);
+}
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+void MoveCarsAVX512(int *floor, int *direction, const unsigned int *active, int *moves) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i thirtyOne = _mm512_set1_epi32(31);
+    __m512i cur = _mm512_loadu_si512(floor);
+    __m512i dir = _mm512_loadu_si512(direction);
+    __m512i requested = _mm512_loadu_si512(active);
+
+    __m512i atOrBelowCur = _mm512_sub_epi32(_mm512_sllv_epi32(_mm512_set1_epi32(2), cur), one);
+    __m512i belowCur = _mm512_sub_epi32(_mm512_sllv_epi32(one, cur), one);
+    __m512i above = _mm512_andnot_si512(atOrBelowCur, requested);
+    __m512i below = _mm512_and_si512(requested, belowCur);
+
+    __m512i lowestAbove = _mm512_and_si512(above, _mm512_sub_epi32(zero, above));
+    __m512i upFloor = _mm512_sub_epi32(thirtyOne, _mm512_lzcnt_epi32(lowestAbove));
+    __m512i downFloor = _mm512_sub_epi32(thirtyOne, _mm512_lzcnt_epi32(below));
+
+    __mmask16 anyAbove = _mm512_test_epi32_mask(above, above);
+    __mmask16 anyBelow = _mm512_test_epi32_mask(below, below);
+    __mmask16 anyRequested = _mm512_test_epi32_mask(requested, requested);
+    __mmask16 keepUp = anyAbove & _mm512_cmpeq_epi32_mask(dir, _mm512_set1_epi32(EC_ELEVATOR_UP));
+    __mmask16 keepDown = anyBelow & _mm512_cmpeq_epi32_mask(dir, _mm512_set1_epi32(EC_ELEVATOR_DOWN));
+    __mmask16 upCloser = _mm512_cmplt_epi32_mask(_mm512_sub_epi32(upFloor, cur), _mm512_sub_epi32(cur, downFloor));
+    __mmask16 preferUp = anyAbove & (~anyBelow | upCloser);
+    __mmask16 goUp = keepUp | (~keepDown & preferUp);
+
+    __m512i next = _mm512_mask_blend_epi32(goUp, downFloor, upFloor);
+    __m512i nextDir = _mm512_mask_blend_epi32(goUp, _mm512_set1_epi32(EC_ELEVATOR_DOWN), _mm512_set1_epi32(EC_ELEVATOR_UP));
+    cur = _mm512_mask_mov_epi32(cur, anyRequested, next);
+    dir = _mm512_maskz_mov_epi32(anyRequested, nextDir);   // STOPPED is 0
+
+    _mm512_storeu_si512(floor, cur);
+    _mm512_storeu_si512(direction, dir);
+    _mm512_storeu_si512(moves, _mm512_mask_add_epi32(_mm512_loadu_si512(moves), anyRequested, _mm512_loadu_si512(moves), one));
+}
+
+unsigned int LanesWithWorkAVX512(const int *floor, const unsigned int *stopAt, const int *nextArrival, int time) {
+    __m512i cur = _mm512_loadu_si512(floor);
+    __m512i stops = _mm512_loadu_si512(stopAt);
+    __m512i arrivals = _mm512_loadu_si512(nextArrival);
+    __mmask16 due = _mm512_cmple_epi32_mask(arrivals, _mm512_set1_epi32(time));
+    __mmask16 stopHere = _mm512_test_epi32_mask(_mm512_srlv_epi32(stops, cur), _mm512_set1_epi32(1));
+    return due | stopHere;
+}
+#endif
+}
+
+//*****************************************************************************
+
+ECBatchElevatorSim::ECBatchElevatorSim(int numFloorsIn)
+    : numFloors(numFloorsIn), kernel(EC_BATCH_KERNEL_SCALAR),
+      numIncomplete(0), buildingTicks(0), digestBuilding(-1), digest(NULL) {
+    if (IsKernelAvailable(EC_BATCH_KERNEL_AVX512)) {
+        kernel = EC_BATCH_KERNEL_AVX512;
+    } else if (IsKernelAvailable(EC_BATCH_KERNEL_AVX2)) {
+        kernel = EC_BATCH_KERNEL_AVX2;
+    }
+}
+
+bool ECBatchElevatorSim::IsKernelAvailable(EC_BATCH_KERNEL kernel) {
+    switch (kernel) {
+        case EC_BATCH_KERNEL_SCALAR: return true;
+#if defined(__AVX2__)
+        case EC_BATCH_KERNEL_AVX2: return true;
+#endif
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+        case EC_BATCH_KERNEL_AVX512: return true;
+#endif
+        default: return false;
+    }
+}
+
+const char *ECBatchElevatorSim::GetKernelName(EC_BATCH_KERNEL kernel) {
+    switch (kernel) {
+        case EC_BATCH_KERNEL_SCALAR: return "scalar";
+        case EC_BATCH_KERNEL_AVX2: return "avx2";
+        case EC_BATCH_KERNEL_AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+int ECBatchElevatorSim::AddBuilding(const std::vector<ECElevatorSimRequest> &requests) {
+    std::shared_ptr<std::vector<ECElevatorSimRequest> > schedule = std::make_shared<std::vector<ECElevatorSimRequest> >(requests);
+    std::stable_sort(schedule->begin(), schedule->end(), RequestMadeEarlier);
+    return AddBuilding(std::shared_ptr<const std::vector<ECElevatorSimRequest> >(schedule));
+}
+
+int ECBatchElevatorSim::AddBuilding(std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule) {
+    // Floors index the per-lane bit masks and the per-building counters
+    if (!IsValid()) {
+        return -1;
+    }
+    for (const ECElevatorSimRequest &request : *schedule) {
+        if (request.GetFloorSrc() < 1 || request.GetFloorSrc() > numFloors ||
+            request.GetFloorDest() < 1 || request.GetFloorDest() > numFloors) {
+            return -1;
+        }
+    }
+
+    int index = static_cast<int>(buildings.size());
+    int lane = index % LANES;
+    if (lane == 0) {
+        LaneGroup group;
+        for (int i = 0; i < LANES; ++i) {
+            group.floor[i] = 1;
+            group.direction[i] = EC_ELEVATOR_STOPPED;
+            group.active[i] = 0;
+            group.stopAt[i] = 0;
+            group.nextArrival[i] = INT_MAX;
+            group.moves[i] = 0;
+        }
+        group.live = 0;
+        group.time = 0;
+        groups.push_back(group);
+    }
+
+    buildings.push_back(Building());
+    Building &building = buildings.back();
+    FloorState empty = { 0, 0, 0, 0 };
+    building.schedule = schedule;
+    building.nextRequestIndex = 0;
+    building.floors.resize(numFloors + 1, empty);
+    building.waitingTo.resize((numFloors + 1) * (numFloors + 1), 0);
+    building.numRiders = 0;
+    NoteNextArrival(building, groups.back(), lane);
+
+    // Like ECElevatorSim, a building with nothing to do is finished before it starts
+    if (!schedule->empty()) {
+        groups.back().live |= 1u << lane;
+        numIncomplete++;
+    } else {
+        building.result.fComplete = true;
+    }
+    return index;
+}
+
+// Groups are independent, so each runs all its ticks before the next starts;
+// that keeps the working set to one group's buildings
+void ECBatchElevatorSim::StepN(int numSteps) {
+    for (size_t group = 0; group < groups.size(); ++group) {
+        for (int step = 0; step < numSteps && groups[group].live != 0; ++step) {
+            TickGroup(static_cast<int>(group));
+        }
+    }
+}
+
+// One tick of every unfinished building in the group
+void ECBatchElevatorSim::TickGroup(int group) {
+    LaneGroup &lanes = groups[group];
+    Building *first = &buildings[group * LANES];
+    bool fDigestTick = digest != NULL && digestBuilding / LANES == group && ((lanes.live >> (digestBuilding % LANES)) & 1);
+
+    unsigned int work;
+    switch (kernel) {
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+        case EC_BATCH_KERNEL_AVX512: work = LanesWithWorkAVX512(lanes.floor, lanes.stopAt, lanes.nextArrival, lanes.time); break;
+#endif
+#if defined(__AVX2__)
+        case EC_BATCH_KERNEL_AVX2: work = LanesWithWorkAVX2(lanes.floor, lanes.stopAt, lanes.nextArrival, lanes.time); break;
+#endif
+        default: work = LanesWithWorkScalar(lanes.floor, lanes.stopAt, lanes.nextArrival, lanes.time); break;
+    }
+    work &= lanes.live;
+
+    for (unsigned int lanesLeft = work; lanesLeft != 0; lanesLeft &= lanesLeft - 1) {
+        ArriveAndHandle(first[__builtin_ctz(lanesLeft)], lanes, __builtin_ctz(lanesLeft));
+    }
+
+    // Finished and empty lanes have no stop requests, so the kernel leaves them alone
+    switch (kernel) {
+#if defined(__AVX512F__) && defined(__AVX512CD__)
+        case EC_BATCH_KERNEL_AVX512: MoveCarsAVX512(lanes.floor, lanes.direction, lanes.active, lanes.moves); break;
+#endif
+#if defined(__AVX2__)
+        case EC_BATCH_KERNEL_AVX2: MoveCarsAVX2(lanes.floor, lanes.direction, lanes.active, lanes.moves); break;
+#endif
+        default: MoveCarsScalar(lanes.floor, lanes.direction, lanes.active, lanes.moves); break;
+    }
+
+    lanes.time++;
+    buildingTicks += __builtin_popcount(lanes.live);
+
+    // Only a tick with something to do can finish a building
+    for (unsigned int lanesLeft = work; lanesLeft != 0; lanesLeft &= lanesLeft - 1) {
+        int lane = __builtin_ctz(lanesLeft);
+        if (lanes.nextArrival[lane] == INT_MAX && lanes.active[lane] == 0 && lanes.stopAt[lane] == 0) {
+            first[lane].result.fComplete = true;
+            first[lane].result.timeNow = lanes.time;
+            lanes.live &= ~(1u << lane);
+            numIncomplete--;
+        }
+    }
+
+    if (fDigestTick) {
+        FillState(digestBuilding, digestState);
+        digest->Record(digestState);
+    }
+}
+
+void ECBatchElevatorSim::AttachDigest(int building, ECDigestWriter *writer) {
+    digestBuilding = building;
+    digest = writer;
+    digestState.Resize(numFloors);
+}
+
+void ECBatchElevatorSim::FillState(int building, ECEngineState &state) const {
+    if (state.numFloors != numFloors) {
+        state.Resize(numFloors);
+    }
+    ECBatchBuildingResult result = GetResult(building);
+    const Building &counters = buildings[building];
+    unsigned int active = groups[building / LANES].active[building % LANES];
+    state.time = result.timeNow;
+    state.currentFloor = result.currentFloor;
+    state.direction = result.direction;
+    state.requests = result.requests;
+    state.boardings = result.boardings;
+    state.alightings = result.alightings;
+    state.moves = result.moves;
+    state.waitTicksSum = result.waitTicksSum;
+    for (int floor = 1; floor <= numFloors; ++floor) {
+        state.waiting[floor] = counters.floors[floor].waiting;
+        state.ridersTo[floor] = counters.floors[floor].riders;
+        state.stopRequested[floor] = (active >> floor) & 1;
+    }
+}
+
+void ECBatchElevatorSim::NoteNextArrival(const Building &building, LaneGroup &lanes, int lane) {
+    const std::vector<ECElevatorSimRequest> &schedule = *building.schedule;
+    lanes.nextArrival[lane] = building.nextRequestIndex < schedule.size() ? schedule[building.nextRequestIndex].GetTime() : INT_MAX;
+}
+
+// Requests made this tick, then the people getting off and on at the car's floor
+void ECBatchElevatorSim::ArriveAndHandle(Building &building, LaneGroup &lanes, int lane) {
+    int time = lanes.time;
+    unsigned int &active = lanes.active[lane];
+    unsigned int &stopAt = lanes.stopAt[lane];
+    int stride = numFloors + 1;
+
+    if (lanes.nextArrival[lane] <= time) {
+        const std::vector<ECElevatorSimRequest> &schedule = *building.schedule;
+        while (building.nextRequestIndex < schedule.size() && schedule[building.nextRequestIndex].GetTime() <= time) {
+            const ECElevatorSimRequest &request = schedule[building.nextRequestIndex++];
+            int src = request.GetFloorSrc();
+            int dest = request.GetFloorDest();
+            FloorState &srcFloor = building.floors[src];
+            building.waitingTo[src * stride + dest]++;
+            srcFloor.waiting++;
+            srcFloor.waitingTimeSum += request.GetTime();
+            srcFloor.destMask |= 1u << dest;
+            building.result.requests++;
+            active |= 1u << src;
+            stopAt |= 1u << src;
+        }
+        NoteNextArrival(building, lanes, lane);
+    }
+
+    int floor = lanes.floor[lane];
+    FloorState &here = building.floors[floor];
+    if (((stopAt >> floor) & 1) == 0) {
+        return;   // the car's floor is not in the request bitmap either
+    }
+
+    // Riders who boarded on an earlier tick get off; those boarding now stay on, as in ECElevatorSim
+    if (here.riders > 0) {
+        building.numRiders -= here.riders;
+        building.result.alightings += here.riders;
+        here.riders = 0;
+    }
+
+    int numOn = here.waiting;
+    if (numOn > 0) {
+        int *waitingTo = &building.waitingTo[floor * stride];
+        for (unsigned int dests = here.destMask; dests != 0; dests &= dests - 1) {
+            int dest = __builtin_ctz(dests);
+            building.floors[dest].riders += waitingTo[dest];
+            waitingTo[dest] = 0;
+        }
+        active |= here.destMask;
+        stopAt |= here.destMask;
+        here.destMask = 0;
+        building.result.waitTicksSum += static_cast<long long>(numOn) * time - here.waitingTimeSum;
+        here.waitingTimeSum = 0;
+        here.waiting = 0;
+        building.numRiders += numOn;
+        building.result.boardings += numOn;
+    }
+
+    active &= ~(1u << floor);
+    if (here.riders == 0) {
+        stopAt &= ~(1u << floor);
+    }
+}
+
+ECBatchBuildingResult ECBatchElevatorSim::GetResult(int building) const {
+    ECBatchBuildingResult result = buildings[building].result;
+    const LaneGroup &lanes = groups[building / LANES];
+    int lane = building % LANES;
+    if (!result.fComplete) {
+        result.timeNow = lanes.time;
+    }
+    result.currentFloor = lanes.floor[lane];
+    result.direction = static_cast<EC_ELEVATOR_DIR>(lanes.direction[lane]);
+    result.moves = lanes.moves[lane];
+    result.numRiders = buildings[building].numRiders;
+    return result;
+}
@@ -0,0 +1,130 @@
+#ifndef ECBATCHELEVATORSIM_H
+#define ECBATCHELEVATORSIM_H
+
+#include "ECElevatorSim1.h"
+#include "ECStateDigest.h"
+#include <vector>
+#include <memory>
+
+//*****************************************************************************
+// Kernel that moves the cars of a lane group
+typedef enum {
+    EC_BATCH_KERNEL_SCALAR = 0,
+    EC_BATCH_KERNEL_AVX2,       // built with -mavx2
+    EC_BATCH_KERNEL_AVX512      // built with -mavx512f -mavx512cd
+} EC_BATCH_KERNEL;
+
+//*****************************************************************************
+// Where one building of a batch stands; the same figures ECElevatorSim reports
+struct ECBatchBuildingResult
+{
+    ECBatchBuildingResult() : timeNow(0), currentFloor(1), direction(EC_ELEVATOR_STOPPED), numRiders(0),
+        requests(0), boardings(0), alightings(0), moves(0), waitTicksSum(0), fComplete(false) {}
+
+    int timeNow;            // ticks run
+    int currentFloor;
+    EC_ELEVATOR_DIR direction;
+    int numRiders;
+    long long requests;
+    long long boardings;
+    long long alightings;
+    long long moves;
+    long long waitTicksSum; // summed over boardings; ECElevatorSim::GetWaitTimes().GetSum()
+    bool fComplete;
+};
+
+//*****************************************************************************
+// Many independent single-car buildings of the same height, stepped in lockstep.
+// Buildings are packed sixteen to a lane group: car floors, directions and the
+// bitmaps of floors with a stop request sit side by side, and one kernel call
+// picks the next floor and moves all sixteen cars at once (one AVX-512 vector,
+// two AVX2 vectors, or a scalar loop). A second kernel finds the buildings with
+// a request due or someone to let on or off; only those drop to per-building
+// code, which works on per-floor counters rather than request lists.
+//
+// Each building behaves exactly like an ECElevatorSim stepped with StepN on the
+// same requests. A batch holds 1..30 floors (see IsValid) and refuses buildings
+// with a request naming a floor outside 1..numFloors.
+class ECBatchElevatorSim
+{
+public:
+    static const int LANES = 16;
+    static const int MAX_FLOORS = 30;
+
+    explicit ECBatchElevatorSim(int numFloorsIn);
+    bool IsValid() const { return numFloors >= 1 && numFloors <= MAX_FLOORS; }
+
+    // Add buildings before stepping; returns the building's index, or -1 if the batch is
+    // not valid or a request names a floor outside 1..numFloors
+    int AddBuilding(const std::vector<ECElevatorSimRequest> &requests);
+    int AddBuilding(std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule);   // sorted by time
+
+    // Advance every building up to numSteps ticks; finished buildings stop, as with StepN
+    void StepN(int numSteps);
+    bool IsComplete() const { return numIncomplete == 0; }
+
+    int GetNumFloors() const { return numFloors; }
+    int GetNumBuildings() const { return static_cast<int>(buildings.size()); }
+    ECBatchBuildingResult GetResult(int building) const;
+    long long GetBuildingTicks() const { return buildingTicks; }   // summed over buildings
+
+    // Digest stream of one building, as ECElevatorSim::AttachDigest (not owned; NULL to stop)
+    void AttachDigest(int building, ECDigestWriter *writer);
+    void FillState(int building, ECEngineState &state) const;
+
+    // Kernel choice; defaults to the widest one compiled in
+    static bool IsKernelAvailable(EC_BATCH_KERNEL kernel);
+    static const char *GetKernelName(EC_BATCH_KERNEL kernel);
+    void SetKernel(EC_BATCH_KERNEL kernelIn) { if (IsKernelAvailable(kernelIn)) kernel = kernelIn; }
+    EC_BATCH_KERNEL GetKernel() const { return kernel; }
+
+private:
+    // Counters of one floor of one building
+    struct FloorState
+    {
+        int waiting;                 // people waiting here
+        int riders;                  // riders getting off here
+        unsigned int destMask;       // destinations wanted by the people waiting here
+        long long waitingTimeSum;    // sum of their request times, for waiting times
+    };
+
+    // Irregular per-building state; only touched on ticks with something to do
+    struct Building
+    {
+        std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule;
+        size_t nextRequestIndex;
+        std::vector<FloorState> floors;        // indexed by floor
+        std::vector<int> waitingTo;            // (numFloors+1)^2: people waiting on a floor for each destination
+        int numRiders;
+        ECBatchBuildingResult result;          // counters; timeNow is set once finished
+    };
+
+    // Car state of LANES buildings, side by side for the kernels
+    struct LaneGroup
+    {
+        int floor[LANES];
+        int direction[LANES];
+        unsigned int active[LANES];   // bit f set: floor f has a stop request
+        unsigned int stopAt[LANES];   // bit f set: someone waits on floor f or rides to it
+        int nextArrival[LANES];       // time of the next scheduled request; INT_MAX when none are left
+        int moves[LANES];
+        unsigned int live;            // bit per lane: holds a building that is not finished
+        int time;                     // ticks run by the unfinished buildings
+    };
+
+    void TickGroup(int group);
+    void ArriveAndHandle(Building &building, LaneGroup &lanes, int lane);
+    void NoteNextArrival(const Building &building, LaneGroup &lanes, int lane);
+
+    int numFloors;
+    EC_BATCH_KERNEL kernel;
+    std::vector<Building> buildings;
+    std::vector<LaneGroup> groups;
+    int numIncomplete;
+    long long buildingTicks;
+    int digestBuilding;
+    ECDigestWriter *digest;       // not owned; NULL unless writing digests
+    ECEngineState digestState;
+};
+
+#endif /* ECBATCHELEVATORSIM_H */
@@ -0,0 +1,213 @@
+#include "ECCallCostKernel.h"
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace {
+const float PADDING_COST = 1e30f;   // base cost of the cars that only pad the last lane group
+
+//*****************************************************************************
+// Kernels: score one call against the first numCars cars (rounded up to a whole
+// vector; the padding cars never win), writing the costs when row is not NULL
+// and returning the cheapest car. Each does the same float operations as the
+// scalar one, in the same order.
+
+int ScoreCallScalar(const float *carFloor, const float *carDirection, const float *carBase, int numCars,
+                    const ECCallCostWeights &weights, float src, float direction, float *row) {
+    float best = FLT_MAX;
+    int bestCar = 0;
+    for (int car = 0; car < numCars; ++car) {
+        float diff = src - carFloor[car];
+        float dist = fabsf(diff);
+        float moving = carDirection[car];
+        bool fWith = moving == direction && moving * diff >= 0.0f;
+        bool fAway = moving != 0.0f && !fWith;
+        float cost = (carBase[car] + dist * weights.floorTicks) + (fAway ? weights.reverseTicks : 0.0f);
+        if (row != NULL) {
+            row[car] = cost;
+        }
+        if (cost < best) {
+            best = cost;
+            bestCar = car;
+        }
+    }
+    return bestCar;
+}
+
+#if defined(__AVX2__)
+int ScoreCallAVX2(const float *carFloor, const float *carDirection, const float *carBase, int numCars,
+                  const ECCallCostWeights &weights, float src, float direction, float *row) {
+    const __m256 vSrc = _mm256_set1_ps(src);
+    const __m256 vDirection = _mm256_set1_ps(direction);
+    const __m256 vFloorTicks = _mm256_set1_ps(weights.floorTicks);
+    const __m256 vReverseTicks = _mm256_set1_ps(weights.reverseTicks);
+    const __m256 vZero = _mm256_setzero_ps();
+    const __m256 vSign = _mm256_set1_ps(-0.0f);
+    const __m256i vStep = _mm256_set1_epi32(8);
+    __m256 vBest = _mm256_set1_ps(FLT_MAX);
+    __m256i vBestCar = _mm256_setzero_si256();
+    __m256i vCar = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (int car = 0; car < numCars; car += 8) {
+        __m256 diff = _mm256_sub_ps(vSrc, _mm256_loadu_ps(carFloor + car));
+        __m256 dist = _mm256_andnot_ps(vSign, diff);
+        __m256 moving = _mm256_loadu_ps(carDirection + car);
+        __m256 with = _mm256_and_ps(_mm256_cmp_ps(moving, vDirection, _CMP_EQ_OQ),
+                                    _mm256_cmp_ps(_mm256_mul_ps(moving, diff), vZero, _CMP_GE_OQ));
+        __m256 away = _mm256_andnot_ps(with, _mm256_cmp_ps(moving, vZero, _CMP_NEQ_OQ));
+        __m256 cost = _mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(carBase + car), _mm256_mul_ps(dist, vFloorTicks)),
+                                    _mm256_and_ps(away, vReverseTicks));
+        if (row != NULL) {
+            _mm256_storeu_ps(row + car, cost);
+        }
+        __m256 less = _mm256_cmp_ps(cost, vBest, _CMP_LT_OQ);
+        vBest = _mm256_blendv_ps(vBest, cost, less);
+        vBestCar = _mm256_blendv_epi8(vBestCar, vCar, _mm256_castps_si256(less));
+        vCar = _mm256_add_epi32(vCar, vStep);
+    }
+
+    // Cheapest cost across the lanes, then the lowest car among the lanes that have it
+    __m256 vMin = _mm256_min_ps(vBest, _mm256_permute2f128_ps(vBest, vBest, 1));
+    vMin = _mm256_min_ps(vMin, _mm256_shuffle_ps(vMin, vMin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vMin = _mm256_min_ps(vMin, _mm256_shuffle_ps(vMin, vMin, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m256i vTied = _mm256_castps_si256(_mm256_cmp_ps(vBest, vMin, _CMP_EQ_OQ));
+    __m256i vCars = _mm256_blendv_epi8(_mm256_set1_epi32(INT_MAX), vBestCar, vTied);
+    vCars = _mm256_min_epi32(vCars, _mm256_permute2x128_si256(vCars, vCars, 1));
+    vCars = _mm256_min_epi32(vCars, _mm256_shuffle_epi32(vCars, _MM_SHUFFLE(1, 0, 3, 2)));
+    vCars = _mm256_min_epi32(vCars, _mm256_shuffle_epi32(vCars, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm256_cvtsi256_si32(vCars);
+}
+#endif
+
+#if defined(__AVX512F__)
+int ScoreCallAVX512(const float *carFloor, const float *carDirection, const float *carBase, int numCars,
+                    const ECCallCostWeights &weights, float src, float direction, float *row) {
+    const __m512 vSrc = _mm512_set1_ps(src);
+    const __m512 vDirection = _mm512_set1_ps(direction);
+    const __m512 vFloorTicks = _mm512_set1_ps(weights.floorTicks);
+    const __m512 vReverseTicks = _mm512_set1_ps(weights.reverseTicks);
+    const __m512 vZero = _mm512_setzero_ps();
+    const __m512i vStep = _mm512_set1_epi32(16);
+    __m512 vBest = _mm512_set1_ps(FLT_MAX);
+    __m512i vBestCar = _mm512_setzero_si512();
+    __m512i vCar = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    for (int car = 0; car < numCars; car += 16) {
+        __m512 diff = _mm512_sub_ps(vSrc, _mm512_loadu_ps(carFloor + car));
+        __m512 dist = _mm512_abs_ps(diff);
+        __m512 moving = _mm512_loadu_ps(carDirection + car);
+        __mmask16 with = _mm512_cmp_ps_mask(moving, vDirection, _CMP_EQ_OQ) &
+                         _mm512_cmp_ps_mask(_mm512_mul_ps(moving, diff), vZero, _CMP_GE_OQ);
+        __mmask16 away = _mm512_cmp_ps_mask(moving, vZero, _CMP_NEQ_OQ) & ~with;
+        __m512 cost = _mm512_add_ps(_mm512_add_ps(_mm512_loadu_ps(carBase + car), _mm512_mul_ps(dist, vFloorTicks)),
+                                    _mm512_maskz_mov_ps(away, vReverseTicks));
+        if (row != NULL) {
+            _mm512_storeu_ps(row + car, cost);
+        }
+        __mmask16 less = _mm512_cmp_ps_mask(cost, vBest, _CMP_LT_OQ);
+        vBest = _mm512_mask_blend_ps(less, vBest, cost);
+        vBestCar = _mm512_mask_blend_epi32(less, vBestCar, vCar);
+        vCar = _mm512_add_epi32(vCar, vStep);
+    }
+
+    // Cheapest cost across the lanes, then the lowest car among the lanes that have it
+    __mmask16 tied = _mm512_cmp_ps_mask(vBest, _mm512_set1_ps(_mm512_reduce_min_ps(vBest)), _CMP_EQ_OQ);
+    return _mm512_mask_reduce_min_epi32(tied, vBestCar);
+}
+#endif
+}
+
+ECCallCostKernel::ECCallCostKernel(int numCarsIn)
+    : numCars(numCarsIn > 0 ? numCarsIn : 0), kernel(EC_COST_KERNEL_SCALAR), inputs(numCars) {
+    int stride = (numCars + LANES - 1) / LANES * LANES;
+    carFloor.assign(stride, 0.0f);
+    carDirection.assign(stride, 0.0f);
+    carBase.assign(stride, PADDING_COST);
+    for (int car = 0; car < numCars; ++car) {
+        SetCar(car, 1, 0, 0, 1, 0);
+    }
+    if (IsKernelAvailable(EC_COST_KERNEL_AVX512)) {
+        kernel = EC_COST_KERNEL_AVX512;
+    } else if (IsKernelAvailable(EC_COST_KERNEL_AVX2)) {
+        kernel = EC_COST_KERNEL_AVX2;
+    }
+}
+
+bool ECCallCostKernel::IsKernelAvailable(EC_COST_KERNEL kernel) {
+    switch (kernel) {
+        case EC_COST_KERNEL_SCALAR: return true;
+#if defined(__AVX2__)
+        case EC_COST_KERNEL_AVX2: return true;
+#endif
+#if defined(__AVX512F__)
+        case EC_COST_KERNEL_AVX512: return true;
+#endif
+        default: return false;
+    }
+}
+
+const char *ECCallCostKernel::GetKernelName(EC_COST_KERNEL kernel) {
+    switch (kernel) {
+        case EC_COST_KERNEL_SCALAR: return "scalar";
+        case EC_COST_KERNEL_AVX2: return "avx2";
+        case EC_COST_KERNEL_AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+void ECCallCostKernel::SetWeights(const ECCallCostWeights &weightsIn) {
+    weights = weightsIn;
+    for (int car = 0; car < numCars; ++car) {
+        Fold(car);
+    }
+}
+
+void ECCallCostKernel::SetCar(int car, int floor, int direction, int load, int capacity, int numStops) {
+    CarInput &input = inputs[car];
+    input.floor = floor;
+    input.direction = direction > 0 ? 1 : (direction < 0 ? -1 : 0);
+    input.load = load;
+    input.capacity = capacity > 0 ? capacity : 1;
+    input.numStops = numStops;
+    Fold(car);
+}
+
+void ECCallCostKernel::Fold(int car) {
+    const CarInput &input = inputs[car];
+    carFloor[car] = static_cast<float>(input.floor);
+    carDirection[car] = static_cast<float>(input.direction);
+    carBase[car] = input.numStops * weights.stopTicks + static_cast<float>(input.load) / input.capacity * weights.loadTicks +
+                   (input.load >= input.capacity ? weights.fullTicks : 0.0f);
+}
+
+void ECCallCostKernel::Score(const int *floorSrc, const int *floorDest, int numCalls, float *costs, int *bestCar) const {
+    int stride = GetStride();
+    if (stride == 0) {
+        return;
+    }
+    for (int call = 0; call < numCalls; ++call) {
+        float src = static_cast<float>(floorSrc[call]);
+        float direction = floorDest[call] > floorSrc[call] ? 1.0f : -1.0f;
+        float *row = costs != NULL ? costs + static_cast<size_t>(call) * stride : NULL;
+        int car;
+        switch (kernel) {
+#if defined(__AVX512F__)
+            case EC_COST_KERNEL_AVX512:
+                car = ScoreCallAVX512(carFloor.data(), carDirection.data(), carBase.data(), numCars, weights, src, direction, row);
+                break;
+#endif
+#if defined(__AVX2__)
+            case EC_COST_KERNEL_AVX2:
+                car = ScoreCallAVX2(carFloor.data(), carDirection.data(), carBase.data(), numCars, weights, src, direction, row);
+                break;
+#endif
+            default:
+                car = ScoreCallScalar(carFloor.data(), carDirection.data(), carBase.data(), numCars, weights, src, direction, row);
+                break;
+        }
+        bestCar[call] = car;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef ECCALLCOSTKERNEL_H
+#define ECCALLCOSTKERNEL_H
+
+#include <vector>
+
+//*****************************************************************************
+// Instruction set the kernel scores with
+typedef enum {
+    EC_COST_KERNEL_SCALAR = 0,   // reference
+    EC_COST_KERNEL_AVX2,         // built with -mavx2
+    EC_COST_KERNEL_AVX512        // built with -mavx512f
+} EC_COST_KERNEL;
+
+//*****************************************************************************
+// Weights of the cost terms, in ticks
+struct ECCallCostWeights
+{
+    ECCallCostWeights() : floorTicks(1.0f), stopTicks(1.0f), loadTicks(4.0f), reverseTicks(10.0f), fullTicks(1000.0f) {}
+
+    float floorTicks;     // travel per floor
+    float stopTicks;      // per stop the car already has planned
+    float loadTicks;      // at a full car, pro rata below
+    float reverseTicks;   // the car is moving away from the call or the other way
+    float fullTicks;      // the car has no room left
+};
+
+//*****************************************************************************
+// Scores a batch of hall calls against every car of a bank at once:
+//
+//   cost = stops * stopTicks + load / capacity * loadTicks + (full ? fullTicks : 0)
+//        + |floor - call floor| * floorTicks
+//        + (moving, and away from the call or the other way ? reverseTicks : 0)
+//
+// The car terms that do not depend on the call are folded once per car when
+// it is set. Cars are kept as structure of arrays, padded to a multiple of
+// LANES with cars that never win, so one call is scored against 8 (AVX2) or
+// 16 (AVX-512) cars per instruction, keeping the cheapest car of each lane
+// as it goes and reducing across the lanes once per call. The scalar kernel
+// does the same float operations in the same order, so every kernel gives
+// bit-identical costs and picks the same car (the lowest-numbered on a tie).
+class ECCallCostKernel
+{
+public:
+    static const int LANES = 16;
+
+    explicit ECCallCostKernel(int numCarsIn);
+
+    void SetWeights(const ECCallCostWeights &weightsIn);
+    const ECCallCostWeights &GetWeights() const { return weights; }
+    // direction: 1 up, -1 down, 0 idle
+    void SetCar(int car, int floor, int direction, int load, int capacity, int numStops);
+
+    // costs: numCalls rows of GetStride() floats, of which the first GetNumCars() are set
+    // (NULL to skip them); bestCar: numCalls entries
+    void Score(const int *floorSrc, const int *floorDest, int numCalls, float *costs, int *bestCar) const;
+
+    int GetNumCars() const { return numCars; }
+    int GetStride() const { return static_cast<int>(carFloor.size()); }
+
+    // Kernel choice; defaults to the widest one compiled in
+    static bool IsKernelAvailable(EC_COST_KERNEL kernel);
+    static const char *GetKernelName(EC_COST_KERNEL kernel);
+    void SetKernel(EC_COST_KERNEL kernelIn) { if (IsKernelAvailable(kernelIn)) kernel = kernelIn; }
+    EC_COST_KERNEL GetKernel() const { return kernel; }
+
+private:
+    struct CarInput
+    {
+        int floor;
+        int direction;
+        int load;
+        int capacity;
+        int numStops;
+    };
+
+    void Fold(int car);
+
+    int numCars;
+    EC_COST_KERNEL kernel;
+    ECCallCostWeights weights;
+    std::vector<CarInput> inputs;
+    // Structure of arrays, GetStride() entries each
+    std::vector<float> carFloor;
+    std::vector<float> carDirection;
+    std::vector<float> carBase;    // the terms that do not depend on the call
+};
+
+#endif /* ECCALLCOSTKERNEL_H */
@@ -0,0 +1,196 @@
+#ifndef ECCARLOAD_H
+#define ECCARLOAD_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+//*****************************************************************************
+// One person in the car
+struct ECCarRider
+{
+    int id;           // given by the car in boarding order
+    int floorSrc;     // 0 when not known
+    int floorDest;
+    int timeCall;     // hall call time; -1 when not known
+    int timeBoard;    // -1 when not known
+};
+
+//*****************************************************************************
+// Riders to one floor, in boarding order
+struct ECCarRiderRange
+{
+    const ECCarRider *first;
+    const ECCarRider *last;
+
+    const ECCarRider *begin() const { return first; }
+    const ECCarRider *end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+};
+
+//*****************************************************************************
+// The people in a car, kept per destination floor with a bitmap of the floors
+// someone is riding to: unloading a floor or one rider, asking whether anyone
+// rides to it and reading the load are all O(1) (amortized), whatever the load.
+//
+// Iterating yields the destination of every rider in boarding order, which is
+// the order the trace prints them in. A rider leaves the boarding log lazily:
+// destinations empty out in boarding order, so a rider is still on board while
+// its id is above the last id unloaded for its floor. The log is compacted
+// once it is mostly riders who have left.
+class ECCarLoad
+{
+public:
+    struct LogEntry
+    {
+        int id;
+        int floorDest;
+    };
+
+    class Iterator
+    {
+    public:
+        Iterator(const LogEntry *entryIn, const LogEntry *lastIn, const int *goneUpToIn)
+            : entry(entryIn), last(lastIn), goneUpTo(goneUpToIn) { Skip(); }
+        int operator*() const { return entry->floorDest; }
+        Iterator &operator++() { ++entry; Skip(); return *this; }
+        bool operator!=(const Iterator &rhs) const { return entry != rhs.entry; }
+
+    private:
+        void Skip() { while (entry != last && entry->id <= goneUpTo[entry->floorDest]) ++entry; }
+
+        const LogEntry *entry;
+        const LogEntry *last;
+        const int *goneUpTo;
+    };
+
+    explicit ECCarLoad(int numFloors = 0) : load(0), nextRiderId(0) { Resize(numFloors); }
+
+    // Returns the rider's id, or -1 for a destination below floor 1
+    int Board(int floorDest, int floorSrc = 0, int timeCall = -1, int timeBoard = -1) {
+        ECCarRider rider = { nextRiderId, floorSrc, floorDest, timeCall, timeBoard };
+        return Board(rider) ? rider.id : -1;
+    }
+    // Keeps the rider's id, which must be above every id boarded so far; false for a
+    // destination below floor 1
+    bool Board(const ECCarRider &rider) {
+        if (rider.floorDest < 1) {
+            return false;
+        }
+        if (rider.floorDest >= static_cast<int>(ridersTo.size())) {
+            Resize(rider.floorDest);
+        }
+        ridersTo[rider.floorDest].push_back(rider);
+        destBits[rider.floorDest / 64] |= uint64_t(1) << (rider.floorDest % 64);
+        LogEntry entry = { rider.id, rider.floorDest };
+        boardingLog.push_back(entry);
+        if (rider.id >= nextRiderId) {
+            nextRiderId = rider.id + 1;
+        }
+        load++;
+        return true;
+    }
+    // Ids below nextId are not given out again (used when restoring a saved load)
+    void ReserveRiderIds(int nextId) {
+        if (nextId > nextRiderId) {
+            nextRiderId = nextId;
+        }
+    }
+
+    // Everyone riding to floor gets off; read GetRidersFor first to see who they were
+    int Unload(int floor) {
+        if (!HasRidersFor(floor)) {
+            return 0;
+        }
+        std::vector<ECCarRider> &riders = ridersTo[floor];
+        int numOff = static_cast<int>(riders.size()) - firstOnBoard[floor];
+        goneUpTo[floor] = riders.back().id;
+        riders.clear();
+        firstOnBoard[floor] = 0;
+        destBits[floor / 64] &= ~(uint64_t(1) << (floor % 64));
+        load -= numOff;
+        CompactLogIfSparse();
+        return numOff;
+    }
+    // The rider to floor who boarded first gets off; false if there is none
+    bool UnloadOne(int floor) {
+        if (!HasRidersFor(floor)) {
+            return false;
+        }
+        // The riders who left stay at the front until the floor empties or they are half of it
+        std::vector<ECCarRider> &riders = ridersTo[floor];
+        int &first = firstOnBoard[floor];
+        goneUpTo[floor] = riders[first++].id;
+        if (first == static_cast<int>(riders.size())) {
+            riders.clear();
+            first = 0;
+            destBits[floor / 64] &= ~(uint64_t(1) << (floor % 64));
+        } else if (2 * first >= static_cast<int>(riders.size())) {
+            riders.erase(riders.begin(), riders.begin() + first);
+            first = 0;
+        }
+        load--;
+        CompactLogIfSparse();
+        return true;
+    }
+    void Clear() {
+        for (size_t floor = 0; floor < ridersTo.size(); ++floor) {
+            ridersTo[floor].clear();
+            firstOnBoard[floor] = 0;
+            goneUpTo[floor] = nextRiderId - 1;
+        }
+        for (size_t i = 0; i < destBits.size(); ++i) {
+            destBits[i] = 0;
+        }
+        boardingLog.clear();
+        load = 0;
+    }
+
+    bool HasRidersFor(int floor) const {
+        return floor >= 0 && floor < static_cast<int>(ridersTo.size()) && ((destBits[floor / 64] >> (floor % 64)) & 1);
+    }
+    int GetCountFor(int floor) const { return HasRidersFor(floor) ? static_cast<int>(ridersTo[floor].size()) - firstOnBoard[floor] : 0; }
+    ECCarRiderRange GetRidersFor(int floor) const {   // in boarding order
+        const std::vector<ECCarRider> &riders = ridersTo[floor];
+        ECCarRiderRange range = { riders.data() + firstOnBoard[floor], riders.data() + riders.size() };
+        return range;
+    }
+    int GetLoad() const { return load; }
+    bool IsEmpty() const { return load == 0; }
+    int GetNextRiderId() const { return nextRiderId; }
+    int GetFirstDestination() const { return IsEmpty() ? 0 : *begin(); }   // of the rider who boarded first
+
+    Iterator begin() const { return Iterator(boardingLog.data(), boardingLog.data() + boardingLog.size(), goneUpTo.data()); }
+    Iterator end() const { return Iterator(boardingLog.data() + boardingLog.size(), boardingLog.data() + boardingLog.size(), goneUpTo.data()); }
+
+private:
+    void Resize(int numFloors) {
+        ridersTo.resize(numFloors + 1);
+        firstOnBoard.resize(numFloors + 1, 0);
+        goneUpTo.resize(numFloors + 1, nextRiderId - 1);
+        destBits.resize(numFloors / 64 + 1, 0);
+    }
+    // In place, so a steady load never allocates
+    void CompactLogIfSparse() {
+        if (boardingLog.size() <= 2 * static_cast<size_t>(load) + 32) {
+            return;
+        }
+        size_t numKept = 0;
+        for (size_t i = 0; i < boardingLog.size(); ++i) {
+            if (boardingLog[i].id > goneUpTo[boardingLog[i].floorDest]) {
+                boardingLog[numKept++] = boardingLog[i];
+            }
+        }
+        boardingLog.resize(numKept);
+    }
+
+    std::vector<std::vector<ECCarRider> > ridersTo;   // indexed by destination floor; entry 0 unused
+    std::vector<int> firstOnBoard;                     // per floor: riders before this index have left
+    std::vector<uint64_t> destBits;                    // bit f: someone rides to floor f
+    std::vector<int> goneUpTo;                         // per floor: riders with this id or lower have left
+    std::vector<LogEntry> boardingLog;                 // boarding order, including riders who have left
+    int load;
+    int nextRiderId;
+};
+
+#endif /* ECCARLOAD_H */
@@ -0,0 +1,84 @@
+#include "ECCheckpoint.h"
+#include "ECElevatorSim1.h"
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+
+ECCheckpointWriter::ECCheckpointWriter(const std::string &pathIn)
+    : path(pathIn), pendingOffset(0), fStopping(false), numWritten(0), numSkipped(0) {
+    thread = std::thread(&ECCheckpointWriter::Run, this);
+}
+
+ECCheckpointWriter::~ECCheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fStopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+}
+
+void ECCheckpointWriter::Submit(std::shared_ptr<const ECElevatorSim> snapshot, long long outputOffset) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending) {
+            numSkipped++;
+        }
+        pending = snapshot;
+        pendingOffset = outputOffset;
+    }
+    wakeUp.notify_one();
+}
+
+void ECCheckpointWriter::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait(lock, [this] { return pending || fStopping; });
+        if (!pending) {
+            return;   // stopping with nothing left to write
+        }
+        std::shared_ptr<const ECElevatorSim> snapshot = pending;
+        long long outputOffset = pendingOffset;
+        pending.reset();
+        lock.unlock();
+
+        std::ostringstream data;
+        snapshot->SaveState(data, outputOffset);
+        if (WriteAtomically(data.str())) {
+            numWritten++;
+        }
+
+        lock.lock();
+    }
+}
+
+bool ECCheckpointWriter::WriteAtomically(const std::string &data) const {
+    std::string tempPath = path + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Error: Could not open checkpoint " << tempPath << " for writing." << std::endl;
+        return false;
+    }
+    bool fOk = fwrite(data.data(), 1, data.size(), file) == data.size() && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fOk = (fclose(file) == 0) && fOk;
+    if (!fOk || rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not write checkpoint " << path << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    // The rename only survives a crash once the directory holding it is on disk too
+    size_t slash = path.rfind('/');
+    std::string dirPath = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fdDir = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY);
+    fOk = fdDir >= 0 && fsync(fdDir) == 0;
+    if (fdDir >= 0) {
+        fOk = (close(fdDir) == 0) && fOk;
+    }
+    if (!fOk) {
+        std::cerr << "Error: Could not sync directory " << dirPath << " for checkpoint " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef ECCHECKPOINT_H
+#define ECCHECKPOINT_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class ECElevatorSim;
+
+//*****************************************************************************
+// Writes simulator checkpoints on a background thread. The tick loop hands over
+// a copy of the simulator and goes on; this thread serializes the copy, writes
+// it to <path>.tmp, syncs it to disk, renames it over <path> and syncs the
+// directory so the rename is on disk too. A crash at any point leaves either
+// the previous checkpoint or the new one, never a torn file.
+//
+// If the disk falls behind, a snapshot still waiting is replaced by the newer one.
+class ECCheckpointWriter
+{
+public:
+    explicit ECCheckpointWriter(const std::string &pathIn);
+    ~ECCheckpointWriter();   // writes whatever is still waiting, then stops
+
+    // outputOffset is the length of the trace file when the snapshot was taken
+    void Submit(std::shared_ptr<const ECElevatorSim> snapshot, long long outputOffset);
+
+    const std::string &GetPath() const { return path; }
+    int GetNumWritten() const { return numWritten.load(); }
+    int GetNumSkipped() const { return numSkipped.load(); }   // replaced before they were written
+
+private:
+    void Run();
+    bool WriteAtomically(const std::string &data) const;
+
+    std::string path;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::shared_ptr<const ECElevatorSim> pending;   // guarded by mutex
+    long long pendingOffset;
+    bool fStopping;
+    std::atomic<int> numWritten;
+    std::atomic<int> numSkipped;
+};
+
+#endif /* ECCHECKPOINT_H */
@@ -0,0 +1,113 @@
+#include "ECDemandForecast.h"
+#include <cmath>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+const double DAY_SMOOTHING = 0.3;   // weight of the latest day in a bucket's EWMA
+}
+
+ECDemandForecast::ECDemandForecast(int numFloorsIn, int bucketTicksIn, int numBucketsIn, double halfLifeTicksIn)
+    : numFloors(numFloorsIn > 0 ? numFloorsIn : 0), bucketTicks(bucketTicksIn > 0 ? bucketTicksIn : 1),
+      numBuckets(numBucketsIn > 0 ? numBucketsIn : 1), halfLifeTicks(halfLifeTicksIn > 0 ? halfLifeTicksIn : 1), numCalls(0) {
+    RecentCell emptyRecent = { 0.0f, 0 };
+    BucketCell emptyBucket = { 0.0f, 0, -1, 0 };
+    recent.assign(numFloors * 2, emptyRecent);
+    buckets.assign(numFloors * 2 * numBuckets, emptyBucket);
+}
+
+void ECDemandForecast::RollDay(BucketCell &cell, int day) {
+    if (cell.day == day) {
+        return;
+    }
+    if (cell.day >= 0) {
+        // Fold the finished day in, then a zero for every day the bucket saw no call
+        cell.smoothed = cell.daysSeen == 0 ? static_cast<float>(cell.count)
+                                           : static_cast<float>((1 - DAY_SMOOTHING) * cell.smoothed + DAY_SMOOTHING * cell.count);
+        int numEmptyDays = day - cell.day - 1;
+        cell.smoothed = static_cast<float>(cell.smoothed * pow(1 - DAY_SMOOTHING, numEmptyDays));
+        cell.daysSeen += 1 + numEmptyDays;
+    }
+    cell.count = 0;
+    cell.day = day;
+}
+
+void ECDemandForecast::RecordCall(int time, int floorSrc, int floorDest) {
+    if (floorSrc < 1 || floorSrc > numFloors) {
+        return;
+    }
+    int index = Index(floorSrc, floorDest > floorSrc ? 1 : -1);
+    RecentCell &cell = recent[index];
+    if (time > cell.lastTime) {
+        cell.level = static_cast<float>(cell.level * exp2(-(time - cell.lastTime) / halfLifeTicks));
+        cell.lastTime = time;
+    }
+    cell.level += 1.0f;
+
+    BucketCell &bucket = buckets[index * numBuckets + GetBucket(time)];
+    RollDay(bucket, GetDay(time));
+    bucket.count++;
+    numCalls++;
+}
+
+double ECDemandForecast::GetExpected(int time, int floor, int direction) const {
+    if (floor < 1 || floor > numFloors) {
+        return 0.0;
+    }
+    int index = Index(floor, direction);
+    const RecentCell &cell = recent[index];
+    double meanLife = halfLifeTicks / log(2.0);
+    double recentRate = cell.level * exp2(-std::max(time - cell.lastTime, 0) / halfLifeTicks) / meanLife;
+
+    BucketCell bucket = buckets[index * numBuckets + GetBucket(time)];
+    RollDay(bucket, GetDay(time));
+    if (bucket.daysSeen == 0) {
+        return recentRate;
+    }
+    return 0.5 * (recentRate + bucket.smoothed / bucketTicks);
+}
+
+int ECDemandForecast::GetBusiestFloor(int time, int nearFloor) const {
+    int bestFloor = 0;
+    double best = 0.0;
+    for (int floor = 1; floor <= numFloors; ++floor) {
+        double expected = GetExpected(time, floor);
+        if (expected > best || (expected == best && bestFloor != 0 && abs(floor - nearFloor) < abs(bestFloor - nearFloor))) {
+            best = expected;
+            bestFloor = floor;
+        }
+    }
+    return best > 0.0 ? bestFloor : 0;
+}
+
+void ECDemandForecast::SaveState(std::ostream &out) const {
+    out << "forecast " << numFloors << " " << bucketTicks << " " << numBuckets << " " << halfLifeTicks << " " << numCalls << "\n";
+    for (const RecentCell &cell : recent) {
+        out << cell.level << " " << cell.lastTime << " ";
+    }
+    out << "\n";
+    for (const BucketCell &cell : buckets) {
+        out << cell.smoothed << " " << cell.count << " " << cell.day << " " << cell.daysSeen << " ";
+    }
+    out << "\n";
+}
+
+bool ECDemandForecast::LoadState(std::istream &in) {
+    std::string tag;
+    int floors = 0, ticks = 0, numBucketsIn = 0;
+    double halfLife = 0;
+    long long calls = 0;
+    if (!(in >> tag >> floors >> ticks >> numBucketsIn >> halfLife >> calls) || tag != "forecast") {
+        return false;
+    }
+    *this = ECDemandForecast(floors, ticks, numBucketsIn, halfLife);
+    numCalls = calls;
+    for (RecentCell &cell : recent) {
+        in >> cell.level >> cell.lastTime;
+    }
+    for (BucketCell &cell : buckets) {
+        in >> cell.smoothed >> cell.count >> cell.day >> cell.daysSeen;
+    }
+    return static_cast<bool>(in);
+}
@@ -0,0 +1,70 @@
+#ifndef ECDEMANDFORECAST_H
+#define ECDEMANDFORECAST_H
+
+#include <vector>
+#include <iostream>
+
+//*****************************************************************************
+// Online estimate of where hall calls will come from, for parking an idle car.
+// Two estimates are kept per floor and direction, both updated in O(1) when a
+// call is made:
+//
+//   recent    a call count that decays with a half-life of halfLifeTicks,
+//             updated lazily; divided by the mean life it is a call rate
+//   by time   a call count per time-of-day bucket (bucketTicks long, numBuckets
+//   of day    to a day), smoothed across days with an EWMA, so a building that
+//             fills every morning is expected to fill again
+//
+// Memory is fixed at numFloors x 2 x (numBuckets + 1) cells whatever the
+// traffic; with a key space this small an exact table costs no more than a
+// count-min sketch would. Until a bucket has seen a whole day the recent
+// estimate is used alone.
+class ECDemandForecast
+{
+public:
+    ECDemandForecast(int numFloorsIn = 0, int bucketTicksIn = 300, int numBucketsIn = 12, double halfLifeTicksIn = 300);
+
+    void RecordCall(int time, int floorSrc, int floorDest);
+
+    // Calls a tick expected at floor in the bucket holding time; direction 1 up, -1 down
+    double GetExpected(int time, int floor, int direction) const;
+    double GetExpected(int time, int floor) const { return GetExpected(time, floor, 1) + GetExpected(time, floor, -1); }
+    // Floor with the most expected calls (the nearest to nearFloor on a tie); 0 before any call
+    int GetBusiestFloor(int time, int nearFloor) const;
+
+    int GetNumFloors() const { return numFloors; }
+    long long GetNumCalls() const { return numCalls; }
+
+    // Exact copy as text, for checkpoints
+    void SaveState(std::ostream &out) const;
+    bool LoadState(std::istream &in);
+
+private:
+    struct RecentCell
+    {
+        float level;      // decayed count as of lastTime
+        int lastTime;
+    };
+    struct BucketCell
+    {
+        float smoothed;   // EWMA of the calls this bucket saw on past days
+        int count;        // calls in the bucket so far on day
+        int day;          // -1 until the first call
+        int daysSeen;     // past days folded into smoothed
+    };
+
+    int Index(int floor, int direction) const { return (floor - 1) * 2 + (direction > 0 ? 0 : 1); }
+    int GetDay(int time) const { return time / (bucketTicks * numBuckets); }
+    int GetBucket(int time) const { return (time / bucketTicks) % numBuckets; }
+    static void RollDay(BucketCell &cell, int day);
+
+    int numFloors;
+    int bucketTicks;
+    int numBuckets;
+    double halfLifeTicks;
+    long long numCalls;
+    std::vector<RecentCell> recent;    // per floor and direction
+    std::vector<BucketCell> buckets;   // per floor, direction and bucket
+};
+
+#endif /* ECDEMANDFORECAST_H */
@@ -1,173 +1,658 @@
 #include "ECElevatorSim1.h"
+#include "ECLiveRequestSource.h"
+#include "ECSimProfiler.h"
+#include "ECTraceEvents.h"
+#include "ECTelemetry.h"
+#include "ECCheckpoint.h"
 #include <map>
 #include <cmath>
+#include <climits>
 #include <fstream>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/stat.h>
 
 
+namespace {
+bool RequestMadeEarlier(const ECElevatorSimRequest &lhs, const ECElevatorSimRequest &rhs) {
+    return lhs.GetTime() < rhs.GetTime();
+}
+
+std::shared_ptr<const std::vector<ECElevatorSimRequest> > MakeSchedule(const std::vector<ECElevatorSimRequest> &requestsList) {
+    std::shared_ptr<std::vector<ECElevatorSimRequest> > schedule = std::make_shared<std::vector<ECElevatorSimRequest> >(requestsList);
+    std::stable_sort(schedule->begin(), schedule->end(), RequestMadeEarlier);
+    return schedule;
+}
+
+// FNV-1a over the schedule, so a checkpoint is never resumed against different input
+unsigned long long HashSchedule(const std::vector<ECElevatorSimRequest> &schedule) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < schedule.size(); ++i) {
+        int fields[] = { schedule[i].GetTime(), schedule[i].GetFloorSrc(), schedule[i].GetFloorDest() };
+        for (int j = 0; j < 3; ++j) {
+            hash = (hash ^ static_cast<unsigned int>(fields[j])) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+const int CHECKPOINT_VERSION = 3;
+}
+
 ECElevatorSim::ECElevatorSim(int totalFloors, std::vector<ECElevatorSimRequest> &requestsList)
-    : floorCount(totalFloors), currentFloor(1), currentDirection(EC_ELEVATOR_STOPPED), pendingRequests(requestsList),
-      currentTime(0), numberOfRiders(0) {
+    : ECElevatorSim(totalFloors, MakeSchedule(requestsList)) {}
+
+ECElevatorSim::ECElevatorSim(int totalFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule)
+    : floorCount(totalFloors), simulationDuration(0), currentFloor(1), currentDirection(EC_ELEVATOR_STOPPED), currentTime(0),
+      numberOfRiders(0), fVerbose(false), totalBoardings(0), totalAlightings(0), totalMoves(0), totalRequests(0),
+      requestSchedule(schedule), nextRequestIndex(0), liveSource(NULL), liveTickMillis(0), stopFlag(NULL), telemetry(NULL), digest(NULL), trips(NULL),
+      fParking(false), parkingFloor(0), checkpointEveryTicks(0), resumeOutputOffset(-1) {
+    activeFloorRequests = ECFloorSet(floorCount);
+    carLoad = ECCarLoad(floorCount);
     waitingPassengers.resize(floorCount, 0);
     waitingDirections.resize(floorCount, 0);
 }
 
 ECElevatorSim::~ECElevatorSim() {}
 
+std::shared_ptr<ECElevatorSim> ECElevatorSim::Fork() const {
+    std::shared_ptr<ECElevatorSim> fork = std::make_shared<ECElevatorSim>(*this);
+    fork->liveSource = NULL;
+    fork->telemetry = NULL;
+    fork->digest = NULL;
+    fork->trips = NULL;
+    fork->rollups.reset();
+    fork->checkpointWriter.reset();
+    return fork;
+}
+
+// Like a fork, but keeping a private copy of the rollups
+std::shared_ptr<ECElevatorSim> ECElevatorSim::TakeSnapshot() const {
+    std::shared_ptr<ECElevatorSim> snapshot = Fork();
+    if (rollups) {
+        snapshot->rollups = std::make_shared<ECTimeRollup>(*rollups);
+    }
+    return snapshot;
+}
+
 void ECElevatorSim::Simulate(int simulationDuration, const std::string& outputFilename) {
-    std::ofstream outFile(outputFilename);  // Open the output file to write simulation results
+    EC_TRACE_SCOPE("ECElevatorSim::Simulate");
+
+    std::ofstream outFile;
+    int startTime = 0;
+    bool fResuming = resumeOutputOffset >= 0;
+    if (fResuming) {
+        // Drop whatever the broken run wrote after the checkpoint, then carry on from it
+        struct stat st;
+        if (stat(outputFilename.c_str(), &st) != 0 || st.st_size < resumeOutputOffset ||
+            truncate(outputFilename.c_str(), resumeOutputOffset) != 0) {
+            std::cerr << "Error: Could not cut " << outputFilename << " back to the checkpoint." << std::endl;
+            return;
+        }
+        outFile.open(outputFilename, std::ios::app);
+        startTime = currentTime;
+        resumeOutputOffset = -1;
+    } else {
+        outFile.open(outputFilename);  // Open the output file to write simulation results
+    }
     if (!outFile.is_open()) {
         std::cerr << "Error: Could not open file " << outputFilename << " for writing." << std::endl;
         return;
     }
 
     // Write the number of floors and total simulation time as the first line in the file
-    outFile << floorCount << " " << simulationDuration << "\n";  
-
-    for (currentTime = 0; currentTime < simulationDuration; ++currentTime) {
-        std::cout << "---- Time Step: " << currentTime << " ----" << std::endl;
+    if (!fResuming) {
+        outFile << floorCount << " " << simulationDuration << "\n";
+    }
 
-        // Display current elevator state to console
-        std::cout << "Current Floor: " << currentFloor 
-                  << ", Direction: " << GetDirectionString(currentDirection) 
-                  << ", Active Requests: ";
-        for (const auto &floor : activeFloorRequests) std::cout << floor << " ";
-        std::cout << std::endl;
+    auto nextTickDeadline = std::chrono::steady_clock::now();
 
-        // Write the current state to the output file
-        outFile << "Time Step: " << currentTime << "\n";
-        outFile << "Floor: " << currentFloor << ", Direction: " << GetDirectionString(currentDirection) << "\n";
-        outFile << "Passengers In Elevator: ";
-        for (int dest : elevatorPassengers) {
-            outFile << dest << " ";
+    for (currentTime = startTime; currentTime < simulationDuration; ++currentTime) {
+        // In live mode each tick lasts liveTickMillis of wall-clock time
+        if (liveSource != NULL) {
+            std::this_thread::sleep_until(nextTickDeadline);
+            nextTickDeadline += std::chrono::milliseconds(liveTickMillis);
         }
-        outFile << "\n";
-        outFile << "Waiting Passengers: ";
-        for (int numWaiting : waitingPassengers) {
-            outFile << numWaiting << " ";
+        if (stopFlag != NULL && *stopFlag) {
+            if (fVerbose) std::cout << "Simulation stopped at Time Step: " << currentTime << std::endl;
+            outFile << "Simulation stopped at Time Step: " << currentTime << "\n";
+            break;
         }
-        outFile << "\n";
-        outFile << "--\n";  // Use "--" to indicate the end of a time step
 
-        // Process new requests and handle passengers
-        ProcessIncomingRequests(currentTime);
-        HandlePassengers(currentTime);
+        if (fVerbose) {
+            std::cout << "---- Time Step: " << currentTime << " ----" << std::endl;
 
-        // Update elevator's movement direction and move
-        UpdateDirection();
-        ExecuteMove(currentTime);
+            // Display current elevator state to console
+            std::cout << "Current Floor: " << currentFloor 
+                      << ", Direction: " << GetDirectionString(currentDirection) 
+                      << ", Active Requests: ";
+            for (const auto &floor : activeFloorRequests) std::cout << floor << " ";
+            std::cout << std::endl;
+        }
+
+        // Write the current state to the output file
+        WriteTraceStep(outFile);
+
+        RunTick(currentTime);
 
         // Early exit check - If all requests have been handled, end the simulation early
-        if (pendingRequests.empty() && activeFloorRequests.empty()) {
-            std::cout << "All requests have been processed. Ending simulation early at Time Step: " << currentTime << std::endl;
+        if (AllRequestsHandled()) {
+            if (fVerbose) std::cout << "All requests have been processed. Ending simulation early at Time Step: " << currentTime << std::endl;
             outFile << "All requests have been processed. Ending simulation early at Time Step: " << currentTime << "\n";
             break;
         }
 
-        std::cout << "End of Time Step: " << currentTime << std::endl;
+        if (fVerbose) std::cout << "End of Time Step: " << currentTime << std::endl;
         outFile << "End of Time Step: " << currentTime << "\n";
+
+        if (checkpointWriter && (currentTime + 1) % checkpointEveryTicks == 0) {
+            // Everything up to here must be on disk before a checkpoint can point past it
+            outFile.flush();
+            std::shared_ptr<ECElevatorSim> snapshot = TakeSnapshot();
+            snapshot->currentTime = currentTime + 1;   // resume with the next tick
+            checkpointWriter->Submit(snapshot, static_cast<long long>(outFile.tellp()));
+        }
     }
 
     outFile.close();  // Close the output file
+
+    if (rollups) {
+        rollups->Flush();
+        rollups->Write(outputFilename + ".rollup");
+    }
 }
 
+void ECElevatorSim::EnableCheckpoints(const std::string &path, int everyTicks) {
+    checkpointWriter = std::make_shared<ECCheckpointWriter>(path);
+    checkpointEveryTicks = everyTicks > 0 ? everyTicks : 1;
+}
 
-void ECElevatorSim::ProcessIncomingRequests(int time) {
-    for (auto &request : pendingRequests) {
-        if (request.GetTime() == time && !request.IsServiced()) {
-            activeFloorRequests.insert(request.GetFloorSrc());
-            waitingPassengers[request.GetFloorSrc() - 1]++;
-            waitingDirections[request.GetFloorSrc() - 1] = (request.GetFloorDest() > request.GetFloorSrc()) ? 1 : -1;
-            std::cout << "New Request: Floor " << request.GetFloorSrc() << " at Time " << time << std::endl;
+bool ECElevatorSim::ResumeFromCheckpoint(const std::string &path) {
+    std::ifstream inFile(path);
+    if (!inFile.is_open()) {
+        std::cerr << "Error: Could not open checkpoint " << path << std::endl;
+        return false;
+    }
+    long long outputOffset = 0;
+    if (!LoadState(inFile, outputOffset)) {
+        std::cerr << "Error: " << path << " is not a checkpoint of this input." << std::endl;
+        return false;
+    }
+    resumeOutputOffset = outputOffset;
+    return true;
+}
+
+//*****************************************************************************
+// Checkpoint format: a versioned text file of tagged lines, in this order
+
+void ECElevatorSim::SaveState(std::ostream &out, long long outputOffset) const {
+    out.precision(9);   // enough for floats to come back exactly
+    out << "ECCHECKPOINT " << CHECKPOINT_VERSION << "\n";
+    out << "floors " << floorCount << "\n";
+    out << "schedule " << requestSchedule->size() << " " << HashSchedule(*requestSchedule) << "\n";
+    out << "time " << currentTime << "\n";
+    out << "cursor " << nextRequestIndex << "\n";
+    out << "output " << outputOffset << "\n";
+    out << "car " << currentFloor << " " << currentDirection << " " << numberOfRiders << "\n";
+    out << "totals " << totalBoardings << " " << totalAlightings << " " << totalMoves << " " << totalRequests << "\n";
+
+    out << "pending " << pendingRequests.size() << "\n";
+    for (const ECElevatorSimRequest &request : pendingRequests) {
+        out << request.GetTime() << " " << request.GetFloorSrc() << " " << request.GetFloorDest() << " "
+            << request.IsFloorRequestDone() << " " << request.IsServiced() << " " << request.GetArriveTime() << "\n";
+    }
+    out << "active " << activeFloorRequests.GetSize();
+    for (int floor : activeFloorRequests) {
+        out << " " << floor;
+    }
+    std::vector<ECCarRider> riders;
+    for (int floor = 1; floor <= floorCount; ++floor) {
+        riders.insert(riders.end(), carLoad.GetRidersFor(floor).begin(), carLoad.GetRidersFor(floor).end());
+    }
+    std::sort(riders.begin(), riders.end(), [](const ECCarRider &lhs, const ECCarRider &rhs) { return lhs.id < rhs.id; });
+    out << "\nriders " << riders.size() << " " << carLoad.GetNextRiderId();
+    for (const ECCarRider &rider : riders) {
+        out << " " << rider.id << " " << rider.floorSrc << " " << rider.floorDest << " " << rider.timeCall << " " << rider.timeBoard;
+    }
+    out << "\nwaiting";
+    for (int i = 0; i < floorCount; ++i) {
+        out << " " << waitingPassengers[i] << " " << waitingDirections[i];
+    }
+    out << "\nwaits ";
+    waitTimes.Save(out);
+
+    out << "rollups " << (rollups ? 1 : 0) << "\n";
+    if (rollups) {
+        rollups->SaveState(out);
+    }
+    out << "parking " << (fParking ? 1 : 0) << "\n";
+    if (fParking) {
+        demand.SaveState(out);
+    }
+    out << "end\n";
+}
+
+bool ECElevatorSim::LoadState(std::istream &in, long long &outputOffset) {
+    std::string tag;
+    int version = 0;
+    int floors = 0;
+    size_t scheduleSize = 0;
+    unsigned long long scheduleHash = 0;
+    if (!(in >> tag >> version) || tag != "ECCHECKPOINT" || version != CHECKPOINT_VERSION) {
+        return false;
+    }
+    if (!(in >> tag >> floors) || floors != floorCount) {
+        return false;
+    }
+    if (!(in >> tag >> scheduleSize >> scheduleHash) || scheduleSize != requestSchedule->size() ||
+        scheduleHash != HashSchedule(*requestSchedule)) {
+        return false;
+    }
+
+    int direction = 0;
+    in >> tag >> currentTime;
+    in >> tag >> nextRequestIndex;
+    in >> tag >> outputOffset;
+    in >> tag >> currentFloor >> direction >> numberOfRiders;
+    currentDirection = static_cast<EC_ELEVATOR_DIR>(direction);
+    in >> tag >> totalBoardings >> totalAlightings >> totalMoves >> totalRequests;
+
+    size_t numPending = 0;
+    in >> tag >> numPending;
+    pendingRequests.clear();
+    for (size_t i = 0; i < numPending && in; ++i) {
+        int time = 0, floorSrc = 0, floorDest = 0, arriveTime = 0;
+        bool fDone = false, fServiced = false;
+        in >> time >> floorSrc >> floorDest >> fDone >> fServiced >> arriveTime;
+        pendingRequests.push_back(ECElevatorSimRequest(time, floorSrc, floorDest));
+        pendingRequests.back().SetFloorRequestDone(fDone);
+        pendingRequests.back().SetServiced(fServiced);
+        pendingRequests.back().SetArriveTime(arriveTime);
+    }
+
+    int count = 0;
+    in >> tag >> count;
+    activeFloorRequests = ECFloorSet(floorCount);
+    for (int i = 0; i < count && in; ++i) {
+        int floor = 0;
+        in >> floor;
+        activeFloorRequests.Insert(floor);
+    }
+    int nextRiderId = 0;
+    in >> tag >> count >> nextRiderId;
+    carLoad = ECCarLoad(floorCount);
+    for (int i = 0; i < count && in; ++i) {
+        ECCarRider rider;
+        in >> rider.id >> rider.floorSrc >> rider.floorDest >> rider.timeCall >> rider.timeBoard;
+        carLoad.Board(rider);   // saved in boarding order
+    }
+    carLoad.ReserveRiderIds(nextRiderId);
+    in >> tag;
+    for (int i = 0; i < floorCount; ++i) {
+        in >> waitingPassengers[i] >> waitingDirections[i];
+    }
+    in >> tag;
+    if (!in || !waitTimes.Load(in)) {
+        return false;
+    }
+
+    int fHasRollups = 0;
+    in >> tag >> fHasRollups;
+    rollups.reset();
+    if (fHasRollups) {
+        rollups = std::make_shared<ECTimeRollup>();
+        if (!rollups->LoadState(in)) {
+            return false;
+        }
+    }
+
+    int fHasParking = 0;
+    in >> tag >> fHasParking;
+    fParking = fHasParking != 0;
+    parkingFloor = 0;
+    demand = ECDemandForecast();
+    if (fParking && (!demand.LoadState(in) || demand.GetNumFloors() != floorCount)) {
+        return false;
+    }
+    return (in >> tag) && tag == "end";
+}
+
+void ECElevatorSim::EnableRollups() {
+    rollups = std::make_shared<ECTimeRollup>(floorCount);
+    rollups->AddStandardLevels();
+}
+
+void ECElevatorSim::EnableIdleParking(int bucketTicks, int numBuckets, double halfLifeTicks) {
+    fParking = true;
+    demand = ECDemandForecast(floorCount, bucketTicks, numBuckets, halfLifeTicks);
+}
+
+//*****************************************************************************
+// Stepping API: advances this instance's own clock, never writes to the console
+// unless verbose output was requested
+
+ECElevatorStepResult ECElevatorSim::StepN(int numSteps) {
+    ECElevatorStepResult result;
+    long long boardingsBefore = totalBoardings;
+    long long alightingsBefore = totalAlightings;
+    long long movesBefore = totalMoves;
+
+    for (int i = 0; i < numSteps && !AllRequestsHandled(); ++i) {
+        RunTick(currentTime);
+        ++currentTime;
+        ++result.ticksRun;
+    }
+
+    result.timeNow = currentTime;
+    result.boardings = static_cast<int>(totalBoardings - boardingsBefore);
+    result.alightings = static_cast<int>(totalAlightings - alightingsBefore);
+    result.moves = static_cast<int>(totalMoves - movesBefore);
+    result.fComplete = AllRequestsHandled();
+    return result;
+}
+
+ECElevatorStepResult ECElevatorSim::RunUntil(int time) {
+    return StepN(time > currentTime ? time - currentTime : 0);
+}
+
+void ECElevatorSim::RunTick(int time) {
+    EC_TRACE_SCOPE("ECElevatorSim::RunTick");
+
+    if (rollups) {
+        rollups->BeginTick(time);
+    }
+
+    // Process new requests and handle passengers
+    {
+        EC_PROFILE_PHASE(EC_PHASE_INCOMING);
+        EC_TRACE_SCOPE("ECElevatorSim::ProcessIncomingRequests");
+        PullLiveRequests(time);
+        ProcessIncomingRequests(time);
+    }
+    {
+        EC_PROFILE_PHASE(EC_PHASE_PASSENGERS);
+        EC_TRACE_SCOPE("ECElevatorSim::HandlePassengers");
+        HandlePassengers(time);
+    }
+
+    // Update elevator's movement direction and move
+    {
+        EC_PROFILE_PHASE(EC_PHASE_DIRECTION);
+        EC_TRACE_SCOPE("ECElevatorSim::UpdateDirection");
+        UpdateDirection();
+    }
+    {
+        EC_PROFILE_PHASE(EC_PHASE_MOVE);
+        EC_TRACE_SCOPE("ECElevatorSim::ExecuteMove");
+        ExecuteMove(time);
+    }
+
+    if (rollups) {
+        rollups->EndTick(waitingPassengers);
+    }
+    if (telemetry != NULL) {
+        PublishTelemetry();
+    }
+    if (digest != NULL) {
+        FillState(digestState);
+        digestState.time = time + 1;
+        digest->Record(digestState);
+    }
+}
+
+void ECElevatorSim::AttachDigest(ECDigestWriter *writer) {
+    digest = writer;
+    digestState.Resize(floorCount);
+}
+
+void ECElevatorSim::FillState(ECEngineState &state) const {
+    if (state.numFloors != floorCount) {
+        state.Resize(floorCount);
+    }
+    state.time = currentTime;
+    state.currentFloor = currentFloor;
+    state.direction = currentDirection;
+    state.requests = totalRequests;
+    state.boardings = totalBoardings;
+    state.alightings = totalAlightings;
+    state.moves = totalMoves;
+    state.waitTicksSum = waitTimes.GetSum();
+    for (int floor = 1; floor <= floorCount; ++floor) {
+        state.waiting[floor] = waitingPassengers[floor - 1];
+        state.ridersTo[floor] = carLoad.GetCountFor(floor);
+        state.stopRequested[floor] = activeFloorRequests.Contains(floor);
+    }
+}
+
+void ECElevatorSim::DumpState(std::ostream &out) const {
+    ECEngineState state;
+    FillState(state);
+    state.Dump(out);
+}
+
+void ECElevatorSim::PublishTelemetry() {
+    // Percentiles are worked out first, to keep the readers' retry window short
+    int waitP50 = waitTimes.GetPercentile(0.50);
+    int waitP90 = waitTimes.GetPercentile(0.90);
+    int waitP99 = waitTimes.GetPercentile(0.99);
+    int numFloors = std::min(floorCount, EC_TELEMETRY_MAX_FLOORS);
+
+    ECTelemetrySnapshot &snapshot = telemetry->BeginUpdate();
+    snapshot.time = currentTime;
+    snapshot.numFloors = numFloors;
+    snapshot.currentFloor = currentFloor;
+    snapshot.direction = currentDirection;
+    snapshot.numRiders = numberOfRiders;
+    snapshot.requests = totalRequests;
+    snapshot.boardings = totalBoardings;
+    snapshot.alightings = totalAlightings;
+    snapshot.moves = totalMoves;
+    snapshot.waitP50 = waitP50;
+    snapshot.waitP90 = waitP90;
+    snapshot.waitP99 = waitP99;
+    snapshot.waitMax = waitTimes.GetMax();
+    std::copy(waitingPassengers.begin(), waitingPassengers.begin() + numFloors, snapshot.waitingPassengers);
+    telemetry->EndUpdate();
+}
+
+bool ECElevatorSim::AllRequestsHandled() const {
+    // In live mode more calls may arrive until the source has ended
+    return (liveSource == NULL || liveSource->HasEnded()) && nextRequestIndex == requestSchedule->size() &&
+           pendingRequests.empty() && activeFloorRequests.IsEmpty();
+}
+
+void ECElevatorSim::WriteTraceStep(std::ostream &outFile) const {
+    EC_PROFILE_PHASE(EC_PHASE_OUTPUT);
+    EC_TRACE_SCOPE("ECElevatorSim::WriteTraceStep");
+
+    outFile << "Time Step: " << currentTime << "\n";
+    outFile << "Floor: " << currentFloor << ", Direction: " << GetDirectionString(currentDirection) << "\n";
+    outFile << "Passengers In Elevator: ";
+    for (int dest : carLoad) {
+        outFile << dest << " ";
+    }
+    outFile << "\n";
+    outFile << "Waiting Passengers: ";
+    for (int numWaiting : waitingPassengers) {
+        outFile << numWaiting << " ";
+    }
+    outFile << "\n";
+    outFile << "--\n";  // Use "--" to indicate the end of a time step
+}
+
+void ECElevatorSim::AttachLiveSource(ECLiveRequestSource *source, int tickMillis) {
+    liveSource = source;
+    liveTickMillis = tickMillis > 0 ? tickMillis : 0;
+}
+
+void ECElevatorSim::PullLiveRequests(int time) {
+    if (liveSource == NULL) {
+        return;
+    }
+    liveSource->Poll();
+
+    // Activate every call that is due; late ones are stamped with this tick so they are not lost
+    ECLiveRequest live;
+    while (liveSource->PopDue(time, live)) {
+        if (live.floorSrc < 1 || live.floorSrc > floorCount || live.floorDest < 1 ||
+            live.floorDest > floorCount || live.floorSrc == live.floorDest) {
+            liveSource->RecordRejected();
+            continue;
         }
+        liveSource->RecordLag(time - live.time);
+        ActivateRequest(ECElevatorSimRequest(time, live.floorSrc, live.floorDest));
+        if (fVerbose) std::cout << "New Request: Floor " << live.floorSrc << " at Time " << time << std::endl;
+    }
+}
+
+
+void ECElevatorSim::ActivateRequest(const ECElevatorSimRequest &request) {
+    pendingRequests.push_back(request);
+    totalRequests++;
+    if (rollups) {
+        rollups->RecordCall(request.GetFloorSrc());
+    }
+    if (fParking) {
+        demand.RecordCall(request.GetTime(), request.GetFloorSrc(), request.GetFloorDest());
+    }
+    activeFloorRequests.Insert(request.GetFloorSrc());
+    waitingPassengers[request.GetFloorSrc() - 1]++;
+    waitingDirections[request.GetFloorSrc() - 1] = (request.GetFloorDest() > request.GetFloorSrc()) ? 1 : -1;
+}
+
+void ECElevatorSim::ProcessIncomingRequests(int time) {
+    // The schedule is sorted by time, so only requests made this tick need looking at
+    const std::vector<ECElevatorSimRequest> &schedule = *requestSchedule;
+    while (nextRequestIndex < schedule.size() && schedule[nextRequestIndex].GetTime() <= time) {
+        const ECElevatorSimRequest &request = schedule[nextRequestIndex++];
+        ActivateRequest(request);
+        if (fVerbose) std::cout << "New Request: Floor " << request.GetFloorSrc() << " at Time " << time << std::endl;
     }
 }
 
 void ECElevatorSim::HandlePassengers(int currentTime) {
-    std::cout << "Handling Passengers at Floor: " << currentFloor << std::endl;
+    if (fVerbose) {
+        std::cout << "Handling Passengers at Floor: " << currentFloor << std::endl;
 
-    // Debugging: Print out current state of passengers in the elevator before handling
-    std::cout << "Current passengers in elevator before handling: ";
-    for (const auto& dest : elevatorPassengers) {
-        std::cout << dest << " ";
+        // Debugging: Print out current state of passengers in the elevator before handling
+        std::cout << "Current passengers in elevator before handling: ";
+        for (int dest : carLoad) {
+            std::cout << dest << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    long long boardingsBefore = totalBoardings;
+    long long alightingsBefore = totalAlightings;
+
+    // Riders who boarded on an earlier tick all get off here at once; each one's
+    // pending request is closed below
+    if (trips != NULL) {
+        for (const ECCarRider &rider : carLoad.GetRidersFor(currentFloor)) {
+            trips->AddTrip(rider.timeCall, rider.floorSrc, rider.floorDest, rider.timeBoard, currentTime, 1);
+        }
     }
-    std::cout << std::endl;
+    carLoad.Unload(currentFloor);
 
-    auto it = pendingRequests.begin();
-    while (it != pendingRequests.end()) {
+    // Completed requests are dropped in the same pass, keeping the rest in order
+    size_t numKept = 0;
+    for (size_t i = 0; i < pendingRequests.size(); ++i) {
+        ECElevatorSimRequest *it = &pendingRequests[i];
         if (it->GetFloorSrc() == currentFloor && !it->IsFloorRequestDone()) {
             // Passenger boards, request is handled
             it->SetFloorRequestDone(true);
-            activeFloorRequests.insert(it->GetFloorDest());
+            activeFloorRequests.Insert(it->GetFloorDest());
             waitingPassengers[currentFloor - 1]--;
 
-            // Debugging: Log before adding to elevatorPassengers
-            std::cout << "Adding passenger to elevator with destination: " << it->GetFloorDest() << std::endl;
-
-            elevatorPassengers.push_back(it->GetFloorDest());
+            carLoad.Board(it->GetFloorDest(), currentFloor, it->GetTime(), currentTime);
             numberOfRiders++;
+            totalBoardings++;
+            waitTimes.Add(currentTime - it->GetTime());
+            if (rollups) {
+                rollups->RecordBoarding(currentFloor, currentTime - it->GetTime());
+            }
 
-            // Debugging: Verify passenger was added
-            std::cout << "Passenger Boarded at Floor: " << currentFloor
-                      << ", Destination: " << it->GetFloorDest() << std::endl;
-            std::cout << "Number of riders now: " << numberOfRiders << std::endl;
+            if (fVerbose) {
+                std::cout << "Passenger Boarded at Floor: " << currentFloor
+                          << ", Destination: " << it->GetFloorDest() << std::endl;
+                std::cout << "Number of riders now: " << numberOfRiders << std::endl;
+            }
 
         } else if (it->GetFloorDest() == currentFloor && it->IsFloorRequestDone()) {
             // Passenger arrives at destination
             it->SetServiced(true);
             it->SetArriveTime(currentTime);
-            std::cout << "Passenger Dropped at Floor: " << currentFloor
-                      << ", Arrival Time: " << currentTime << std::endl;
-
-            // Debugging: Log before removing from pendingRequests
-            std::cout << "Removing serviced request for destination floor: " << it->GetFloorDest() << std::endl;
 
-            it = pendingRequests.erase(it); // Remove completed requests
             numberOfRiders--;
+            totalAlightings++;
 
-            // Debugging: Verify the request was removed
-            std::cout << "Request for floor " << currentFloor << " completed. Number of riders now: " << numberOfRiders << std::endl;
+            if (fVerbose) {
+                std::cout << "Passenger Dropped at Floor: " << currentFloor
+                          << ", Arrival Time: " << currentTime << std::endl;
+                std::cout << "Request for floor " << currentFloor << " completed. Number of riders now: " << numberOfRiders << std::endl;
+            }
 
-            continue;  
+            continue;   // Remove completed requests
         }
 
-        ++it;
+        pendingRequests[numKept++] = *it;
     }
+    pendingRequests.erase(pendingRequests.begin() + numKept, pendingRequests.end());
+
+    activeFloorRequests.Erase(currentFloor); // Remove serviced floor
 
-    // Debugging: Print out current active floor requests after handling
-    std::cout << "Active floor requests after handling: ";
-    for (const auto& req : activeFloorRequests) {
-        std::cout << req << " ";
+    bool fStopped = totalBoardings != boardingsBefore || totalAlightings != alightingsBefore;
+    if (fStopped && rollups) {
+        rollups->RecordStop(currentFloor);
     }
-    std::cout << std::endl;
 
-    activeFloorRequests.erase(currentFloor); // Remove serviced floor
+    EC_PROFILE_COUNT(EC_COUNT_BOARDINGS, totalBoardings - boardingsBefore);
+    EC_PROFILE_COUNT(EC_COUNT_ALIGHTINGS, totalAlightings - alightingsBefore);
+    EC_PROFILE_COUNT(EC_COUNT_STOPS, fStopped ? 1 : 0);
 
-    // Debugging: Print out updated state of passengers in the elevator after handling
-    std::cout << "Current passengers in elevator after handling: ";
-    for (const auto& dest : elevatorPassengers) {
-        std::cout << dest << " ";
-    }
-    std::cout << std::endl;
+    if (fVerbose) {
+        // Debugging: Print out updated state of passengers in the elevator after handling
+        std::cout << "Current passengers in elevator after handling: ";
+        for (int dest : carLoad) {
+            std::cout << dest << " ";
+        }
+        std::cout << std::endl;
 
-    // Debugging: Check waiting passengers at each floor
-    std::cout << "Waiting passengers state: ";
-    for (int i = 0; i < waitingPassengers.size(); ++i) {
-        std::cout << "Floor " << (i + 1) << ": " << waitingPassengers[i] << " ";
+        // Debugging: Check waiting passengers at each floor
+        std::cout << "Waiting passengers state: ";
+        for (int i = 0; i < waitingPassengers.size(); ++i) {
+            std::cout << "Floor " << (i + 1) << ": " << waitingPassengers[i] << " ";
+        }
+        std::cout << std::endl;
     }
-    std::cout << std::endl;
 }
 
 void ECElevatorSim::UpdateDirection() {
-    std::cout << "Updating Direction. Current Floor: " << currentFloor
-              << ", Active Requests: ";
-    for (auto floor : activeFloorRequests) std::cout << floor << " ";
-    std::cout << std::endl;
+    if (fVerbose) {
+        std::cout << "Updating Direction. Current Floor: " << currentFloor
+                  << ", Active Requests: ";
+        for (auto floor : activeFloorRequests) std::cout << floor << " ";
+        std::cout << std::endl;
+    }
 
-    if (activeFloorRequests.empty()) {
+    if (activeFloorRequests.IsEmpty()) {
         currentDirection = EC_ELEVATOR_STOPPED;
+        if (fParking) {
+            int floor = demand.GetBusiestFloor(currentTime, currentFloor);
+            if (floor != 0 && floor != currentFloor) {
+                parkingFloor = floor;
+                currentDirection = floor > currentFloor ? EC_ELEVATOR_UP : EC_ELEVATOR_DOWN;
+                if (fVerbose) std::cout << "Parking at Floor: " << floor << std::endl;
+            }
+        }
         return;
     }
 
+#ifdef EC_SIM_PROFILE
+    EC_ELEVATOR_DIR previousDirection = currentDirection;
+#endif
+
     int nextFloor = SelectNextFloor();
     if (nextFloor > currentFloor) {
         currentDirection = EC_ELEVATOR_UP;
@@ -177,20 +662,30 @@ void ECElevatorSim::UpdateDirection() {
         currentDirection = EC_ELEVATOR_STOPPED;
     }
 
-    std::cout << "New Direction: " << GetDirectionString(currentDirection) << std::endl;
+    EC_PROFILE_COUNT(EC_COUNT_REVERSALS, (previousDirection != EC_ELEVATOR_STOPPED && currentDirection != EC_ELEVATOR_STOPPED &&
+                                          previousDirection != currentDirection) ? 1 : 0);
+
+    if (fVerbose) std::cout << "New Direction: " << GetDirectionString(currentDirection) << std::endl;
 }
 
 void ECElevatorSim::ExecuteMove(int timeStep) {
-    if (currentDirection == EC_ELEVATOR_UP) {
+    if (parkingFloor != 0) {
+        // Idle, so go straight to the parking floor
+        currentFloor = parkingFloor;
+        parkingFloor = 0;
+        totalMoves++;
+    } else if (currentDirection == EC_ELEVATOR_UP) {
         // Move directly to the next target floor
         int nextFloor = SelectNextFloor();
         currentFloor = nextFloor;
+        totalMoves++;
     } else if (currentDirection == EC_ELEVATOR_DOWN) {
         // Move directly to the next target floor
         int nextFloor = SelectNextFloor();
         currentFloor = nextFloor;
+        totalMoves++;
     }
-    std::cout << "Moving to Floor: " << currentFloor
+    if (fVerbose) std::cout << "Moving to Floor: " << currentFloor
               << ", Direction: " << GetDirectionString(currentDirection)
               << ", Time: " << timeStep << std::endl;
 }
@@ -226,7 +721,7 @@ int ECElevatorSim::SelectNextFloor() {
     return closestFloor;
 }
 
-std::string ECElevatorSim::GetDirectionString(EC_ELEVATOR_DIR direction) const {
+const char *ECElevatorSim::GetDirectionString(EC_ELEVATOR_DIR direction) const {
     switch (direction) {
         case EC_ELEVATOR_STOPPED: return "STOPPED";
         case EC_ELEVATOR_UP: return "UP";
@@ -237,47 +732,40 @@ std::string ECElevatorSim::GetDirectionString(EC_ELEVATOR_DIR direction) const {
 
 
 void ECElevatorSim::SimulateStep() {
-    static int currentTimeStep = 0;
-
-    std::cout << "---- Time Step: " << currentTimeStep << " ----" << std::endl;
-
-    // Display current elevator state
-    std::cout << "Current Floor: " << currentFloor 
-              << ", Direction: " << currentDirection 
-              << ", Active Requests: ";
-    for (const auto &floor : activeFloorRequests) std::cout << floor << " ";
-    std::cout << std::endl;
-
-    // Process new requests and handle passengers
-    ProcessIncomingRequests(currentTimeStep);
-    HandlePassengers(currentTimeStep);
+    if (fVerbose) {
+        std::cout << "---- Time Step: " << currentTime << " ----" << std::endl;
 
-    // **Early Exit Check** - If all requests have been handled, end the simulation early
-    if (pendingRequests.empty() && activeFloorRequests.empty()) {
-        std::cout << "All requests have been processed. Ending simulation early at Time Step: " << currentTimeStep << std::endl;
-        return;
+        // Display current elevator state
+        std::cout << "Current Floor: " << currentFloor 
+                  << ", Direction: " << GetDirectionString(currentDirection) 
+                  << ", Active Requests: ";
+        for (const auto &floor : activeFloorRequests) std::cout << floor << " ";
+        std::cout << std::endl;
     }
 
-    // Update elevator's movement direction and move
-    UpdateDirection();
-    ExecuteMove(currentTimeStep);
-
-    std::cout << "End of Time Step: " << currentTimeStep << std::endl;
+    ECElevatorStepResult result = Step();
 
-    // Increment the time step for the next simulation
-    ++currentTimeStep;
+    if (fVerbose) {
+        if (result.fComplete) {
+            std::cout << "All requests have been processed. Ending simulation early at Time Step: " << currentTime << std::endl;
+        } else {
+            std::cout << "End of Time Step: " << currentTime - 1 << std::endl;
+        }
+    }
 }
 
 bool ECElevatorSim::IsSimulationComplete() const {
-    bool allRequestsProcessed = pendingRequests.empty();
-    bool noActiveRequests = activeFloorRequests.empty();
+    bool allRequestsProcessed = nextRequestIndex == requestSchedule->size() && pendingRequests.empty();
+    bool noActiveRequests = activeFloorRequests.IsEmpty();
     bool elevatorStopped = currentDirection == EC_ELEVATOR_STOPPED;
 
-    std::cout << "Check completion: " 
-              << "Pending Requests Empty: " << allRequestsProcessed
-              << ", Active Requests Empty: " << noActiveRequests
-              << ", Elevator Stopped: " << elevatorStopped
-              << std::endl;
+    if (fVerbose) {
+        std::cout << "Check completion: " 
+                  << "Pending Requests Empty: " << allRequestsProcessed
+                  << ", Active Requests Empty: " << noActiveRequests
+                  << ", Elevator Stopped: " << elevatorStopped
+                  << std::endl;
+    }
 
     return allRequestsProcessed && noActiveRequests && elevatorStopped;
 }
@@ -288,20 +776,19 @@ bool ECElevatorSim::IsSimulationComplete() const {
 //*****************************************************************************
 // New Getter Methods Implementation
 
-std::vector<int> ECElevatorSim::GetWaitingPassengers() const {
+const std::vector<int>& ECElevatorSim::GetWaitingPassengers() const {
     return waitingPassengers;
 }
 
-const std::vector<int> ECElevatorSim::GetElevatorPassengers() const {
-    return elevatorPassengers;
-}
-
-std::vector<int> ECElevatorSim::GetWaitingDirections() const {
+const std::vector<int>& ECElevatorSim::GetWaitingDirections() const {
     return waitingDirections;
 }
 
 void ECElevatorSim::UpdateElevatorPassengers(const std::vector<int>& updatedPassengers) {
-    elevatorPassengers = updatedPassengers;
+    carLoad.Clear();
+    for (int dest : updatedPassengers) {
+        carLoad.Board(dest);
+    }
 }
 
 void ECElevatorSim::UpdateWaitingPassengers(const std::vector<int>& updatedWaiting) {
@@ -6,6 +6,19 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <algorithm>
+#include <memory>
+#include <csignal>
+#include "ECWaitHistogram.h"
+#include "ECTimeRollup.h"
+#include "ECCarLoad.h"
+#include "ECStateDigest.h"
+#include "ECTripTable.h"
+#include "ECDemandForecast.h"
+
+class ECLiveRequestSource;
+class ECTelemetryWriter;
+class ECCheckpointWriter;
 
 //*****************************************************************************
 // Elevator simulation request: 
@@ -44,19 +57,144 @@ typedef enum {
     EC_ELEVATOR_DOWN
 } EC_ELEVATOR_DIR;
 
+//*****************************************************************************
+// Set of floors with an outstanding stop request. One flag per floor, so insert
+// and erase never allocate; iterating yields the requested floors in ascending
+// order, like the std::set it replaces.
+class ECFloorSet
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const unsigned char *flagsIn, int floorIn, int lastIn) : flags(flagsIn), floor(floorIn), last(lastIn) { Skip(); }
+        int operator*() const { return floor; }
+        Iterator &operator++() { ++floor; Skip(); return *this; }
+        bool operator!=(const Iterator &rhs) const { return floor != rhs.floor; }
+
+    private:
+        void Skip() { while (floor <= last && !flags[floor]) ++floor; }
+
+        const unsigned char *flags;
+        int floor;
+        int last;
+    };
+
+    explicit ECFloorSet(int numFloors = 0) : flags(numFloors + 1, 0), count(0) {}
+
+    void Insert(int floor) {
+        if (floor >= 1 && floor < static_cast<int>(flags.size()) && !flags[floor]) { flags[floor] = 1; ++count; }
+    }
+    void Erase(int floor) {
+        if (floor >= 1 && floor < static_cast<int>(flags.size()) && flags[floor]) { flags[floor] = 0; --count; }
+    }
+    bool Contains(int floor) const { return floor >= 1 && floor < static_cast<int>(flags.size()) && flags[floor]; }
+    bool IsEmpty() const { return count == 0; }
+    int GetSize() const { return count; }
+
+    Iterator begin() const { return Iterator(flags.data(), 1, LastFloor()); }
+    Iterator end() const { return Iterator(flags.data(), LastFloor() + 1, LastFloor()); }
+
+private:
+    int LastFloor() const { return static_cast<int>(flags.size()) - 1; }
+
+    std::vector<unsigned char> flags;   // indexed by floor number; entry 0 unused
+    int count;
+};
+
+//*****************************************************************************
+// Outcome of a batch of simulation steps
+struct ECElevatorStepResult
+{
+    ECElevatorStepResult() : ticksRun(0), timeNow(0), boardings(0), alightings(0), moves(0), fComplete(false) {}
+
+    int ticksRun;       // ticks actually advanced (fewer than asked once all requests are handled)
+    int timeNow;        // simulation time after the batch
+    int boardings;      // passengers who boarded during the batch
+    int alightings;     // passengers who arrived during the batch
+    int moves;          // ticks in which the car changed floor
+    bool fComplete;     // every request has been serviced
+};
+
 //*****************************************************************************
 // Simulation of elevator
 class ECElevatorSim
 {
 public:
     ECElevatorSim(int totalFloors, std::vector<ECElevatorSimRequest> &requestsList);
+    // Share an already time-sorted request schedule with other simulators
+    ECElevatorSim(int totalFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule);
     ~ECElevatorSim();
 
     void Simulate(int simulationDuration, const std::string& outputFilename);   
-    void SimulateStep();  // Stepwise simulation
+    void SimulateStep();  // Stepwise simulation, with console output when verbose
     bool IsSimulationComplete() const;
-        const std::set<int>& GetActiveFloorRequests() const;
 
+    // Re-entrant stepping API: each instance keeps its own clock and is silent unless verbose,
+    // so independent simulators can be stepped from different threads
+    ECElevatorStepResult Step() { return StepN(1); }
+    ECElevatorStepResult StepN(int numSteps);
+    ECElevatorStepResult RunUntil(int time);   // step until the clock reaches time
+
+    // Branch the simulation: the copy shares the request schedule and duplicates only the
+    // car state and in-flight requests, so forks are cheap and can run on other threads.
+    // A fork never pulls from this simulator's live source.
+    std::shared_ptr<ECElevatorSim> Fork() const;
+
+    // Console debugging output (off by default)
+    void SetVerbose(bool f) { fVerbose = f; }
+    bool IsVerbose() const { return fVerbose; }
+
+    // Live mode: pull hall calls from the source every tick, pacing ticks tickMillis apart.
+    // The run can then end early only once the source has ended (see ECLiveRequestSource::HasEnded)
+    void AttachLiveSource(ECLiveRequestSource *source, int tickMillis);
+    bool IsLive() const { return liveSource != NULL; }
+
+    // Simulate stops before the next tick once *flag is set, e.g. by a signal handler (NULL for none)
+    void SetStopFlag(const volatile std::sig_atomic_t *flag) { stopFlag = flag; }
+    const ECFloorSet& GetActiveFloorRequests() const { return activeFloorRequests; }
+
+    // Publish the state to a shared-memory segment after every tick (not owned; NULL to stop)
+    void AttachTelemetry(ECTelemetryWriter *writer) { telemetry = writer; }
+
+    // Fold the state into a digest stream after every tick (not owned; NULL to stop),
+    // for checking other engines against this one tick by tick
+    void AttachDigest(ECDigestWriter *writer);
+    void FillState(ECEngineState &state) const;   // time is the ticks run so far
+    void DumpState(std::ostream &out) const;
+
+    // Add a row to the trip table for every passenger who reaches their floor (not owned; NULL to stop)
+    void AttachTripTable(ECTripTableWriter *writer) { trips = writer; }
+
+    // Keep per-floor rollups at the standard resolutions; Simulate writes them
+    // to <output_file>.rollup. Forks do not keep rollups.
+    void EnableRollups();
+    const ECTimeRollup *GetRollups() const { return rollups.get(); }
+
+    // Idle parking: learn where calls come from (see ECDemandForecast) and, when there is
+    // nothing to serve, send the car to the floor expected to call next instead of stopping
+    // where it is. Parking moves count as moves. Forks keep the forecast learned so far.
+    void EnableIdleParking(int bucketTicks = 300, int numBuckets = 12, double halfLifeTicks = 300);
+    bool IsParkingEnabled() const { return fParking; }
+    const ECDemandForecast &GetDemandForecast() const { return demand; }
+
+    // Checkpoints: every everyTicks ticks Simulate hands a copy of the simulator to a background
+    // thread that writes it to path atomically. The engine has no random state, so the car,
+    // the requests in flight, the schedule cursor and the statistics are all there is to save.
+    void EnableCheckpoints(const std::string &path, int everyTicks);
+    // Load a checkpoint taken from the same input; Simulate then cuts the trace file back to
+    // where the checkpoint was taken and carries on, giving the same output as an unbroken run.
+    // Live calls that had not been activated when the checkpoint was taken are not saved.
+    bool ResumeFromCheckpoint(const std::string &path);
+    void SaveState(std::ostream &out, long long outputOffset) const;
+    bool LoadState(std::istream &in, long long &outputOffset);
+
+    // Running statistics
+    const ECWaitHistogram& GetWaitTimes() const { return waitTimes; }   // ticks from hall call to boarding
+    long long GetTotalRequests() const { return totalRequests; }
+    long long GetTotalBoardings() const { return totalBoardings; }
+    long long GetTotalAlightings() const { return totalAlightings; }
+    long long GetTotalMoves() const { return totalMoves; }
     
 
     // Getters to interact with the frontend
@@ -66,25 +204,24 @@ public:
     int GetSimulationDuration() const { return simulationDuration; }
     bool IsGoingUp() const { return currentDirection == EC_ELEVATOR_UP; }
     bool IsGoingDown() const { return currentDirection == EC_ELEVATOR_DOWN; }
-    std::vector<int> GetWaitingPassengers() const;
+    const std::vector<int>& GetWaitingPassengers() const;
     int GetCurrentTime() const { return currentTime; }
     int GetNumberOfRiders() const { return numberOfRiders; }
-    const std::vector<int> GetElevatorPassengers() const;
-    std::vector<int> GetWaitingDirections() const;
+    const ECCarLoad& GetCarLoad() const { return carLoad; }   // iterates rider destinations in boarding order
+    const std::vector<int>& GetWaitingDirections() const;
 
     void ExecuteMove() { ExecuteMove(currentTime); }
 
     // New methods to allow `ElevatorHandler` access
     std::vector<ECElevatorSimRequest>& GetPendingRequests() { return pendingRequests; }
-    void AddActiveFloorRequest(int floor) { activeFloorRequests.insert(floor); }
-    void RemoveActiveFloorRequest(int floor) { activeFloorRequests.erase(floor); }
-    void AddPassengerToElevator(int destination) { elevatorPassengers.push_back(destination); }
-    void RemovePassengerFromElevator(int floor) {
-        auto passengerIt = std::find(elevatorPassengers.begin(), elevatorPassengers.end(), floor);
-        if (passengerIt != elevatorPassengers.end()) {
-            elevatorPassengers.erase(passengerIt);
-        }
-    }
+    const std::vector<ECElevatorSimRequest>& GetRequestSchedule() const { return *requestSchedule; }
+    // The same time-sorted schedule, to share with other engines without copying it
+    std::shared_ptr<const std::vector<ECElevatorSimRequest> > GetSharedRequestSchedule() const { return requestSchedule; }
+    int GetNumFutureRequests() const { return static_cast<int>(requestSchedule->size() - nextRequestIndex); }
+    void AddActiveFloorRequest(int floor) { activeFloorRequests.Insert(floor); }
+    void RemoveActiveFloorRequest(int floor) { activeFloorRequests.Erase(floor); }
+    void AddPassengerToElevator(int destination) { carLoad.Board(destination); }
+    void RemovePassengerFromElevator(int floor) { carLoad.UnloadOne(floor); }
     void IncrementRiders() { numberOfRiders++; }
     void DecrementRiders() { if (numberOfRiders > 0) numberOfRiders--; }
     void DecrementWaitingPassengers(int index) { 
@@ -104,19 +241,49 @@ private:
     EC_ELEVATOR_DIR currentDirection;  
     int currentTime;                   
     int numberOfRiders;                
+    bool fVerbose;                     // write debugging output to the console
+    long long totalBoardings;          // running totals, used to summarize step batches
+    long long totalAlightings;
+    long long totalMoves;
+    long long totalRequests;
+    ECWaitHistogram waitTimes;
 
-    std::vector<ECElevatorSimRequest> pendingRequests; 
-    std::set<int> activeFloorRequests; 
-    std::vector<int> elevatorPassengers; 
+    std::shared_ptr<const std::vector<ECElevatorSimRequest> > requestSchedule;  // all requests by time; never modified
+    size_t nextRequestIndex;           // first schedule entry not yet made
+    std::vector<ECElevatorSimRequest> pendingRequests;  // requests made but not yet serviced
+    ECFloorSet activeFloorRequests; 
+    ECCarLoad carLoad;                 // riders, by destination
     std::vector<int> waitingPassengers; 
     std::vector<int> waitingDirections; 
 
+    ECLiveRequestSource *liveSource;   // not owned; NULL unless running live
+    int liveTickMillis;                // wall-clock length of a tick in live mode
+    const volatile std::sig_atomic_t *stopFlag;   // not owned; NULL unless Simulate may be stopped
+    ECTelemetryWriter *telemetry;      // not owned; NULL unless publishing telemetry
+    ECDigestWriter *digest;            // not owned; NULL unless writing digests
+    ECEngineState digestState;         // reused every tick
+    ECTripTableWriter *trips;          // not owned; NULL unless writing trips
+    std::shared_ptr<ECTimeRollup> rollups;   // NULL unless enabled
+    bool fParking;                     // park the idle car by the demand forecast
+    ECDemandForecast demand;           // empty unless parking
+    int parkingFloor;                  // floor the idle car is being sent to this tick; 0 if none
+    std::shared_ptr<ECCheckpointWriter> checkpointWriter;   // NULL unless checkpointing
+    int checkpointEveryTicks;
+    long long resumeOutputOffset;      // trace length to continue from; -1 unless resuming
+
+    void RunTick(int time);
+    void PublishTelemetry();
+    std::shared_ptr<ECElevatorSim> TakeSnapshot() const;
+    void WriteTraceStep(std::ostream &outFile) const;
+    bool AllRequestsHandled() const;
+    void PullLiveRequests(int time);
+    void ActivateRequest(const ECElevatorSimRequest &request);
     void ProcessIncomingRequests(int time);
     void HandlePassengers(int currentTime); 
     void UpdateDirection();
     void ExecuteMove(int timeStep);
     int SelectNextFloor();
-    std::string GetDirectionString(EC_ELEVATOR_DIR direction) const;
+    const char *GetDirectionString(EC_ELEVATOR_DIR direction) const;
 };
 
 #endif /* ECELEVATORSIM1_H */
@@ -0,0 +1,49 @@
+#include "ECFixedElevatorSim.h"
+
+// Compiled once here rather than in every user of the header
+template class ECFixedElevatorSim<5>;
+template class ECFixedElevatorSim<10>;
+template class ECFixedElevatorSim<20>;
+
+namespace {
+template <int Floors>
+void SimulateFixed(std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule, int simulationDuration,
+                   const std::string &outputFilename, bool fRollups, ECDigestWriter *digest,
+                   ECTripTableWriter *trips) {
+    ECFixedElevatorSim<Floors> sim(schedule);
+    if (fRollups) {
+        sim.EnableRollups();
+    }
+    sim.AttachDigest(digest);
+    sim.AttachTripTable(trips);
+    sim.Simulate(simulationDuration, outputFilename);
+}
+
+template <int Floors>
+void RunFixedToState(std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule, int numTicks, ECEngineState &state) {
+    ECFixedElevatorSim<Floors> sim(schedule);
+    sim.StepN(numTicks);
+    sim.FillState(state);
+}
+}
+
+bool ECFixedEngines::Simulate(int numFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule,
+                              int simulationDuration, const std::string &outputFilename, bool fRollups,
+                              ECDigestWriter *digest, ECTripTableWriter *trips) {
+    switch (numFloors) {
+        case 5: SimulateFixed<5>(schedule, simulationDuration, outputFilename, fRollups, digest, trips); return true;
+        case 10: SimulateFixed<10>(schedule, simulationDuration, outputFilename, fRollups, digest, trips); return true;
+        case 20: SimulateFixed<20>(schedule, simulationDuration, outputFilename, fRollups, digest, trips); return true;
+        default: return false;
+    }
+}
+
+bool ECFixedEngines::RunToState(int numFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule,
+                                int numTicks, ECEngineState &state) {
+    switch (numFloors) {
+        case 5: RunFixedToState<5>(schedule, numTicks, state); return true;
+        case 10: RunFixedToState<10>(schedule, numTicks, state); return true;
+        case 20: RunFixedToState<20>(schedule, numTicks, state); return true;
+        default: return false;
+    }
+}
@@ -0,0 +1,360 @@
+#ifndef ECFIXEDELEVATORSIM_H
+#define ECFIXEDELEVATORSIM_H
+
+#include "ECElevatorSim1.h"
+#include "ECWaitHistogram.h"
+#include "ECTimeRollup.h"
+#include "ECCarLoad.h"
+#include "ECStateDigest.h"
+#include "ECTripTable.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+//*****************************************************************************
+// ECElevatorSim compiled for one building height. The per-floor state lives in
+// std::array, the floors with a stop request in a 64-bit mask, and the floor
+// scans have a compile-time bound the compiler can unroll; picking the next
+// floor is a couple of bit scans instead of a walk over every floor.
+//
+// Runs headless: the same trace and rollups as ECElevatorSim::Simulate, without
+// live input, telemetry, checkpoints or console output. Requests must name
+// floors 1..Floors, as with ECElevatorSim.
+template <int Floors>
+class ECFixedElevatorSim
+{
+    static_assert(Floors >= 1 && Floors <= 63, "floors must fit in the request mask");
+
+public:
+    typedef uint64_t FloorMask;   // bit f set: floor f has a stop request
+
+    static constexpr FloorMask FloorBit(int floor) { return FloorMask(1) << floor; }
+    static constexpr FloorMask FloorsBelow(int floor) { return FloorBit(floor) - FloorBit(1); }
+    static constexpr FloorMask FloorsAbove(int floor) { return ALL_FLOORS & ~(FloorBit(floor + 1) - 1); }
+    static constexpr FloorMask ALL_FLOORS = ((FloorMask(1) << Floors) - 1) << 1;
+
+    explicit ECFixedElevatorSim(std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule)
+        : currentFloor(1), currentDirection(EC_ELEVATOR_STOPPED), currentTime(0), numberOfRiders(0),
+          totalBoardings(0), totalAlightings(0), totalMoves(0), totalRequests(0),
+          requestSchedule(schedule), nextRequestIndex(0), activeFloorRequests(0), carLoad(Floors), digest(NULL), trips(NULL) {
+        waitingPassengers.fill(0);
+        waitingDirections.fill(0);
+    }
+
+    void Simulate(int simulationDuration, const std::string &outputFilename);
+    ECElevatorStepResult StepN(int numSteps);
+
+    // Keep per-floor rollups at the standard resolutions; Simulate writes them to <output_file>.rollup
+    void EnableRollups() {
+        rollups = std::make_shared<ECTimeRollup>(Floors);
+        rollups->AddStandardLevels();
+    }
+    const ECTimeRollup *GetRollups() const { return rollups.get(); }
+
+    // Digest stream and state, as ECElevatorSim::AttachDigest and FillState
+    void AttachDigest(ECDigestWriter *writer) { digest = writer; digestState.Resize(Floors); }
+    void FillState(ECEngineState &state) const;
+
+    // Trip table rows, as ECElevatorSim::AttachTripTable
+    void AttachTripTable(ECTripTableWriter *writer) { trips = writer; }
+
+    int GetTotalFloors() const { return Floors; }
+    int GetCurrentFloor() const { return currentFloor; }
+    int GetCurrentTime() const { return currentTime; }
+    int GetNumberOfRiders() const { return numberOfRiders; }
+    bool IsGoingUp() const { return currentDirection == EC_ELEVATOR_UP; }
+    bool IsGoingDown() const { return currentDirection == EC_ELEVATOR_DOWN; }
+    const std::array<int, Floors> &GetWaitingPassengers() const { return waitingPassengers; }
+    const ECCarLoad &GetCarLoad() const { return carLoad; }
+    const ECWaitHistogram &GetWaitTimes() const { return waitTimes; }
+    long long GetTotalRequests() const { return totalRequests; }
+    long long GetTotalBoardings() const { return totalBoardings; }
+    long long GetTotalAlightings() const { return totalAlightings; }
+    long long GetTotalMoves() const { return totalMoves; }
+
+private:
+    void RunTick(int time);
+    bool AllRequestsHandled() const {
+        return nextRequestIndex == requestSchedule->size() && pendingRequests.empty() && activeFloorRequests == 0;
+    }
+    void WriteTraceStep(std::ostream &outFile) const;
+    void ActivateRequest(const ECElevatorSimRequest &request);
+    void HandlePassengers(int time);
+    void UpdateDirection();
+    void ExecuteMove();
+    int SelectNextFloor();
+
+    int currentFloor;
+    EC_ELEVATOR_DIR currentDirection;
+    int currentTime;
+    int numberOfRiders;
+    long long totalBoardings;
+    long long totalAlightings;
+    long long totalMoves;
+    long long totalRequests;
+    ECWaitHistogram waitTimes;
+
+    std::shared_ptr<const std::vector<ECElevatorSimRequest> > requestSchedule;   // sorted by time
+    size_t nextRequestIndex;
+    std::vector<ECElevatorSimRequest> pendingRequests;
+    FloorMask activeFloorRequests;
+    ECCarLoad carLoad;
+    std::array<int, Floors> waitingPassengers;
+    std::array<int, Floors> waitingDirections;
+    std::shared_ptr<ECTimeRollup> rollups;        // NULL unless enabled
+    ECDigestWriter *digest;                       // not owned; NULL unless writing digests
+    ECEngineState digestState;
+    ECTripTableWriter *trips;                     // not owned; NULL unless writing trips
+};
+
+template <int Floors>
+constexpr typename ECFixedElevatorSim<Floors>::FloorMask ECFixedElevatorSim<Floors>::ALL_FLOORS;
+
+//*****************************************************************************
+// The building heights most of the fleet has; other heights use ECElevatorSim
+class ECFixedEngines
+{
+public:
+    static bool HasSpecialization(int numFloors) { return numFloors == 5 || numFloors == 10 || numFloors == 20; }
+
+    // Simulate with the specialization for numFloors, as ECElevatorSim::Simulate would;
+    // false if there is none
+    static bool Simulate(int numFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule,
+                         int simulationDuration, const std::string &outputFilename, bool fRollups,
+                         ECDigestWriter *digest = NULL, ECTripTableWriter *trips = NULL);
+
+    // State after StepN(numTicks), for comparing with other engines; false if there is no specialization
+    static bool RunToState(int numFloors, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule,
+                           int numTicks, ECEngineState &state);
+};
+
+//*****************************************************************************
+// Same steps as ECElevatorSim, tick for tick
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::Simulate(int simulationDuration, const std::string &outputFilename) {
+    std::ofstream outFile(outputFilename);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open file " << outputFilename << " for writing." << std::endl;
+        return;
+    }
+    outFile << Floors << " " << simulationDuration << "\n";
+
+    for (currentTime = 0; currentTime < simulationDuration; ++currentTime) {
+        WriteTraceStep(outFile);
+        RunTick(currentTime);
+        if (AllRequestsHandled()) {
+            outFile << "All requests have been processed. Ending simulation early at Time Step: " << currentTime << "\n";
+            break;
+        }
+        outFile << "End of Time Step: " << currentTime << "\n";
+    }
+    outFile.close();
+
+    if (rollups) {
+        rollups->Flush();
+        rollups->Write(outputFilename + ".rollup");
+    }
+}
+
+template <int Floors>
+ECElevatorStepResult ECFixedElevatorSim<Floors>::StepN(int numSteps) {
+    ECElevatorStepResult result;
+    long long boardingsBefore = totalBoardings;
+    long long alightingsBefore = totalAlightings;
+    long long movesBefore = totalMoves;
+
+    for (int i = 0; i < numSteps && !AllRequestsHandled(); ++i) {
+        RunTick(currentTime);
+        ++currentTime;
+        ++result.ticksRun;
+    }
+
+    result.timeNow = currentTime;
+    result.boardings = static_cast<int>(totalBoardings - boardingsBefore);
+    result.alightings = static_cast<int>(totalAlightings - alightingsBefore);
+    result.moves = static_cast<int>(totalMoves - movesBefore);
+    result.fComplete = AllRequestsHandled();
+    return result;
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::RunTick(int time) {
+    if (rollups) {
+        rollups->BeginTick(time);
+    }
+
+    const std::vector<ECElevatorSimRequest> &schedule = *requestSchedule;
+    while (nextRequestIndex < schedule.size() && schedule[nextRequestIndex].GetTime() <= time) {
+        ActivateRequest(schedule[nextRequestIndex++]);
+    }
+    HandlePassengers(time);
+    UpdateDirection();
+    ExecuteMove();
+
+    if (rollups) {
+        rollups->EndTick(waitingPassengers.data());
+    }
+    if (digest != NULL) {
+        FillState(digestState);
+        digestState.time = time + 1;
+        digest->Record(digestState);
+    }
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::FillState(ECEngineState &state) const {
+    if (state.numFloors != Floors) {
+        state.Resize(Floors);
+    }
+    state.time = currentTime;
+    state.currentFloor = currentFloor;
+    state.direction = currentDirection;
+    state.requests = totalRequests;
+    state.boardings = totalBoardings;
+    state.alightings = totalAlightings;
+    state.moves = totalMoves;
+    state.waitTicksSum = waitTimes.GetSum();
+    for (int floor = 1; floor <= Floors; ++floor) {
+        state.waiting[floor] = waitingPassengers[floor - 1];
+        state.ridersTo[floor] = carLoad.GetCountFor(floor);
+        state.stopRequested[floor] = (activeFloorRequests >> floor) & 1;
+    }
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::WriteTraceStep(std::ostream &outFile) const {
+    static const char *const directionNames[] = { "STOPPED", "UP", "DOWN" };
+    outFile << "Time Step: " << currentTime << "\n";
+    outFile << "Floor: " << currentFloor << ", Direction: " << directionNames[currentDirection] << "\n";
+    outFile << "Passengers In Elevator: ";
+    for (int dest : carLoad) {
+        outFile << dest << " ";
+    }
+    outFile << "\n";
+    outFile << "Waiting Passengers: ";
+    for (int i = 0; i < Floors; ++i) {
+        outFile << waitingPassengers[i] << " ";
+    }
+    outFile << "\n";
+    outFile << "--\n";
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::ActivateRequest(const ECElevatorSimRequest &request) {
+    int src = request.GetFloorSrc();
+    pendingRequests.push_back(request);
+    totalRequests++;
+    if (rollups) {
+        rollups->RecordCall(src);
+    }
+    activeFloorRequests |= FloorBit(src);
+    waitingPassengers[src - 1]++;
+    waitingDirections[src - 1] = (request.GetFloorDest() > src) ? 1 : -1;
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::HandlePassengers(int time) {
+    // With nobody waiting here and nobody riding here the scan would change nothing
+    if (waitingPassengers[currentFloor - 1] > 0 || carLoad.HasRidersFor(currentFloor)) {
+        long long boardingsBefore = totalBoardings;
+        long long alightingsBefore = totalAlightings;
+        if (trips != NULL) {
+            for (const ECCarRider &rider : carLoad.GetRidersFor(currentFloor)) {
+                trips->AddTrip(rider.timeCall, rider.floorSrc, rider.floorDest, rider.timeBoard, time, 1);
+            }
+        }
+        carLoad.Unload(currentFloor);
+
+        size_t numKept = 0;
+        for (size_t i = 0; i < pendingRequests.size(); ++i) {
+            ECElevatorSimRequest *it = &pendingRequests[i];
+            if (it->GetFloorSrc() == currentFloor && !it->IsFloorRequestDone()) {
+                it->SetFloorRequestDone(true);
+                activeFloorRequests |= FloorBit(it->GetFloorDest());
+                waitingPassengers[currentFloor - 1]--;
+                carLoad.Board(it->GetFloorDest(), currentFloor, it->GetTime(), time);
+                numberOfRiders++;
+                totalBoardings++;
+                waitTimes.Add(time - it->GetTime());
+                if (rollups) {
+                    rollups->RecordBoarding(currentFloor, time - it->GetTime());
+                }
+            } else if (it->GetFloorDest() == currentFloor && it->IsFloorRequestDone()) {
+                numberOfRiders--;
+                totalAlightings++;
+                continue;
+            }
+            pendingRequests[numKept++] = *it;
+        }
+        pendingRequests.erase(pendingRequests.begin() + numKept, pendingRequests.end());
+
+        if (rollups && (totalBoardings != boardingsBefore || totalAlightings != alightingsBefore)) {
+            rollups->RecordStop(currentFloor);
+        }
+    }
+
+    activeFloorRequests &= ~FloorBit(currentFloor);
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::UpdateDirection() {
+    if (activeFloorRequests == 0) {
+        currentDirection = EC_ELEVATOR_STOPPED;
+        return;
+    }
+
+    int nextFloor = SelectNextFloor();
+    if (nextFloor > currentFloor) {
+        currentDirection = EC_ELEVATOR_UP;
+    } else if (nextFloor < currentFloor) {
+        currentDirection = EC_ELEVATOR_DOWN;
+    } else {
+        currentDirection = EC_ELEVATOR_STOPPED;
+    }
+}
+
+template <int Floors>
+void ECFixedElevatorSim<Floors>::ExecuteMove() {
+    if (currentDirection == EC_ELEVATOR_UP || currentDirection == EC_ELEVATOR_DOWN) {
+        currentFloor = SelectNextFloor();
+        totalMoves++;
+    }
+}
+
+// Nearest request in the current direction; failing that the direction flips and
+// the nearest request overall wins, the lower floor on a tie
+template <int Floors>
+int ECFixedElevatorSim<Floors>::SelectNextFloor() {
+    FloorMask above = activeFloorRequests & FloorsAbove(currentFloor);
+    FloorMask below = activeFloorRequests & FloorsBelow(currentFloor);
+    if (currentDirection == EC_ELEVATOR_UP && above != 0) {
+        return __builtin_ctzll(above);
+    }
+    if (currentDirection == EC_ELEVATOR_DOWN && below != 0) {
+        return 63 - __builtin_clzll(below);
+    }
+
+    currentDirection = (currentDirection == EC_ELEVATOR_UP) ? EC_ELEVATOR_DOWN : EC_ELEVATOR_UP;
+    if (activeFloorRequests & FloorBit(currentFloor)) {
+        return currentFloor;
+    }
+    if (below == 0) {
+        return above != 0 ? __builtin_ctzll(above) : -1;
+    }
+    int floorBelow = 63 - __builtin_clzll(below);
+    if (above == 0) {
+        return floorBelow;
+    }
+    int floorAbove = __builtin_ctzll(above);
+    return (currentFloor - floorBelow <= floorAbove - currentFloor) ? floorBelow : floorAbove;
+}
+
+extern template class ECFixedElevatorSim<5>;
+extern template class ECFixedElevatorSim<10>;
+extern template class ECFixedElevatorSim<20>;
+
+#endif /* ECFIXEDELEVATORSIM_H */
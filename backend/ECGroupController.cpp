@@ -0,0 +1,240 @@
+#include "ECGroupController.h"
+#include <limits>
+
+ECGroupController::ECGroupController(int numFloorsIn, int numCarsIn)
+    : numFloors(numFloorsIn), numCars(numCarsIn > 0 ? numCarsIn : 0), waitWeight(2.0), rideWeight(1.0), dwellTicks(2), cars(numCars) {
+    for (Car &car : cars) {
+        car.floor = 1;
+        car.fOpen = true;
+        car.holdTicks = 0;
+        car.currentStop = 0;
+        car.nextStopId = 1;
+        car.plan.reserve(2 * numFloors + 2);
+    }
+    delayBehind.reserve(2 * numFloors + 3);
+}
+
+void ECGroupController::SetWeights(double waitWeightIn, double rideWeightIn) {
+    waitWeight = waitWeightIn;
+    rideWeight = rideWeightIn;
+}
+
+double ECGroupController::EvaluateCar(int car, int floorSrc, int floorDest, Slot &pickup, Slot &dropoff,
+                                      int &waitTicks, int &rideTicks) const {
+    const Car &state = cars[car];
+    const std::vector<ECPlannedStop> &plan = state.plan;
+    int numStops = static_cast<int>(plan.size());
+
+    // Weight of delaying the passengers already planned from stop k on by one tick
+    if (static_cast<int>(delayBehind.size()) < numStops + 1) {
+        delayBehind.resize(numStops + 1);
+    }
+    delayBehind[numStops] = 0;
+    for (int k = numStops - 1; k >= 0; --k) {
+        delayBehind[k] = delayBehind[k + 1] + waitWeight * plan[k].pickups + rideWeight * plan[k].dropoffs;
+    }
+
+    // Cheapest pickup seen so far. Its cost counts the wait at the difference of the weights,
+    // since the ride is measured from the drop-off's arrival, and a new stop's delay both to
+    // the passengers behind it and to the new passenger's own drop-off.
+    const double NONE = std::numeric_limits<double>::max();
+    double pickCost = NONE;
+    Slot pickSlot;
+    int pickTicks = 0;
+    int pickShift = 0;
+    if (state.fOpen && state.floor == floorSrc) {
+        pickCost = 0;
+        pickSlot.index = -1;
+        pickSlot.fNew = false;
+    }
+
+    double best = NONE;
+    int prevFloor = state.floor;
+    int leaveTicks = state.holdTicks;   // when the car leaves the floor in front of gap k
+    for (int k = 0; k <= numStops; ++k) {
+        int arriveTicks = k < numStops ? leaveTicks + Travel(prevFloor, plan[k].floor) : 0;
+
+        // New pickup and new drop-off stops, both in front of stop k
+        int pickupTicks = leaveTicks + Travel(prevFloor, floorSrc);
+        int dropoffTicks = pickupTicks + dwellTicks - 1 + Travel(floorSrc, floorDest);
+        int delay = k < numStops ? dropoffTicks + dwellTicks - 1 + Travel(floorDest, plan[k].floor) - arriveTicks : 0;
+        double total = waitWeight * pickupTicks + rideWeight * (dropoffTicks - pickupTicks) + delay * delayBehind[k];
+        if (total < best) {
+            best = total;
+            pickup.index = dropoff.index = k;
+            pickup.fNew = dropoff.fNew = true;
+            waitTicks = pickupTicks;
+            rideTicks = dropoffTicks - pickupTicks;
+        }
+
+        // New drop-off stop in front of stop k, after an earlier pickup
+        if (pickCost != NONE) {
+            dropoffTicks = leaveTicks + Travel(prevFloor, floorDest);
+            delay = k < numStops ? dropoffTicks + dwellTicks - 1 + Travel(floorDest, plan[k].floor) - arriveTicks : 0;
+            total = pickCost + rideWeight * dropoffTicks + delay * delayBehind[k];
+            if (total < best) {
+                best = total;
+                pickup = pickSlot;
+                dropoff.index = k;
+                dropoff.fNew = true;
+                waitTicks = pickTicks;
+                rideTicks = dropoffTicks + pickShift - pickTicks;
+            }
+        }
+        if (k == numStops) {
+            break;
+        }
+
+        // New pickup stop in front of stop k
+        delay = pickupTicks + dwellTicks - 1 + Travel(floorSrc, plan[k].floor) - arriveTicks;
+        double cost = (waitWeight - rideWeight) * pickupTicks + delay * (delayBehind[k] + rideWeight);
+        if (cost < pickCost) {
+            pickCost = cost;
+            pickSlot.index = k;
+            pickSlot.fNew = true;
+            pickTicks = pickupTicks;
+            pickShift = delay;
+        }
+
+        // Joining stop k
+        if (plan[k].floor == floorDest && pickCost != NONE) {
+            total = pickCost + rideWeight * arriveTicks;
+            if (total < best) {
+                best = total;
+                pickup = pickSlot;
+                dropoff.index = k;
+                dropoff.fNew = false;
+                waitTicks = pickTicks;
+                rideTicks = arriveTicks + pickShift - pickTicks;
+            }
+        } else if (plan[k].floor == floorSrc) {
+            cost = (waitWeight - rideWeight) * arriveTicks;
+            if (cost < pickCost) {
+                pickCost = cost;
+                pickSlot.index = k;
+                pickSlot.fNew = false;
+                pickTicks = arriveTicks;
+                pickShift = 0;
+            }
+        }
+
+        prevFloor = plan[k].floor;
+        leaveTicks = arriveTicks + dwellTicks - 1;
+    }
+    return best;
+}
+
+ECCallAssignment ECGroupController::FindBest(int floorSrc, int floorDest, Slot &bestPickup, Slot &bestDropoff) const {
+    ECCallAssignment assignment;
+    double best = std::numeric_limits<double>::max();
+    for (int car = 0; car < numCars; ++car) {
+        Slot pickup, dropoff;
+        int waitTicks = 0, rideTicks = 0;
+        double cost = EvaluateCar(car, floorSrc, floorDest, pickup, dropoff, waitTicks, rideTicks);
+        if (cost < best) {
+            best = cost;
+            bestPickup = pickup;
+            bestDropoff = dropoff;
+            assignment.car = car;
+            assignment.waitTicks = waitTicks;
+            assignment.rideTicks = rideTicks;
+            assignment.cost = cost;
+        }
+    }
+    return assignment;
+}
+
+ECCallAssignment ECGroupController::Evaluate(int floorSrc, int floorDest) const {
+    Slot pickup, dropoff;
+    return FindBest(floorSrc, floorDest, pickup, dropoff);
+}
+
+ECCallAssignment ECGroupController::Assign(int floorSrc, int floorDest) {
+    Slot bestPickup, bestDropoff;
+    ECCallAssignment assignment = FindBest(floorSrc, floorDest, bestPickup, bestDropoff);
+    if (assignment.car < 0) {
+        return assignment;
+    }
+
+    // Drop-off first: it is never in front of the pickup, so the pickup's index stays valid
+    Car &car = cars[assignment.car];
+    if (bestDropoff.fNew) {
+        assignment.dropoffStop = InsertStop(car, bestDropoff.index, floorDest);
+    } else {
+        assignment.dropoffStop = car.plan[bestDropoff.index].id;
+    }
+    car.plan[bestDropoff.index].dropoffs++;
+
+    if (bestPickup.index < 0) {
+        assignment.pickupStop = car.currentStop;
+    } else {
+        if (bestPickup.fNew) {
+            assignment.pickupStop = InsertStop(car, bestPickup.index, floorSrc);
+        } else {
+            assignment.pickupStop = car.plan[bestPickup.index].id;
+        }
+        car.plan[bestPickup.index].pickups++;
+    }
+    return assignment;
+}
+
+int ECGroupController::InsertStop(Car &car, int index, int floor) {
+    ECPlannedStop stop = { car.nextStopId++, floor, 0, 0 };
+    car.plan.insert(car.plan.begin() + index, stop);
+    return stop.id;
+}
+
+void ECGroupController::RemoveEmptyStop(Car &car, int index) {
+    if (car.plan[index].pickups == 0 && car.plan[index].dropoffs == 0) {
+        car.plan.erase(car.plan.begin() + index);
+    }
+}
+
+int ECGroupController::Advance(int car) {
+    Car &state = cars[car];
+    if (state.holdTicks > 0) {
+        state.holdTicks--;
+        return state.floor;
+    }
+    if (state.plan.empty()) {
+        return state.floor;   // idle, open where it last stopped
+    }
+
+    const ECPlannedStop &next = state.plan.front();
+    if (next.floor != state.floor) {
+        state.floor += next.floor > state.floor ? 1 : -1;
+    }
+    state.fOpen = state.floor == next.floor;
+    if (state.fOpen) {
+        state.currentStop = next.id;
+        state.holdTicks = dwellTicks - 1;
+        state.plan.erase(state.plan.begin());
+    }
+    return state.floor;
+}
+
+void ECGroupController::CancelPickup(int car, int stopId) {
+    Car &state = cars[car];
+    for (int k = 0; k < static_cast<int>(state.plan.size()); ++k) {
+        if (state.plan[k].id == stopId) {
+            if (state.plan[k].pickups > 0) {
+                state.plan[k].pickups--;
+            }
+            RemoveEmptyStop(state, k);
+            return;
+        }
+    }
+}
+
+void ECGroupController::CancelDropoff(int car, int stopId) {
+    Car &state = cars[car];
+    for (int k = 0; k < static_cast<int>(state.plan.size()); ++k) {
+        if (state.plan[k].id == stopId) {
+            if (state.plan[k].dropoffs > 0) {
+                state.plan[k].dropoffs--;
+            }
+            RemoveEmptyStop(state, k);
+            return;
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef ECGROUPCONTROLLER_H
+#define ECGROUPCONTROLLER_H
+
+#include <vector>
+
+//*****************************************************************************
+// A floor a car has promised to visit
+struct ECPlannedStop
+{
+    int id;         // unique within the car, so passengers can name their stop
+    int floor;
+    int pickups;    // assigned passengers boarding here
+    int dropoffs;   // passengers getting off here
+};
+
+//*****************************************************************************
+// Where a call was (or would be) placed
+struct ECCallAssignment
+{
+    ECCallAssignment() : car(-1), pickupStop(-1), dropoffStop(-1), waitTicks(0), rideTicks(0), cost(0) {}
+
+    int car;           // -1 when there are no cars
+    int pickupStop;    // stop id; the car's current stop when it is at the floor now
+    int dropoffStop;
+    int waitTicks;     // predicted ticks to boarding
+    int rideTicks;     // predicted ticks on board
+    double cost;       // added to the car's plan, in weighted passenger-ticks
+};
+
+//*****************************************************************************
+// Destination dispatch for a group of cars. A passenger keys in their floor
+// at the hall and is given a car at once; every car keeps the ordered list of
+// stops it has promised, and the call goes where it adds the least cost.
+//
+// A car moves one floor a tick towards its next planned stop and opens there
+// for dwellTicks ticks, serving the floor each of them; it only serves a floor
+// it has stopped at. So the time to reach stop k of a plan is the floors
+// travelled to it plus the dwell at every stop before it, and a new stop
+// delays everyone boarding or getting off after it by its detour plus a
+// dwell. The cost of a placement is the new passenger's weighted wait and
+// ride plus those delays. For each car the best pickup and drop-off pair is
+// found in one pass over the plan: joining an existing stop costs nothing
+// extra, a new stop costs the delays behind it, and the cheapest pickup seen
+// so far is carried forward to every drop-off position. An assignment is
+// therefore O(stops) per car and allocates nothing once the plans have grown.
+class ECGroupController
+{
+public:
+    ECGroupController(int numFloorsIn, int numCarsIn);
+
+    // Relative weight of a tick spent waiting and a tick spent riding (default 2 and 1)
+    void SetWeights(double waitWeightIn, double rideWeightIn);
+    // Ticks a car stands open at each stop (default 2, at least 1)
+    void SetDwellTicks(int dwellTicksIn) { dwellTicks = dwellTicksIn > 0 ? dwellTicksIn : 1; }
+
+    // Best placement of a call, without changing any plan
+    ECCallAssignment Evaluate(int floorSrc, int floorDest) const;
+    // Best placement, added to that car's plan
+    ECCallAssignment Assign(int floorSrc, int floorDest);
+
+    // Movement, driven by the simulator once the current floor has been served: the car
+    // stands out its dwell or moves one floor towards its first planned stop, and
+    // returns the floor it is now on
+    int Advance(int car);
+    // A passenger boarded or got off at the car's current stop instead of the one
+    // planned for them; a stop left with nobody to serve is dropped
+    void CancelPickup(int car, int stopId);
+    void CancelDropoff(int car, int stopId);
+
+    int GetNumFloors() const { return numFloors; }
+    int GetNumCars() const { return numCars; }
+    int GetCarFloor(int car) const { return cars[car].floor; }
+    int GetCurrentStop(int car) const { return cars[car].currentStop; }
+    bool IsOpen(int car) const { return cars[car].fOpen; }   // stopped at its current stop, not passing a floor
+    bool IsIdle(int car) const { return cars[car].plan.empty(); }
+    const std::vector<ECPlannedStop> &GetPlan(int car) const { return cars[car].plan; }
+
+private:
+    // A choice of pickup or drop-off: join stop index, or insert before it
+    struct Slot
+    {
+        int index;      // -1: the current stop
+        bool fNew;
+    };
+    struct Car
+    {
+        int floor;
+        bool fOpen;
+        int holdTicks;      // ticks still to stand at this floor before moving on
+        int currentStop;
+        int nextStopId;
+        std::vector<ECPlannedStop> plan;
+    };
+
+    ECCallAssignment FindBest(int floorSrc, int floorDest, Slot &pickup, Slot &dropoff) const;
+    double EvaluateCar(int car, int floorSrc, int floorDest, Slot &pickup, Slot &dropoff, int &waitTicks, int &rideTicks) const;
+    // Ticks from leaving floorFrom to opening at floorTo; opening again where the car stands takes one
+    int Travel(int floorFrom, int floorTo) const { return floorFrom == floorTo ? 1 : (floorFrom < floorTo ? floorTo - floorFrom : floorFrom - floorTo); }
+    int InsertStop(Car &car, int index, int floor);
+    void RemoveEmptyStop(Car &car, int index);
+
+    int numFloors;
+    int numCars;
+    double waitWeight;
+    double rideWeight;
+    int dwellTicks;
+    std::vector<Car> cars;
+    mutable std::vector<double> delayBehind;   // scratch: cost of delaying everyone from stop k on
+};
+
+#endif /* ECGROUPCONTROLLER_H */
@@ -0,0 +1,141 @@
+#include "ECGroupElevatorSim.h"
+#include "ECLiveRequestSource.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+bool RequestMadeEarlier(const ECElevatorSimRequest &lhs, const ECElevatorSimRequest &rhs) {
+    return lhs.GetTime() < rhs.GetTime();
+}
+
+std::shared_ptr<const std::vector<ECElevatorSimRequest> > MakeSchedule(const std::vector<ECElevatorSimRequest> &requests) {
+    std::shared_ptr<std::vector<ECElevatorSimRequest> > schedule = std::make_shared<std::vector<ECElevatorSimRequest> >(requests);
+    std::stable_sort(schedule->begin(), schedule->end(), RequestMadeEarlier);
+    return schedule;
+}
+}
+
+ECGroupElevatorSim::ECGroupElevatorSim(int numFloorsIn, int numCarsIn, const std::vector<ECElevatorSimRequest> &requests)
+    : ECGroupElevatorSim(numFloorsIn, numCarsIn, MakeSchedule(requests)) {}
+
+ECGroupElevatorSim::ECGroupElevatorSim(int numFloorsIn, int numCarsIn, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule)
+    : numFloors(numFloorsIn), currentTime(0), controller(numFloorsIn, numCarsIn), requestSchedule(schedule), nextRequestIndex(0),
+      liveSource(NULL), numActiveCalls(0), maxActiveCalls(0), totalRequests(0), totalBoardings(0), totalAlightings(0), totalMoves(0) {
+    int numCars = controller.GetNumCars();
+    waitingAt.resize(numCars * (numFloors + 1));
+    ridingTo.resize(numCars * (numFloors + 1));
+    numRiders.resize(numCars, 0);
+}
+
+ECElevatorStepResult ECGroupElevatorSim::StepN(int numSteps) {
+    ECElevatorStepResult result;
+    long long boardingsBefore = totalBoardings;
+    long long alightingsBefore = totalAlightings;
+    long long movesBefore = totalMoves;
+
+    for (int i = 0; i < numSteps && !AllRequestsHandled(); ++i) {
+        RunTick(currentTime);
+        ++currentTime;
+        ++result.ticksRun;
+    }
+
+    result.timeNow = currentTime;
+    result.boardings = static_cast<int>(totalBoardings - boardingsBefore);
+    result.alightings = static_cast<int>(totalAlightings - alightingsBefore);
+    result.moves = static_cast<int>(totalMoves - movesBefore);
+    result.fComplete = AllRequestsHandled();
+    return result;
+}
+
+bool ECGroupElevatorSim::AllRequestsHandled() const {
+    // Never true in live mode: more calls may still arrive
+    return liveSource == NULL && nextRequestIndex == requestSchedule->size() && numActiveCalls == 0;
+}
+
+void ECGroupElevatorSim::RunTick(int time) {
+    PullLiveRequests(time);
+    const std::vector<ECElevatorSimRequest> &schedule = *requestSchedule;
+    while (nextRequestIndex < schedule.size() && schedule[nextRequestIndex].GetTime() <= time) {
+        const ECElevatorSimRequest &request = schedule[nextRequestIndex++];
+        ActivateRequest(request.GetTime(), request.GetFloorSrc(), request.GetFloorDest());
+    }
+
+    int numCars = controller.GetNumCars();
+    for (int car = 0; car < numCars; ++car) {
+        ServeFloor(car, time);
+    }
+    for (int car = 0; car < numCars; ++car) {
+        int floorBefore = controller.GetCarFloor(car);
+        if (controller.Advance(car) != floorBefore) {
+            totalMoves++;
+        }
+    }
+}
+
+void ECGroupElevatorSim::PullLiveRequests(int time) {
+    if (liveSource == NULL) {
+        return;
+    }
+    liveSource->Poll();
+
+    // Late calls are stamped with this tick so they are not lost, as in ECElevatorSim
+    ECLiveRequest live;
+    while (liveSource->PopDue(time, live)) {
+        if (live.floorSrc < 1 || live.floorSrc > numFloors || live.floorDest < 1 ||
+            live.floorDest > numFloors || live.floorSrc == live.floorDest) {
+            liveSource->RecordRejected();
+            continue;
+        }
+        liveSource->RecordLag(time - live.time);
+        ActivateRequest(time, live.floorSrc, live.floorDest);
+    }
+}
+
+void ECGroupElevatorSim::ActivateRequest(int time, int floorSrc, int floorDest) {
+    auto start = std::chrono::steady_clock::now();
+    ECCallAssignment assignment = controller.Assign(floorSrc, floorDest);
+    auto end = std::chrono::steady_clock::now();
+    assignNanos.Add(static_cast<int>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    if (assignment.car < 0) {
+        return;
+    }
+
+    Passenger passenger = { time, -1, floorDest, assignment.pickupStop, assignment.dropoffStop };
+    waitingAt[Slot(assignment.car, floorSrc)].push_back(passenger);
+    totalRequests++;
+    numActiveCalls++;
+    maxActiveCalls = std::max(maxActiveCalls, numActiveCalls);
+}
+
+void ECGroupElevatorSim::ServeFloor(int car, int time) {
+    if (!controller.IsOpen(car)) {
+        return;
+    }
+    int floor = controller.GetCarFloor(car);
+    int currentStop = controller.GetCurrentStop(car);
+
+    std::vector<Passenger> &leaving = ridingTo[Slot(car, floor)];
+    for (const Passenger &rider : leaving) {
+        if (rider.dropoffStop != currentStop) {
+            controller.CancelDropoff(car, rider.dropoffStop);
+        }
+        rideTimes.Add(time - rider.timeBoard);
+    }
+    totalAlightings += leaving.size();
+    numActiveCalls -= static_cast<int>(leaving.size());
+    numRiders[car] -= static_cast<int>(leaving.size());
+    leaving.clear();
+
+    std::vector<Passenger> &boarding = waitingAt[Slot(car, floor)];
+    for (Passenger &passenger : boarding) {
+        if (passenger.pickupStop != currentStop) {
+            controller.CancelPickup(car, passenger.pickupStop);
+        }
+        waitTimes.Add(time - passenger.timeCall);
+        passenger.timeBoard = time;
+        ridingTo[Slot(car, passenger.floorDest)].push_back(passenger);
+    }
+    totalBoardings += boarding.size();
+    numRiders[car] += static_cast<int>(boarding.size());
+    boarding.clear();
+}
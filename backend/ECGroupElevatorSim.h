@@ -0,0 +1,97 @@
+#ifndef ECGROUPELEVATORSIM_H
+#define ECGROUPELEVATORSIM_H
+
+#include "ECElevatorSim1.h"
+#include "ECGroupController.h"
+#include "ECWaitHistogram.h"
+#include <vector>
+#include <memory>
+
+class ECLiveRequestSource;
+
+//*****************************************************************************
+// A building with several cars under destination dispatch. Each tick, like
+// ECElevatorSim: calls made this tick are given a car by ECGroupController,
+// then every car that is stopped lets its riders off and its assigned
+// passengers on, then each car stands out its dwell or moves one floor
+// towards its next planned stop.
+//
+// Passengers board the car they were given the first time it opens at their
+// floor, and riders leave at the first stop on their floor, even where the
+// plan had them at a later visit; the plan is told so the stop can be dropped.
+// A car passing a floor without stopping serves nobody there.
+// Requests must name floors 1..numFloors.
+class ECGroupElevatorSim
+{
+public:
+    ECGroupElevatorSim(int numFloorsIn, int numCarsIn, const std::vector<ECElevatorSimRequest> &requests);
+    // Share an already time-sorted request schedule with other simulators
+    ECGroupElevatorSim(int numFloorsIn, int numCarsIn, std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule);
+
+    ECElevatorStepResult Step() { return StepN(1); }
+    ECElevatorStepResult StepN(int numSteps);
+
+    // Live mode: pull hall calls from the source every tick (not owned; the caller paces the ticks)
+    void AttachLiveSource(ECLiveRequestSource *source) { liveSource = source; }
+    bool IsLive() const { return liveSource != NULL; }
+
+    ECGroupController &GetController() { return controller; }
+    const ECGroupController &GetController() const { return controller; }
+
+    int GetNumFloors() const { return numFloors; }
+    int GetNumCars() const { return controller.GetNumCars(); }
+    int GetCurrentTime() const { return currentTime; }
+    int GetCarFloor(int car) const { return controller.GetCarFloor(car); }
+    int GetNumRiders(int car) const { return numRiders[car]; }
+    int GetNumActiveCalls() const { return numActiveCalls; }   // assigned and not yet arrived
+    int GetMaxActiveCalls() const { return maxActiveCalls; }
+
+    // Running statistics
+    const ECWaitHistogram &GetWaitTimes() const { return waitTimes; }    // ticks from hall call to boarding
+    const ECWaitHistogram &GetRideTimes() const { return rideTimes; }    // ticks from boarding to arrival
+    const ECWaitHistogram &GetAssignNanos() const { return assignNanos; }   // wall-clock time per assignment
+    long long GetTotalRequests() const { return totalRequests; }
+    long long GetTotalBoardings() const { return totalBoardings; }
+    long long GetTotalAlightings() const { return totalAlightings; }
+    long long GetTotalMoves() const { return totalMoves; }
+
+private:
+    struct Passenger
+    {
+        int timeCall;
+        int timeBoard;
+        int floorDest;
+        int pickupStop;    // ids in the car's plan
+        int dropoffStop;
+    };
+
+    void RunTick(int time);
+    void PullLiveRequests(int time);
+    void ActivateRequest(int time, int floorSrc, int floorDest);
+    void ServeFloor(int car, int time);
+    bool AllRequestsHandled() const;
+    int Slot(int car, int floor) const { return car * (numFloors + 1) + floor; }
+
+    int numFloors;
+    int currentTime;
+    ECGroupController controller;
+    std::shared_ptr<const std::vector<ECElevatorSimRequest> > requestSchedule;
+    size_t nextRequestIndex;
+    ECLiveRequestSource *liveSource;               // not owned; NULL unless running live
+
+    std::vector<std::vector<Passenger> > waitingAt;   // per car and floor: passengers given that car there
+    std::vector<std::vector<Passenger> > ridingTo;    // per car and floor: riders getting off there
+    std::vector<int> numRiders;
+    int numActiveCalls;
+    int maxActiveCalls;
+
+    ECWaitHistogram waitTimes;
+    ECWaitHistogram rideTimes;
+    ECWaitHistogram assignNanos;
+    long long totalRequests;
+    long long totalBoardings;
+    long long totalAlightings;
+    long long totalMoves;
+};
+
+#endif /* ECGROUPELEVATORSIM_H */
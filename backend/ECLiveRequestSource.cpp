@@ -0,0 +1,290 @@
+#include "ECLiveRequestSource.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+const int READ_CHUNK = 4096;    // bytes read per system call
+const int MAX_LINE = 4096;      // text lines this long or longer are rejected
+
+// Parse an integer in [p, end), skipping blanks; no allocation, unlike a stringstream
+bool ParseInt(const char *&p, const char *end, int &value) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > 2147483647LL) {
+            return false;   // out of range; the whole line is rejected
+        }
+    }
+    value = static_cast<int>(negative ? -v : v);
+    return true;
+}
+}
+
+ECLiveRequestSource::ECLiveRequestSource(const std::string &pathIn, int capacityIn, EC_LIVE_OVERLOAD_POLICY policyIn)
+    : path(pathIn), policy(policyIn), fdListen(-1), fdFifo(-1), fOwnSocketPath(false),
+      fHadWriter(false), fFifoHungUp(false), queue(capacityIn > 0 ? capacityIn : 1), queueHead(0), queueCount(0) {}
+
+ECLiveRequestSource::~ECLiveRequestSource() {
+    Close();
+}
+
+bool ECLiveRequestSource::Open() {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISFIFO(st.st_mode)) {
+        // Named pipe: keep the read end open for the whole run so writers may come and go
+        fdFifo = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fdFifo < 0) {
+            std::cerr << "Error: Could not open FIFO " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        Connection conn;
+        conn.fd = fdFifo;
+        conn.fEof = false;
+        conn.fSkipLine = false;
+        conn.pending.reserve(2 * READ_CHUNK);
+        connections.push_back(conn);
+        return true;
+    }
+
+    // Otherwise listen on a Unix domain socket at the path
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << path << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    fdListen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fdListen < 0) {
+        std::cerr << "Error: Could not create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    unlink(path.c_str());
+    if (bind(fdListen, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fdListen, 8) < 0) {
+        std::cerr << "Error: Could not listen on " << path << ": " << strerror(errno) << std::endl;
+        close(fdListen);
+        fdListen = -1;
+        return false;
+    }
+    fcntl(fdListen, F_SETFL, fcntl(fdListen, F_GETFL) | O_NONBLOCK);
+    fOwnSocketPath = true;
+    return true;
+}
+
+void ECLiveRequestSource::Close() {
+    // Calls still buffered cannot be delivered any more; parse them so they are counted as dropped
+    EC_LIVE_OVERLOAD_POLICY savedPolicy = policy;
+    policy = EC_LIVE_DROP_NEWEST;
+    for (size_t i = 0; i < connections.size(); ++i) {
+        connections[i].fEof = true;
+        ParseRecords(connections[i]);
+        close(connections[i].fd);
+    }
+    policy = savedPolicy;
+    connections.clear();
+    fdFifo = -1;
+
+    if (fdListen >= 0) {
+        close(fdListen);
+        fdListen = -1;
+    }
+    if (fOwnSocketPath) {
+        unlink(path.c_str());
+        fOwnSocketPath = false;
+    }
+}
+
+void ECLiveRequestSource::Poll() {
+    // Accept any writers that connected since the last tick
+    if (fdListen >= 0) {
+        int fd;
+        while ((fd = accept(fdListen, NULL, NULL)) >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            Connection conn;
+            conn.fd = fd;
+            conn.fEof = false;
+            conn.fSkipLine = false;
+            conn.pending.reserve(2 * READ_CHUNK);
+            connections.push_back(conn);
+            fHadWriter = true;
+        }
+    }
+
+    auto it = connections.begin();
+    while (it != connections.end()) {
+        if (!ReadFrom(*it)) {
+            it->fEof = true;
+        }
+        ParseRecords(*it);
+
+        // A writer that hung up is kept until all it sent has been queued. Socket clients are
+        // then dropped; the FIFO stays open for the next writer.
+        if (it->fEof && it->pending.empty()) {
+            if (it->fd != fdFifo) {
+                close(it->fd);
+                it = connections.erase(it);
+                continue;
+            }
+            fFifoHungUp = fHadWriter;
+            it->fEof = false;
+        }
+        ++it;
+    }
+}
+
+bool ECLiveRequestSource::HasEnded() const {
+    if (!fHadWriter || queueCount > 0) {
+        return false;
+    }
+    return fdFifo >= 0 ? fFifoHungUp : connections.empty();
+}
+
+bool ECLiveRequestSource::ReadFrom(Connection &conn) {
+    char buf[READ_CHUNK];
+
+    // Under the blocking policy leave data in the kernel while we are full; the writer then stalls
+    while (conn.pending.size() < static_cast<size_t>(READ_CHUNK)) {
+        if (policy == EC_LIVE_BLOCK && IsFull()) {
+            return !conn.fEof;
+        }
+        ssize_t n = read(conn.fd, buf, sizeof(buf));
+        if (n > 0) {
+            fHadWriter = true;
+            if (conn.fd == fdFifo) {
+                fFifoHungUp = false;
+            }
+            conn.pending.append(buf, n);
+            ParseRecords(conn);
+        } else if (n == 0) {
+            return false;   // writer closed its end
+        } else {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+    }
+    return true;
+}
+
+void ECLiveRequestSource::ParseRecords(Connection &conn) {
+    size_t pos = 0;
+    while (pos < conn.pending.size()) {
+        if (conn.fSkipLine) {
+            size_t eol = conn.pending.find('\n', pos);
+            pos = eol == std::string::npos ? conn.pending.size() : eol + 1;
+            conn.fSkipLine = eol == std::string::npos;
+            continue;
+        }
+        if (policy == EC_LIVE_BLOCK && IsFull()) {
+            break;
+        }
+
+        unsigned int magic = 0;
+        if (conn.pending.size() - pos >= sizeof(magic)) {
+            memcpy(&magic, conn.pending.data() + pos, sizeof(magic));
+        }
+
+        if (magic == EC_LIVE_FRAME_MAGIC) {
+            // Binary frame
+            if (conn.pending.size() - pos < static_cast<size_t>(EC_LIVE_FRAME_SIZE)) {
+                if (conn.fEof) {
+                    stats.rejected++;   // cut off by the writer hanging up
+                    pos = conn.pending.size();
+                }
+                break;
+            }
+            int fields[3];
+            memcpy(fields, conn.pending.data() + pos + sizeof(magic), sizeof(fields));
+            pos += EC_LIVE_FRAME_SIZE;
+
+            ECLiveRequest request = { fields[0], fields[1], fields[2] };
+            stats.received++;
+            Enqueue(request);
+            continue;
+        }
+        if (conn.pending[pos] == 'E' && conn.pending.size() - pos < sizeof(magic) && !conn.fEof) {
+            break;  // possibly the start of a frame that has not fully arrived
+        }
+
+        // Text line; at end of stream the last one needs no newline
+        size_t eol = conn.pending.find('\n', pos);
+        if (eol == std::string::npos) {
+            if (conn.pending.size() - pos >= static_cast<size_t>(MAX_LINE)) {
+                stats.rejected++;
+                conn.fSkipLine = true;
+                pos = conn.pending.size();
+                break;
+            }
+            if (!conn.fEof) {
+                break;
+            }
+            eol = conn.pending.size();
+        }
+        const char *p = conn.pending.data() + pos;
+        const char *end = conn.pending.data() + eol;
+        pos = eol < conn.pending.size() ? eol + 1 : eol;
+
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        if (p == end || *p == '#') {
+            continue;   // skip comments and empty lines
+        }
+
+        ECLiveRequest request;
+        if (ParseInt(p, end, request.time) && ParseInt(p, end, request.floorSrc) && ParseInt(p, end, request.floorDest)) {
+            stats.received++;
+            Enqueue(request);
+        } else {
+            stats.rejected++;
+        }
+    }
+    conn.pending.erase(0, pos);
+}
+
+bool ECLiveRequestSource::Enqueue(const ECLiveRequest &request) {
+    if (IsFull()) {
+        stats.dropped++;
+        return false;
+    }
+    queue[(queueHead + queueCount) % queue.size()] = request;
+    queueCount++;
+    if (queueCount > stats.queueHighWater) {
+        stats.queueHighWater = queueCount;
+    }
+    return true;
+}
+
+bool ECLiveRequestSource::PopDue(int time, ECLiveRequest &request) {
+    // Calls are delivered in stream order; a call stamped in the future holds back the rest
+    if (queueCount == 0 || queue[queueHead].time > time) {
+        return false;
+    }
+    request = queue[queueHead];
+    queueHead = (queueHead + 1) % queue.size();
+    queueCount--;
+    return true;
+}
+
+void ECLiveRequestSource::RecordLag(int ticks) {
+    if (ticks <= 0) {
+        return;
+    }
+    stats.lagged++;
+    if (ticks > stats.maxLagTicks) {
+        stats.maxLagTicks = ticks;
+    }
+}
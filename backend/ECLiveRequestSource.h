@@ -0,0 +1,113 @@
+#ifndef ECLIVEREQUESTSOURCE_H
+#define ECLIVEREQUESTSOURCE_H
+
+#include <string>
+#include <vector>
+
+//*****************************************************************************
+// A hall call received from a live source (same fields as an input file line)
+struct ECLiveRequest
+{
+    int time;       // tick the call was made at
+    int floorSrc;   // floor the passenger is waiting at
+    int floorDest;  // floor the passenger wants to go to
+};
+
+//*****************************************************************************
+// Binary frame layout (host byte order): magic, time, src, dest
+const unsigned int EC_LIVE_FRAME_MAGIC = 0x51524345;   // "ECRQ" in memory on little endian
+const int EC_LIVE_FRAME_SIZE = 16;
+
+//*****************************************************************************
+// What to do when the bounded queue is full
+typedef enum {
+    EC_LIVE_DROP_NEWEST = 0,    // keep reading, discard calls that do not fit (counted as dropped)
+    EC_LIVE_BLOCK               // stop reading; the kernel buffer fills and the writer blocks
+} EC_LIVE_OVERLOAD_POLICY;
+
+//*****************************************************************************
+// Counters describing how the live feed kept up
+struct ECLiveSourceStats
+{
+    ECLiveSourceStats() : received(0), dropped(0), rejected(0), lagged(0), maxLagTicks(0), queueHighWater(0) {}
+
+    long long received;      // well-formed calls read from the stream
+    long long dropped;       // calls discarded because the queue was full, or still unread at Close
+    long long rejected;      // malformed or overlong lines, cut-off frames, calls for floors outside the building
+    long long lagged;        // calls activated after the tick they were stamped with
+    int maxLagTicks;         // worst lag seen so far
+    int queueHighWater;      // most calls ever queued at once
+};
+
+//*****************************************************************************
+// Live request source: hall calls streamed over a named pipe (FIFO) or a
+// Unix domain stream socket. If the path is an existing FIFO it is read;
+// otherwise a socket is created at the path and any number of local writers
+// may connect. Each record is either a text line "time src dest" (the input
+// file format, '#' comments allowed) or a binary frame as laid out above.
+//
+// Everything is non-blocking: Poll() moves whatever bytes have arrived into
+// a bounded queue, and the simulator drains calls that are due every tick.
+// Under EC_LIVE_BLOCK a writer that hangs up is kept until every call it sent
+// has been queued; a last line without a newline still counts as a call.
+// The feed has ended once some writer has connected, every writer has hung
+// up and the queue is empty; a new writer starts it again.
+class ECLiveRequestSource
+{
+public:
+    ECLiveRequestSource(const std::string &pathIn, int capacityIn = 4096, EC_LIVE_OVERLOAD_POLICY policyIn = EC_LIVE_DROP_NEWEST);
+    ~ECLiveRequestSource();
+
+    // Open the FIFO or start listening on the socket; false on failure
+    bool Open();
+    void Close();
+    bool IsOpen() const { return fdListen >= 0 || fdFifo >= 0; }
+    bool HasEnded() const;
+
+    // Read everything currently available without blocking
+    void Poll();
+
+    // Pop the next call stamped at or before time; false if none is due
+    bool PopDue(int time, ECLiveRequest &request);
+
+    // Bookkeeping used by the simulator when it accepts or refuses a call
+    void RecordLag(int ticks);
+    void RecordRejected() { stats.rejected++; }
+
+    int GetQueuedCount() const { return queueCount; }
+    int GetCapacity() const { return static_cast<int>(queue.size()); }
+    const ECLiveSourceStats &GetStats() const { return stats; }
+    const std::string &GetPath() const { return path; }
+
+private:
+    // A connected writer and the bytes of its incomplete record
+    struct Connection
+    {
+        int fd;
+        std::string pending;
+        bool fEof;          // the writer has closed its end; pending is all there will be
+        bool fSkipLine;     // discarding the rest of an overlong line
+    };
+
+    bool ReadFrom(Connection &conn);    // false once the writer has gone away
+    void ParseRecords(Connection &conn);
+    bool Enqueue(const ECLiveRequest &request);
+    bool IsFull() const { return queueCount == static_cast<int>(queue.size()); }
+
+    std::string path;
+    EC_LIVE_OVERLOAD_POLICY policy;
+    int fdListen;                         // listening socket, or -1
+    int fdFifo;                           // FIFO read end, or -1
+    bool fOwnSocketPath;                  // remove the socket file on close
+    std::vector<Connection> connections;  // FIFO or accepted socket clients
+    bool fHadWriter;                      // some writer has connected (or written to the FIFO)
+    bool fFifoHungUp;                     // the last FIFO writer has closed and all it sent is parsed
+
+    std::vector<ECLiveRequest> queue;     // fixed size ring buffer
+    int queueHead;
+    int queueCount;
+
+    ECLiveSourceStats stats;
+};
+
+#endif /* ECLIVEREQUESTSOURCE_H */
@@ -0,0 +1,152 @@
+#include "ECReplicationRunner.h"
+#include "ECTrafficGenerator.h"
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+namespace {
+// Inverse of the standard normal CDF (Acklam's rational approximation, relative error below 1.2e-9)
+double NormalQuantile(double p) {
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00 };
+    const double low = 0.02425;
+    if (p < low) {
+        double q = sqrt(-2 * log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - low) {
+        return -NormalQuantile(1 - p);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+}
+
+//*****************************************************************************
+// Statistics
+
+double ECStudentT(double confidence, int degreesOfFreedom) {
+    if (degreesOfFreedom < 1) {
+        return 0.0;
+    }
+    double z = NormalQuantile(0.5 + confidence / 2);
+    if (degreesOfFreedom == 1) {
+        return tan(acos(-1.0) * confidence / 2);   // Cauchy
+    }
+    if (degreesOfFreedom == 2) {
+        double p = confidence;
+        return p * sqrt(2.0 / (1 - p * p));
+    }
+    // Cornish-Fisher expansion about the normal quantile; within 0.5% from 3 degrees of freedom
+    double n = degreesOfFreedom;
+    double z2 = z * z;
+    double z3 = z2 * z, z5 = z3 * z2, z7 = z5 * z2, z9 = z7 * z2;
+    return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n) +
+           (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n) +
+           (79 * z9 + 776 * z7 + 1482 * z5 - 1920 * z3 - 945 * z) / (92160 * n * n * n * n);
+}
+
+double ECRunningStats::GetHalfWidth(double confidence) const {
+    if (count < 2) {
+        return 0.0;
+    }
+    return ECStudentT(confidence, count - 1) * sqrt(GetVariance() / count);
+}
+
+//*****************************************************************************
+// Runner
+
+ECReplicationRunner::ECReplicationRunner(const std::vector<std::string> &variantNamesIn,
+                                         const std::vector<std::string> &metricNamesIn, ECReplicationFunc runIn)
+    : variantNames(variantNamesIn), metricNames(metricNamesIn), run(runIn), numRuns(0), fPrecise(false), confidence(0.95) {}
+
+bool ECReplicationRunner::CheckPrecision(double relativePrecision) const {
+    for (int metric = 0; metric < GetNumMetrics(); ++metric) {
+        // With two variants the difference is what must be known well, to the same share of the baseline
+        const ECRunningStats &target = GetNumVariants() == 2 ? differences[metric] : stats[0][metric];
+        double scale = fabs(stats[0][metric].GetMean());
+        if (target.GetHalfWidth(confidence) > relativePrecision * scale) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ECReplicationRunner::Run(const ECReplicationOptions &options, ECProgressFunc progress) {
+    int numVariants = GetNumVariants();
+    int numMetrics = GetNumMetrics();
+    stats.assign(numVariants, std::vector<ECRunningStats>(numMetrics));
+    differences.assign(numMetrics, ECRunningStats());
+    numRuns = 0;
+    fPrecise = false;
+    confidence = options.confidence;
+
+    std::mutex lock;
+    std::map<int, std::vector<std::vector<double> > > finished;   // replications done out of order, by index
+    std::atomic<int> nextReplication(0);
+    std::atomic<bool> fStop(false);
+
+    auto worker = [&]() {
+        while (!fStop) {
+            int replication = nextReplication.fetch_add(1);
+            if (replication >= options.maxRuns) {
+                return;
+            }
+            std::vector<std::vector<double> > metrics(numVariants, std::vector<double>(numMetrics, 0.0));
+            for (int variant = 0; variant < numVariants; ++variant) {
+                int stream = options.fCommonRandomNumbers ? replication : replication * numVariants + variant;
+                run(variant, ECTrafficGenerator::StreamSeed(options.seed, stream), metrics[variant]);
+            }
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (fStop) {
+                return;   // too late: the answer is already fixed
+            }
+            finished[replication].swap(metrics);
+            // Fold in replication order, checking the stopping rule after each one
+            while (!fStop && !finished.empty() && finished.begin()->first == numRuns) {
+                const std::vector<std::vector<double> > &next = finished.begin()->second;
+                for (int variant = 0; variant < numVariants; ++variant) {
+                    for (int metric = 0; metric < numMetrics; ++metric) {
+                        stats[variant][metric].Add(next[variant][metric]);
+                    }
+                }
+                if (numVariants == 2) {
+                    for (int metric = 0; metric < numMetrics; ++metric) {
+                        differences[metric].Add(next[1][metric] - next[0][metric]);
+                    }
+                }
+                finished.erase(finished.begin());
+                numRuns++;
+                fPrecise = numRuns >= std::max(options.minRuns, 2) && CheckPrecision(options.relativePrecision);
+                if (progress) {
+                    progress(*this);
+                }
+                if (fPrecise || numRuns >= options.maxRuns) {
+                    fStop = true;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < std::max(options.numThreads, 1); ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
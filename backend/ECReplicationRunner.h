@@ -0,0 +1,98 @@
+#ifndef ECREPLICATIONRUNNER_H
+#define ECREPLICATIONRUNNER_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+//*****************************************************************************
+// Running mean and variance (Welford), with a Student-t confidence interval
+class ECRunningStats
+{
+public:
+    ECRunningStats() : count(0), mean(0), sumSquares(0) {}
+
+    void Add(double value) {
+        count++;
+        double delta = value - mean;
+        mean += delta / count;
+        sumSquares += delta * (value - mean);
+    }
+    int GetCount() const { return count; }
+    double GetMean() const { return mean; }
+    double GetVariance() const { return count > 1 ? sumSquares / (count - 1) : 0.0; }
+    double GetHalfWidth(double confidence) const;   // of the interval for the mean; 0 with fewer than two values
+
+private:
+    int count;
+    double mean;
+    double sumSquares;
+};
+
+// Two-sided Student-t quantile for the given confidence and degrees of freedom
+double ECStudentT(double confidence, int degreesOfFreedom);
+
+//*****************************************************************************
+// Runs independent replications of one or two variants (configurations) until
+// the confidence intervals are tight enough. Replications run in parallel; the
+// results are folded in replication order, and after each one the stopping rule
+// is checked, so the answer does not depend on the number of threads.
+//
+// Replication i of every variant gets the same seed (common random numbers),
+// so with two variants the per-replication differences cancel most of the
+// noise the variants share and the difference needs far fewer replications.
+// With fCommonRandomNumbers off each variant gets its own seeds.
+struct ECReplicationOptions
+{
+    ECReplicationOptions() : relativePrecision(0.02), confidence(0.95), minRuns(5), maxRuns(1000), numThreads(1),
+                             seed(1), fCommonRandomNumbers(true) {}
+
+    double relativePrecision;    // stop when every half-width is within this share of the baseline mean
+    double confidence;
+    int minRuns;
+    int maxRuns;
+    int numThreads;
+    uint64_t seed;
+    bool fCommonRandomNumbers;
+};
+
+class ECReplicationRunner
+{
+public:
+    // Runs one replication of variant with the given seed; fills one value per metric
+    typedef std::function<void(int variant, uint64_t seed, std::vector<double> &metrics)> ECReplicationFunc;
+    // Called after each replication is folded in
+    typedef std::function<void(const ECReplicationRunner &runner)> ECProgressFunc;
+
+    ECReplicationRunner(const std::vector<std::string> &variantNamesIn, const std::vector<std::string> &metricNamesIn,
+                        ECReplicationFunc runIn);
+
+    void Run(const ECReplicationOptions &options, ECProgressFunc progress = ECProgressFunc());
+
+    int GetNumVariants() const { return static_cast<int>(variantNames.size()); }
+    int GetNumMetrics() const { return static_cast<int>(metricNames.size()); }
+    const std::string &GetVariantName(int variant) const { return variantNames[variant]; }
+    const std::string &GetMetricName(int metric) const { return metricNames[metric]; }
+
+    int GetNumRuns() const { return numRuns; }
+    bool IsPrecise() const { return fPrecise; }
+    double GetConfidence() const { return confidence; }
+    const ECRunningStats &GetStats(int variant, int metric) const { return stats[variant][metric]; }
+    // Second variant minus the first, replication by replication
+    const ECRunningStats &GetDifference(int metric) const { return differences[metric]; }
+
+private:
+    bool CheckPrecision(double relativePrecision) const;
+
+    std::vector<std::string> variantNames;
+    std::vector<std::string> metricNames;
+    ECReplicationFunc run;
+    std::vector<std::vector<ECRunningStats> > stats;   // [variant][metric]
+    std::vector<ECRunningStats> differences;           // [metric]
+    int numRuns;
+    bool fPrecise;
+    double confidence;
+};
+
+#endif /* ECREPLICATIONRUNNER_H */
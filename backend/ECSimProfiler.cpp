@@ -0,0 +1,137 @@
+#include "ECSimProfiler.h"
+#include <chrono>
+#if defined(EC_SIM_PROFILE_TSC) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define EC_SIM_USE_TSC 1
+#endif
+
+namespace {
+const char *PHASE_NAMES[EC_NUM_PHASES] = {
+    "ProcessIncomingRequests", "HandlePassengers", "UpdateDirection", "ExecuteMove", "WriteOutput"
+};
+const char *COUNTER_NAMES[EC_NUM_COUNTERS] = {
+    "boardings", "alightings", "stops", "direction_reversals"
+};
+
+ECSimProfileSlot slots[ECSimProfiler::MAX_THREADS];
+ECSimProfileSlot overflowSlot;   // shared by the threads beyond MAX_THREADS
+std::atomic<int> numSlotsClaimed(0);
+thread_local ECSimProfileSlot *threadSlot = NULL;
+
+unsigned long long SteadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Reference points for converting TSC cycles to nanoseconds
+const unsigned long long startNanos = SteadyNanos();
+const unsigned long long startTicks = ECSimProfiler::Now();
+
+// Only the owning thread writes its own slot, so a relaxed load and store is enough there;
+// the shared overflow slot needs a real atomic add
+void Accumulate(std::atomic<unsigned long long> &value, unsigned long long n) {
+    if (threadSlot == &overflowSlot) {
+        value.fetch_add(n, std::memory_order_relaxed);
+    } else {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+void AddSlot(const ECSimProfileSlot &slot, unsigned long long *calls, unsigned long long *ticks, unsigned long long *counters) {
+    for (int p = 0; p < EC_NUM_PHASES; ++p) {
+        calls[p] += slot.phaseCalls[p].load(std::memory_order_relaxed);
+        ticks[p] += slot.phaseTicks[p].load(std::memory_order_relaxed);
+    }
+    for (int c = 0; c < EC_NUM_COUNTERS; ++c) {
+        counters[c] += slot.counters[c].load(std::memory_order_relaxed);
+    }
+}
+}
+
+unsigned long long ECSimProfiler::Now() {
+#ifdef EC_SIM_USE_TSC
+    return __rdtsc();
+#else
+    return SteadyNanos();
+#endif
+}
+
+ECSimProfileSlot *ECSimProfiler::GetThreadSlot() {
+    if (threadSlot == NULL) {
+        int index = numSlotsClaimed.fetch_add(1, std::memory_order_relaxed);
+        threadSlot = index < MAX_THREADS ? &slots[index] : &overflowSlot;
+    }
+    return threadSlot;
+}
+
+void ECSimProfiler::AddPhase(EC_SIM_PHASE phase, unsigned long long ticks) {
+    ECSimProfileSlot *slot = GetThreadSlot();
+    Accumulate(slot->phaseCalls[phase], 1);
+    Accumulate(slot->phaseTicks[phase], ticks);
+}
+
+void ECSimProfiler::Count(EC_SIM_COUNTER counter, unsigned long long n) {
+    Accumulate(GetThreadSlot()->counters[counter], n);
+}
+
+double ECSimProfiler::GetNanosPerTick() {
+#ifdef EC_SIM_USE_TSC
+    unsigned long long ticks = Now() - startTicks;
+    return ticks > 0 ? static_cast<double>(SteadyNanos() - startNanos) / ticks : 0.0;
+#else
+    return 1.0;
+#endif
+}
+
+void ECSimProfiler::WriteJSON(std::ostream &os) {
+    int numThreads = numSlotsClaimed.load();
+    // Per-thread entries: one per private slot, then the overflow slot if anyone shares it
+    int numEntries = numThreads > MAX_THREADS ? MAX_THREADS + 1 : numThreads;
+    double nanosPerTick = GetNanosPerTick();
+
+    unsigned long long totalCalls[EC_NUM_PHASES] = { 0 };
+    unsigned long long totalTicks[EC_NUM_PHASES] = { 0 };
+    unsigned long long totalCounters[EC_NUM_COUNTERS] = { 0 };
+    for (int t = 0; t < numEntries; ++t) {
+        AddSlot(t < MAX_THREADS ? slots[t] : overflowSlot, totalCalls, totalTicks, totalCounters);
+    }
+
+#ifdef EC_SIM_USE_TSC
+    os << "{\n  \"clock\": \"tsc\",\n";
+#else
+    os << "{\n  \"clock\": \"steady_clock\",\n";
+#endif
+    os << "  \"threads\": " << numThreads << ",\n";
+
+    os << "  \"phases\": {\n";
+    for (int p = 0; p < EC_NUM_PHASES; ++p) {
+        double totalNanos = totalTicks[p] * nanosPerTick;
+        os << "    \"" << PHASE_NAMES[p] << "\": { \"calls\": " << totalCalls[p]
+           << ", \"total_ns\": " << static_cast<unsigned long long>(totalNanos)
+           << ", \"mean_ns\": " << (totalCalls[p] ? totalNanos / totalCalls[p] : 0.0) << " }"
+           << (p + 1 < EC_NUM_PHASES ? "," : "") << "\n";
+    }
+    os << "  },\n";
+
+    os << "  \"counters\": {\n";
+    for (int c = 0; c < EC_NUM_COUNTERS; ++c) {
+        os << "    \"" << COUNTER_NAMES[c] << "\": " << totalCounters[c] << (c + 1 < EC_NUM_COUNTERS ? "," : "") << "\n";
+    }
+    os << "  },\n";
+
+    os << "  \"per_thread\": [\n";
+    for (int t = 0; t < numEntries; ++t) {
+        const ECSimProfileSlot &slot = t < MAX_THREADS ? slots[t] : overflowSlot;
+        os << "    { " << (t < MAX_THREADS ? "" : "\"shared\": true, ") << "\"phase_ns\": [";
+        for (int p = 0; p < EC_NUM_PHASES; ++p) {
+            os << static_cast<unsigned long long>(slot.phaseTicks[p].load(std::memory_order_relaxed) * nanosPerTick)
+               << (p + 1 < EC_NUM_PHASES ? ", " : "");
+        }
+        os << "], \"counters\": [";
+        for (int c = 0; c < EC_NUM_COUNTERS; ++c) {
+            os << slot.counters[c].load(std::memory_order_relaxed) << (c + 1 < EC_NUM_COUNTERS ? ", " : "");
+        }
+        os << "] }" << (t + 1 < numEntries ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
@@ -0,0 +1,85 @@
+#ifndef ECSIMPROFILER_H
+#define ECSIMPROFILER_H
+
+#include <atomic>
+#include <ostream>
+
+//*****************************************************************************
+// Hot-path instrumentation for the simulator. Build with -DEC_SIM_PROFILE to
+// enable it (add -DEC_SIM_PROFILE_TSC on x86 to time with the TSC instead of
+// steady_clock); otherwise the macros below expand to nothing.
+//
+// Each thread accumulates into its own slot, written only by that thread and
+// padded to a cache line, so recording never takes a lock or contends on a
+// cache line. Threads beyond MAX_THREADS share one overflow slot, updated
+// with atomic adds.
+
+// Timed phases of a simulation tick
+typedef enum {
+    EC_PHASE_INCOMING = 0,      // ProcessIncomingRequests (and live input)
+    EC_PHASE_PASSENGERS,        // HandlePassengers
+    EC_PHASE_DIRECTION,         // UpdateDirection
+    EC_PHASE_MOVE,              // ExecuteMove
+    EC_PHASE_OUTPUT,            // writing the trace file
+    EC_NUM_PHASES
+} EC_SIM_PHASE;
+
+// Event counters
+typedef enum {
+    EC_COUNT_BOARDINGS = 0,
+    EC_COUNT_ALIGHTINGS,
+    EC_COUNT_STOPS,             // ticks in which anyone boarded or alighted
+    EC_COUNT_REVERSALS,         // car switched between up and down
+    EC_NUM_COUNTERS
+} EC_SIM_COUNTER;
+
+//*****************************************************************************
+// One thread's accumulators, a whole number of cache lines
+struct alignas(64) ECSimProfileSlot
+{
+    std::atomic<unsigned long long> phaseCalls[EC_NUM_PHASES];
+    std::atomic<unsigned long long> phaseTicks[EC_NUM_PHASES];
+    std::atomic<unsigned long long> counters[EC_NUM_COUNTERS];
+};
+
+class ECSimProfiler
+{
+public:
+    static const int MAX_THREADS = 256;
+
+    // Current time in clock ticks (TSC cycles or nanoseconds)
+    static unsigned long long Now();
+
+    static void AddPhase(EC_SIM_PHASE phase, unsigned long long ticks);
+    static void Count(EC_SIM_COUNTER counter, unsigned long long n);
+
+    // Totals per phase and counter, plus a per-thread breakdown
+    static void WriteJSON(std::ostream &os);
+
+private:
+    static ECSimProfileSlot *GetThreadSlot();
+    static double GetNanosPerTick();
+};
+
+//*****************************************************************************
+// Times the enclosing scope as one call of a phase
+class ECSimPhaseTimer
+{
+public:
+    explicit ECSimPhaseTimer(EC_SIM_PHASE phaseIn) : phase(phaseIn), start(ECSimProfiler::Now()) {}
+    ~ECSimPhaseTimer() { ECSimProfiler::AddPhase(phase, ECSimProfiler::Now() - start); }
+
+private:
+    EC_SIM_PHASE phase;
+    unsigned long long start;
+};
+
+#ifdef EC_SIM_PROFILE
+#define EC_PROFILE_PHASE(phase) ECSimPhaseTimer ecProfilePhaseTimer(phase)
+#define EC_PROFILE_COUNT(counter, n) ECSimProfiler::Count(counter, n)
+#else
+#define EC_PROFILE_PHASE(phase) ((void)0)
+#define EC_PROFILE_COUNT(counter, n) ((void)0)
+#endif
+
+#endif /* ECSIMPROFILER_H */
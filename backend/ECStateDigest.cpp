@@ -0,0 +1,171 @@
+#include "ECStateDigest.h"
+#include <cstring>
+
+namespace {
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t HashValue(uint64_t hash, long long value) {
+    return (hash ^ static_cast<uint64_t>(value)) * FNV_PRIME;
+}
+
+// splitmix64 finalizer, so a one-bit change in a state spreads over the whole digest
+inline uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+const char *DirectionName(int direction) {
+    switch (direction) {
+        case 0: return "STOPPED";
+        case 1: return "UP";
+        case 2: return "DOWN";
+        default: return "UNKNOWN";
+    }
+}
+}
+
+//*****************************************************************************
+// Engine state
+
+void ECEngineState::Resize(int numFloorsIn) {
+    numFloors = numFloorsIn > 0 ? numFloorsIn : 0;
+    time = 0;
+    currentFloor = 1;
+    direction = 0;
+    requests = boardings = alightings = moves = waitTicksSum = 0;
+    waiting.assign(numFloors + 1, 0);
+    ridersTo.assign(numFloors + 1, 0);
+    stopRequested.assign(numFloors + 1, 0);
+}
+
+uint64_t ECEngineState::Hash() const {
+    uint64_t hash = FNV_OFFSET;
+    hash = HashValue(hash, numFloors);
+    hash = HashValue(hash, time);
+    hash = HashValue(hash, currentFloor);
+    hash = HashValue(hash, direction);
+    hash = HashValue(hash, requests);
+    hash = HashValue(hash, boardings);
+    hash = HashValue(hash, alightings);
+    hash = HashValue(hash, moves);
+    hash = HashValue(hash, waitTicksSum);
+    for (int floor = 1; floor <= numFloors; ++floor) {
+        // One word per floor: the counts cannot reach 2^31 in practice
+        long long word = (static_cast<long long>(waiting[floor]) << 32) ^ (static_cast<long long>(ridersTo[floor]) << 1) ^ stopRequested[floor];
+        hash = HashValue(hash, word);
+    }
+    return hash;
+}
+
+void ECEngineState::Dump(std::ostream &out) const {
+    out << "ticks run: " << time << "\n";
+    out << "car: floor " << currentFloor << ", " << DirectionName(direction) << "\n";
+    out << "requests: " << requests << "\n";
+    out << "boardings: " << boardings << "\n";
+    out << "alightings: " << alightings << "\n";
+    out << "moves: " << moves << "\n";
+    out << "wait ticks: " << waitTicksSum << "\n";
+    for (int floor = numFloors; floor >= 1; --floor) {
+        out << "floor " << floor << ": waiting " << waiting[floor] << ", riding here " << ridersTo[floor]
+            << (stopRequested[floor] ? ", stop requested" : "") << "\n";
+    }
+}
+
+//*****************************************************************************
+// Writer
+
+ECDigestWriter::ECDigestWriter(const std::string &pathIn, const std::string &engineNameIn)
+    : path(pathIn), engineName(engineNameIn), file(NULL), digest(FNV_OFFSET), numRecords(0) {}
+
+ECDigestWriter::~ECDigestWriter() {
+    Close();
+}
+
+bool ECDigestWriter::Open() {
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Error: Could not open digest file " << path << " for writing." << std::endl;
+        return false;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 16);
+    digest = FNV_OFFSET;
+    numRecords = 0;
+    return true;
+}
+
+void ECDigestWriter::Close() {
+    if (file != NULL) {
+        if (numRecords == 0) {
+            WriteHeader(0, 0);   // a run of no ticks still leaves a readable file
+        }
+        fclose(file);
+        file = NULL;
+    }
+}
+
+void ECDigestWriter::Record(const ECEngineState &state) {
+    if (file == NULL) {
+        return;
+    }
+    if (numRecords == 0) {
+        WriteHeader(state.numFloors, state.time - 1);   // the first state says where the run starts
+    }
+    digest = Mix(digest ^ state.Hash());
+    fwrite(&digest, sizeof(digest), 1, file);
+    numRecords++;
+}
+
+void ECDigestWriter::WriteHeader(int numFloors, int firstTick) {
+    ECDigestHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = EC_DIGEST_MAGIC;
+    header.version = EC_DIGEST_VERSION;
+    header.numFloors = numFloors;
+    header.firstTick = firstTick;
+    strncpy(header.engineName, engineName.c_str(), EC_DIGEST_ENGINE_NAME_LEN - 1);
+    fwrite(&header, sizeof(header), 1, file);
+}
+
+//*****************************************************************************
+// Reader
+
+bool ECDigestReader::Open(const std::string &path) {
+    Close();
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        std::cerr << "Error: Could not open digest file " << path << std::endl;
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != EC_DIGEST_MAGIC) {
+        std::cerr << "Error: " << path << " is not a digest file" << std::endl;
+        Close();
+        return false;
+    }
+    if (header.version != EC_DIGEST_VERSION) {
+        std::cerr << "Error: " << path << " has digest version " << header.version << ", expected " << EC_DIGEST_VERSION << std::endl;
+        Close();
+        return false;
+    }
+    header.engineName[EC_DIGEST_ENGINE_NAME_LEN - 1] = '\0';
+    return true;
+}
+
+void ECDigestReader::Close() {
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+bool ECDigestReader::Next(uint64_t &digestOut) {
+    return file != NULL && fread(&digestOut, sizeof(digestOut), 1, file) == 1;
+}
+
+std::string ECDigestReader::GetEngineName() const {
+    return std::string(header.engineName);
+}
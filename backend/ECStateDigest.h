@@ -0,0 +1,104 @@
+#ifndef ECSTATEDIGEST_H
+#define ECSTATEDIGEST_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+
+//*****************************************************************************
+// Engine-neutral state of one building after a tick: what every engine must
+// agree on to count as behaving the same. Vectors are indexed by floor
+// (entry 0 unused) and sized once, so filling one every tick never allocates.
+//
+// Standalone on purpose: the root floor-by-floor engine declares its own
+// request class and cannot include ECElevatorSim1.h.
+struct ECEngineState
+{
+    explicit ECEngineState(int numFloorsIn = 0) { Resize(numFloorsIn); }
+    void Resize(int numFloorsIn);
+
+    uint64_t Hash() const;
+    void Dump(std::ostream &out) const;   // readable, one fact per line
+
+    int numFloors;
+    int time;                   // ticks run so far
+    int currentFloor;
+    int direction;              // EC_ELEVATOR_DIR
+    long long requests;         // hall calls made so far
+    long long boardings;
+    long long alightings;
+    long long moves;
+    long long waitTicksSum;     // summed over boardings
+    std::vector<int> waiting;   // people waiting on each floor
+    std::vector<int> ridersTo;  // riders going to each floor
+    std::vector<unsigned char> stopRequested;
+};
+
+//*****************************************************************************
+// Digest stream: after every tick the engine hands over its state and the
+// writer folds the state's hash into a rolling 64-bit digest, which it
+// appends to a binary file. Two runs behaved the same up to tick t exactly
+// when their digests at t are equal (up to hash collisions), so the first
+// differing record is the first tick where the runs diverge.
+//
+// File: a header (magic, version, floors, first tick, engine name), then one
+// little-endian uint64_t per tick. 8 bytes a tick, buffered.
+const uint32_t EC_DIGEST_MAGIC = 0x47444345;   // "ECDG" on little endian
+const uint32_t EC_DIGEST_VERSION = 1;
+const int EC_DIGEST_ENGINE_NAME_LEN = 24;
+
+struct ECDigestHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t numFloors;
+    int32_t firstTick;          // tick of the first record
+    char engineName[EC_DIGEST_ENGINE_NAME_LEN];   // NUL padded
+};
+
+class ECDigestWriter
+{
+public:
+    ECDigestWriter(const std::string &pathIn, const std::string &engineNameIn);
+    ~ECDigestWriter();
+
+    bool Open();
+    void Close();
+    bool IsOpen() const { return file != NULL; }
+
+    // state.time must go up by one each call
+    void Record(const ECEngineState &state);
+    uint64_t GetDigest() const { return digest; }
+    int GetNumRecords() const { return numRecords; }
+
+private:
+    void WriteHeader(int numFloors, int firstTick);
+
+    std::string path;
+    std::string engineName;
+    FILE *file;
+    uint64_t digest;
+    int numRecords;
+};
+
+class ECDigestReader
+{
+public:
+    ECDigestReader() : file(NULL) {}
+    ~ECDigestReader() { Close(); }
+
+    bool Open(const std::string &path);
+    void Close();
+    bool Next(uint64_t &digestOut);   // false at the end of the file
+
+    const ECDigestHeader &GetHeader() const { return header; }
+    std::string GetEngineName() const;
+
+private:
+    FILE *file;
+    ECDigestHeader header;
+};
+
+#endif /* ECSTATEDIGEST_H */
@@ -0,0 +1,97 @@
+#include "ECSurrogateEstimator.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// Fitted against ECElevatorSim; see the class comment
+const double IDLE_TICKS = 1.0;        // the constant in the round-trip equation
+const double STOP_MERGE = 0.9;        // b: calls that land on an already planned stop
+const double WAIT_SHARE = 0.36;       // share of a round trip's stops a call waits through, tall buildings
+const double WAIT_SHARE_FLOORS = 2.5; // ... reduced by this many floors' worth in short ones
+const double P95_BASE = 1.0;
+const double P95_SCALE = 4.0;
+const double P95_SATURATED = 0.4;     // how much less the tail stretches at saturation
+}
+
+ECSurrogateInput::ECSurrogateInput(int numFloorsIn, int numCarsIn)
+    : numFloors(numFloorsIn), numCars(numCarsIn), callRates((numFloorsIn + 1) * (numFloorsIn + 1), 0.0) {}
+
+ECSurrogateInput ECSurrogateInput::FromTraffic(const ECTrafficConfig &traffic, int numCars) {
+    int numFloors = traffic.numFloors;
+    ECSurrogateInput input(numFloors, numCars);
+    if (numFloors < 2) {
+        return input;
+    }
+    for (int src = 1; src <= numFloors; ++src) {
+        double srcShare = (1 - traffic.lobbyShare) / numFloors + (src == 1 ? traffic.lobbyShare : 0.0);
+        for (int dest = 1; dest <= numFloors; ++dest) {
+            if (dest != src) {
+                input.SetRate(src, dest, traffic.callsPerTick * srcShare / (numFloors - 1));
+            }
+        }
+    }
+    return input;
+}
+
+ECSurrogateEstimate ECSurrogateEstimator::Estimate(const ECSurrogateInput &input) {
+    ECSurrogateEstimate estimate;
+    int numFloors = input.numFloors;
+    if (numFloors < 2) {
+        return estimate;
+    }
+    int numCars = std::max(input.numCars, 1);
+
+    // Calls per tick per car starting or ending at each floor, and the chance a call
+    // starts where the last one ended (where an idle car waits)
+    std::vector<double> floorRates(numFloors + 1, 0.0);
+    std::vector<double> srcRates(numFloors + 1, 0.0);
+    std::vector<double> destRates(numFloors + 1, 0.0);
+    double totalRate = 0;
+    for (int src = 1; src <= numFloors; ++src) {
+        for (int dest = 1; dest <= numFloors; ++dest) {
+            double rate = input.GetRate(src, dest) / numCars;
+            srcRates[src] += rate;
+            destRates[dest] += rate;
+            totalRate += rate;
+        }
+    }
+    if (totalRate <= 0) {
+        return estimate;
+    }
+    double sameFloor = 0;
+    for (int floor = 1; floor <= numFloors; ++floor) {
+        floorRates[floor] = srcRates[floor] + destRates[floor];
+        sameFloor += (srcRates[floor] / totalRate) * (destRates[floor] / totalRate);
+    }
+    double idleWait = 1.0 - sameFloor;
+
+    // Round trip by Newton's method on the concave right-hand side, from above, so it
+    // converges to the largest root without overshooting
+    double roundTrip = IDLE_TICKS + 2.0 * numFloors;
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        double value = IDLE_TICKS - roundTrip;
+        double slope = -1.0;
+        for (int floor = 1; floor <= numFloors; ++floor) {
+            double sweeps = (floor == 1 || floor == numFloors) ? 1.0 : 2.0;
+            double rate = STOP_MERGE * floorRates[floor] / sweeps;
+            double missed = exp(-rate * roundTrip);
+            value += sweeps * (1.0 - missed);
+            slope += sweeps * rate * missed;
+        }
+        double step = value / slope;
+        roundTrip -= step;
+        if (fabs(step) < 1e-6) {
+            break;
+        }
+    }
+
+    double stops = std::max(roundTrip - IDLE_TICKS, 0.0);
+    double waitShare = std::max(WAIT_SHARE * (1.0 - WAIT_SHARE_FLOORS / numFloors), 0.0);
+    double queueWait = waitShare * stops;
+    double saturation = std::min(stops / (2.0 * (numFloors - 1)), 1.0);
+
+    estimate.meanWait = idleWait + queueWait;
+    estimate.p95Wait = P95_BASE + P95_SCALE * queueWait * (1.0 - P95_SATURATED * saturation);
+    estimate.roundTrip = roundTrip;
+    return estimate;
+}
@@ -0,0 +1,62 @@
+#ifndef ECSURROGATEESTIMATOR_H
+#define ECSURROGATEESTIMATOR_H
+
+#include "ECTrafficGenerator.h"
+#include <vector>
+
+//*****************************************************************************
+// Demand seen by the estimator: calls per tick for each (source, destination)
+// pair, floors 1..numFloors, shared evenly by numCars cars.
+struct ECSurrogateInput
+{
+    ECSurrogateInput() : numFloors(0), numCars(1) {}
+    ECSurrogateInput(int numFloorsIn, int numCarsIn);
+
+    // The mix ECTrafficGenerator draws from
+    static ECSurrogateInput FromTraffic(const ECTrafficConfig &traffic, int numCars = 1);
+
+    double GetRate(int floorSrc, int floorDest) const { return callRates[floorSrc * (numFloors + 1) + floorDest]; }
+    void SetRate(int floorSrc, int floorDest, double callsPerTick) { callRates[floorSrc * (numFloors + 1) + floorDest] = callsPerTick; }
+
+    int numFloors;
+    int numCars;
+    std::vector<double> callRates;   // (numFloors+1)^2, row = source
+};
+
+struct ECSurrogateEstimate
+{
+    ECSurrogateEstimate() : meanWait(0), p95Wait(0), roundTrip(0) {}
+
+    double meanWait;     // ticks from hall call to boarding
+    double p95Wait;
+    double roundTrip;    // stops per car per round trip
+};
+
+//*****************************************************************************
+// Analytical stand-in for ECElevatorSim, for screening configurations before
+// simulating them; an estimate takes microseconds.
+//
+// The car stops one tick at each floor it serves and travel between stops is
+// free, so a round trip lasts as many ticks as it has stops. A floor adds a
+// stop to a sweep when at least one call starts or ends there during it, so
+// the round trip T solves
+//
+//     T = 1 + sum over floors f of  w_f (1 - exp(-b r_f T / w_f))
+//
+// with r_f the calls per tick starting or ending at f and w_f the sweeps that
+// pass f (one at the end floors, two elsewhere). A call waits one tick unless
+// the idle car already stands at its floor, plus a share of the stops in a
+// round trip that grows with the building height. The p95 wait scales the
+// queueing part of the mean, less so near saturation where waits are bounded
+// by a round trip.
+//
+// The constants were fitted against ECElevatorSim on generated traffic
+// (3 to 40 floors, 0.02 to 4 calls a tick); with more than one car the
+// calls are assumed split evenly, which no engine checks yet.
+class ECSurrogateEstimator
+{
+public:
+    static ECSurrogateEstimate Estimate(const ECSurrogateInput &input);
+};
+
+#endif /* ECSURROGATEESTIMATOR_H */
@@ -0,0 +1,128 @@
+#include "ECTelemetry.h"
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//*****************************************************************************
+// Writer
+
+ECTelemetryWriter::ECTelemetryWriter(const std::string &nameIn) : name(nameIn), layout(NULL) {}
+
+ECTelemetryWriter::~ECTelemetryWriter() {
+    Close();
+}
+
+bool ECTelemetryWriter::Open() {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Could not create shared memory segment " << name << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, sizeof(ECTelemetryLayout)) != 0) {
+        std::cerr << "Error: Could not size shared memory segment " << name << std::endl;
+        close(fd);
+        return false;
+    }
+    void *mapped = mmap(NULL, sizeof(ECTelemetryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map shared memory segment " << name << std::endl;
+        return false;
+    }
+
+    // The segment starts zeroed, so the sequence is already 0 (even)
+    layout = static_cast<ECTelemetryLayout *>(mapped);
+    layout->magic = EC_TELEMETRY_MAGIC;
+    layout->version = EC_TELEMETRY_VERSION;
+    layout->layoutSize = sizeof(ECTelemetryLayout);
+    layout->maxFloors = EC_TELEMETRY_MAX_FLOORS;
+    return true;
+}
+
+void ECTelemetryWriter::Close() {
+    if (layout != NULL) {
+        munmap(layout, sizeof(ECTelemetryLayout));
+        shm_unlink(name.c_str());
+        layout = NULL;
+    }
+}
+
+ECTelemetrySnapshot &ECTelemetryWriter::BeginUpdate() {
+    uint64_t sequence = layout->sequence.load(std::memory_order_relaxed);
+    layout->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return layout->payload;
+}
+
+void ECTelemetryWriter::EndUpdate() {
+    layout->payload.publishCount++;
+    layout->sequence.store(layout->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//*****************************************************************************
+// Reader
+
+ECTelemetryReader::ECTelemetryReader(const std::string &nameIn) : name(nameIn), layout(NULL) {}
+
+ECTelemetryReader::~ECTelemetryReader() {
+    Close();
+}
+
+bool ECTelemetryReader::Open() {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Error: No shared memory segment " << name << std::endl;
+        return false;
+    }
+    // A writer between creating the segment and sizing it leaves it short; mapping past the end would fault
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ECTelemetryLayout))) {
+        std::cerr << "Error: Shared memory segment " << name << " is not fully set up yet" << std::endl;
+        close(fd);
+        return false;
+    }
+    void *mapped = mmap(NULL, sizeof(ECTelemetryLayout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map shared memory segment " << name << std::endl;
+        return false;
+    }
+
+    layout = static_cast<const ECTelemetryLayout *>(mapped);
+    if (layout->magic != EC_TELEMETRY_MAGIC || layout->version != EC_TELEMETRY_VERSION ||
+        layout->layoutSize != sizeof(ECTelemetryLayout)) {
+        std::cerr << "Error: " << name << " is not a version " << EC_TELEMETRY_VERSION << " telemetry segment" << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ECTelemetryReader::Close() {
+    if (layout != NULL) {
+        munmap(const_cast<ECTelemetryLayout *>(layout), sizeof(ECTelemetryLayout));
+        layout = NULL;
+    }
+}
+
+bool ECTelemetryReader::Read(ECTelemetrySnapshot &snapshot) const {
+    if (layout == NULL) {
+        return false;
+    }
+    const int maxRetries = 1000;
+    for (int i = 0; i < maxRetries; ++i) {
+        uint64_t before = layout->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;   // writer is mid-update
+        }
+        memcpy(&snapshot, &layout->payload, sizeof(snapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (layout->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,95 @@
+#ifndef ECTELEMETRY_H
+#define ECTELEMETRY_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+//*****************************************************************************
+// Live simulator state in a POSIX shared-memory segment (shm_open), for
+// dashboards and other local processes. One simulator writes; any number of
+// readers map the segment read-only and poll it without system calls.
+//
+// The payload is guarded by a sequence lock: the writer makes the sequence odd,
+// updates the payload and makes it even again. A reader copies the payload and
+// keeps the copy only if the sequence was the same even number before and after.
+//
+// Layout changes bump EC_TELEMETRY_VERSION; readers refuse other versions.
+const uint32_t EC_TELEMETRY_MAGIC = 0x4d544345;   // "ECTM" in memory on little endian
+const uint32_t EC_TELEMETRY_VERSION = 1;
+const int EC_TELEMETRY_MAX_FLOORS = 256;
+
+// Everything a reader gets in one consistent snapshot
+struct ECTelemetrySnapshot
+{
+    int64_t publishCount;       // number of ticks published so far
+    int64_t time;               // simulation tick
+    int32_t numFloors;
+    int32_t currentFloor;
+    int32_t direction;          // EC_ELEVATOR_DIR
+    int32_t numRiders;
+    int64_t requests;           // hall calls made so far
+    int64_t boardings;
+    int64_t alightings;
+    int64_t moves;
+    int32_t waitP50;            // waiting time percentiles, in ticks
+    int32_t waitP90;
+    int32_t waitP99;
+    int32_t waitMax;
+    int32_t waitingPassengers[EC_TELEMETRY_MAX_FLOORS];   // first numFloors entries are valid
+};
+
+struct ECTelemetryLayout
+{
+    // Header, written once when the segment is created
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layoutSize;        // sizeof(ECTelemetryLayout) of the writer
+    uint32_t maxFloors;
+    std::atomic<uint64_t> sequence;   // odd while the writer is updating the payload
+
+    ECTelemetrySnapshot payload;
+};
+
+//*****************************************************************************
+// Creates the segment and publishes into it; attach with ECElevatorSim::AttachTelemetry
+class ECTelemetryWriter
+{
+public:
+    explicit ECTelemetryWriter(const std::string &nameIn);   // name like "/elevator_sim"
+    ~ECTelemetryWriter();
+
+    bool Open();     // create (or replace) the segment; false on failure
+    void Close();    // unmap and remove the segment name
+    bool IsOpen() const { return layout != NULL; }
+
+    // Update the payload in place between BeginUpdate and EndUpdate; readers
+    // retry until EndUpdate, so keep the work in between short
+    ECTelemetrySnapshot &BeginUpdate();
+    void EndUpdate();
+
+private:
+    std::string name;
+    ECTelemetryLayout *layout;
+};
+
+//*****************************************************************************
+// Maps a segment read-only and takes consistent snapshots of it
+class ECTelemetryReader
+{
+public:
+    explicit ECTelemetryReader(const std::string &nameIn);
+    ~ECTelemetryReader();
+
+    bool Open();     // false if the segment is missing or has another layout version
+    void Close();
+
+    // Consistent copy of the payload; false if the writer kept it busy for too many retries
+    bool Read(ECTelemetrySnapshot &snapshot) const;
+
+private:
+    std::string name;
+    const ECTelemetryLayout *layout;
+};
+
+#endif /* ECTELEMETRY_H */
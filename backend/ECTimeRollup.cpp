@@ -0,0 +1,260 @@
+#include "ECTimeRollup.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+void WriteCell(std::ostream &out, const ECRollupCell &cell) {
+    out << "  " << cell.queueMean << " " << cell.queueMax << " " << cell.calls << " " << cell.boardings
+        << " " << cell.stops << " " << cell.waitP50 << " " << cell.waitP90 << " " << cell.waitP99
+        << " " << cell.waitMax;
+}
+
+bool ReadCell(std::istream &in, ECRollupCell &cell) {
+    return static_cast<bool>(in >> cell.queueMean >> cell.queueMax >> cell.calls >> cell.boardings >> cell.stops
+                                >> cell.waitP50 >> cell.waitP90 >> cell.waitP99 >> cell.waitMax);
+}
+}
+
+//*****************************************************************************
+// One resolution
+
+ECRollupLevel::ECRollupLevel(int resolutionIn, int capacityIn, int numFloorsIn)
+    : resolution(resolutionIn > 0 ? resolutionIn : 1), capacity(capacityIn > 0 ? capacityIn : 1), numFloors(numFloorsIn),
+      head(0), numSlots(0), fWrapped(false), openStart(0), openTicks(0) {
+    slotStarts.resize(capacity, 0);
+    slotTicks.resize(capacity, 0);
+    cells.resize(static_cast<size_t>(capacity) * numFloors);
+    openQueueSum.resize(numFloors, 0);
+    openCells.resize(numFloors);
+    openWaits.resize(numFloors);
+}
+
+ECRollupCell *ECRollupLevel::AppendSlot(int start, int ticks) {
+    ECRollupCell *slotCells = &cells[static_cast<size_t>(head) * numFloors];
+    slotStarts[head] = start;
+    slotTicks[head] = ticks;
+    head = (head + 1) % capacity;
+    if (numSlots < capacity) {
+        numSlots++;
+    } else {
+        fWrapped = true;
+    }
+    return slotCells;
+}
+
+void ECRollupLevel::CloseOpenSlot() {
+    if (openTicks == 0) {
+        return;
+    }
+    ECRollupCell *slotCells = AppendSlot(openStart, openTicks);
+    for (int i = 0; i < numFloors; ++i) {
+        ECRollupCell &cell = openCells[i];
+        ECWaitHistogram &waits = openWaits[i];
+        cell.queueMean = static_cast<float>(static_cast<double>(openQueueSum[i]) / openTicks);
+        if (waits.GetCount() > 0) {
+            cell.waitP50 = waits.GetPercentile(0.50);
+            cell.waitP90 = waits.GetPercentile(0.90);
+            cell.waitP99 = waits.GetPercentile(0.99);
+            cell.waitMax = waits.GetMax();
+            waits.Clear();
+        }
+        slotCells[i] = cell;
+        cell = ECRollupCell();
+        openQueueSum[i] = 0;
+    }
+    openTicks = 0;
+}
+
+//*****************************************************************************
+// All resolutions
+
+void ECTimeRollup::AddLevel(int resolution, int capacity) {
+    levels.push_back(ECRollupLevel(resolution, capacity, numFloors));
+}
+
+void ECTimeRollup::AddStandardLevels() {
+    AddLevel(1, 3600);           // an hour of seconds
+    AddLevel(60, 1440);          // a day of minutes
+    AddLevel(15 * 60, 2976);     // 31 days of quarter hours
+    AddLevel(60 * 60, 8784);     // a leap year of hours
+}
+
+void ECTimeRollup::BeginTick(int time) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        ECRollupLevel &level = levels[i];
+        int start = time - time % level.resolution;
+        if (level.openTicks > 0 && start != level.openStart) {
+            level.CloseOpenSlot();
+        }
+        level.openStart = start;
+    }
+}
+
+void ECTimeRollup::RecordBoarding(int floor, int waitTicks) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        levels[i].openCells[floor - 1].boardings++;
+        levels[i].openWaits[floor - 1].Add(waitTicks);
+    }
+}
+
+void ECTimeRollup::EndTick(const int *waitingPassengers) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        ECRollupLevel &level = levels[i];
+        for (int floor = 0; floor < numFloors; ++floor) {
+            int numWaiting = waitingPassengers[floor];
+            level.openQueueSum[floor] += numWaiting;
+            if (numWaiting > level.openCells[floor].queueMax) {
+                level.openCells[floor].queueMax = numWaiting;
+            }
+        }
+        level.openTicks++;
+    }
+}
+
+void ECTimeRollup::Flush() {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        levels[i].CloseOpenSlot();
+    }
+}
+
+int ECTimeRollup::ChooseLevel(int maxSlots) const {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (!levels[i].HasDroppedSlots() && levels[i].GetNumSlots() <= maxSlots) {
+            return static_cast<int>(i);
+        }
+    }
+    return static_cast<int>(levels.size()) - 1;
+}
+
+void ECTimeRollup::Write(std::ostream &out) const {
+    out << "rollup " << numFloors << " " << levels.size() << "\n";
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const ECRollupLevel &level = levels[i];
+        out << "level " << level.GetResolution() << " " << level.GetNumSlots() << "\n";
+        for (int slot = 0; slot < level.GetNumSlots(); ++slot) {
+            out << level.GetSlotStart(slot) << " " << level.GetSlotTicks(slot);
+            for (int floor = 1; floor <= numFloors; ++floor) {
+                WriteCell(out, level.GetCell(slot, floor));
+            }
+            out << "\n";
+        }
+    }
+}
+
+bool ECTimeRollup::Write(const std::string &filename) const {
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing." << std::endl;
+        return false;
+    }
+    Write(outFile);
+    return true;
+}
+
+// Each level is loaded into a ring just big enough for its slots
+bool ECTimeRollup::Load(const std::string &filename) {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        return false;
+    }
+
+    std::string tag;
+    int numLevels = 0;
+    if (!(inFile >> tag >> numFloors >> numLevels) || tag != "rollup" || numFloors <= 0) {
+        std::cerr << "Error: " << filename << " is not a rollup file" << std::endl;
+        return false;
+    }
+
+    levels.clear();
+    for (int i = 0; i < numLevels; ++i) {
+        int resolution = 0;
+        int numSlots = 0;
+        if (!(inFile >> tag >> resolution >> numSlots) || tag != "level") {
+            std::cerr << "Error: Bad level header in " << filename << std::endl;
+            return false;
+        }
+        AddLevel(resolution, numSlots);
+        ECRollupLevel &level = levels.back();
+
+        for (int slot = 0; slot < numSlots; ++slot) {
+            int start = 0;
+            int ticks = 0;
+            inFile >> start >> ticks;
+            ECRollupCell *slotCells = level.AppendSlot(start, ticks);
+            for (int floor = 0; floor < numFloors; ++floor) {
+                ReadCell(inFile, slotCells[floor]);
+            }
+            if (!inFile) {
+                std::cerr << "Error: Truncated rollup file " << filename << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ECTimeRollup::SaveState(std::ostream &out) const {
+    out << "rollupstate " << numFloors << " " << levels.size() << "\n";
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const ECRollupLevel &level = levels[i];
+        out << "level " << level.resolution << " " << level.capacity << " " << level.numSlots << " "
+            << level.fWrapped << " " << level.openStart << " " << level.openTicks << "\n";
+        for (int slot = 0; slot < level.numSlots; ++slot) {
+            out << level.GetSlotStart(slot) << " " << level.GetSlotTicks(slot);
+            for (int floor = 1; floor <= numFloors; ++floor) {
+                WriteCell(out, level.GetCell(slot, floor));
+            }
+            out << "\n";
+        }
+        for (int floor = 0; floor < numFloors; ++floor) {
+            out << level.openQueueSum[floor];
+            WriteCell(out, level.openCells[floor]);
+            out << "\n";
+            level.openWaits[floor].Save(out);
+        }
+    }
+}
+
+// Slots come back oldest first from the start of the ring, which behaves the same from then on
+bool ECTimeRollup::LoadState(std::istream &in) {
+    std::string tag;
+    size_t numLevels = 0;
+    if (!(in >> tag >> numFloors >> numLevels) || tag != "rollupstate") {
+        return false;
+    }
+
+    levels.clear();
+    for (size_t i = 0; i < numLevels; ++i) {
+        int resolution = 0;
+        int capacity = 0;
+        int numSlots = 0;
+        bool fWrapped = false;
+        int openStart = 0;
+        int openTicks = 0;
+        if (!(in >> tag >> resolution >> capacity >> numSlots >> fWrapped >> openStart >> openTicks) || tag != "level") {
+            return false;
+        }
+        AddLevel(resolution, capacity);
+        ECRollupLevel &level = levels.back();
+
+        for (int slot = 0; slot < numSlots; ++slot) {
+            int start = 0;
+            int ticks = 0;
+            in >> start >> ticks;
+            ECRollupCell *slotCells = level.AppendSlot(start, ticks);
+            for (int floor = 0; floor < numFloors; ++floor) {
+                ReadCell(in, slotCells[floor]);
+            }
+        }
+        level.fWrapped = fWrapped;
+        level.openStart = openStart;
+        level.openTicks = openTicks;
+        for (int floor = 0; floor < numFloors; ++floor) {
+            in >> level.openQueueSum[floor];
+            if (!ReadCell(in, level.openCells[floor]) || !level.openWaits[floor].Load(in)) {
+                return false;
+            }
+        }
+    }
+    return static_cast<bool>(in);
+}
@@ -0,0 +1,116 @@
+#ifndef ECTIMEROLLUP_H
+#define ECTIMEROLLUP_H
+
+#include "ECWaitHistogram.h"
+#include <vector>
+#include <string>
+#include <iostream>
+
+//*****************************************************************************
+// One floor over one rollup slot
+struct ECRollupCell
+{
+    ECRollupCell() : queueMean(0.0f), queueMax(0), calls(0), boardings(0), stops(0),
+        waitP50(0), waitP90(0), waitP99(0), waitMax(0) {}
+
+    float queueMean;    // people waiting, averaged over the slot's ticks
+    int queueMax;
+    int calls;          // hall calls made
+    int boardings;
+    int stops;          // ticks in which the car stopped here to let people on or off
+    int waitP50;        // waits of those who boarded, in ticks
+    int waitP90;
+    int waitP99;
+    int waitMax;
+};
+
+//*****************************************************************************
+// Per-floor summaries at one resolution, in a fixed-size ring: once full, each
+// new slot replaces the oldest. Slots are numbered oldest first.
+class ECRollupLevel
+{
+public:
+    ECRollupLevel(int resolutionIn, int capacityIn, int numFloorsIn);
+
+    int GetResolution() const { return resolution; }          // ticks per slot
+    int GetCapacity() const { return capacity; }
+    int GetNumSlots() const { return numSlots; }
+    bool HasDroppedSlots() const { return fWrapped; }           // older slots were overwritten
+    int GetSlotStart(int slot) const { return slotStarts[RingIndex(slot)]; }
+    int GetSlotTicks(int slot) const { return slotTicks[RingIndex(slot)]; }   // fewer than resolution if partial
+    const ECRollupCell &GetCell(int slot, int floor) const { return cells[RingIndex(slot) * numFloors + floor - 1]; }
+
+private:
+    friend class ECTimeRollup;
+
+    int RingIndex(int slot) const { return (head - numSlots + slot + capacity) % capacity; }
+    ECRollupCell *AppendSlot(int start, int ticks);
+    void CloseOpenSlot();
+
+    int resolution;
+    int capacity;
+    int numFloors;
+    int head;                            // ring position the next slot goes to
+    int numSlots;
+    bool fWrapped;
+    std::vector<int> slotStarts;
+    std::vector<int> slotTicks;
+    std::vector<ECRollupCell> cells;     // capacity x numFloors
+
+    // Slot still being accumulated
+    int openStart;
+    int openTicks;
+    std::vector<long long> openQueueSum;
+    std::vector<ECRollupCell> openCells;
+    std::vector<ECWaitHistogram> openWaits;
+};
+
+//*****************************************************************************
+// Online rollups of per-floor demand at several resolutions, so long runs can
+// be summarized and plotted without the per-tick trace. A tick is taken to be
+// one second: the standard levels keep an hour of 1s slots, a day of 1min
+// slots, a month of 15min slots and a year of 1h slots.
+//
+// Everything is allocated up front; recording a tick never allocates.
+class ECTimeRollup
+{
+public:
+    explicit ECTimeRollup(int numFloorsIn = 0) : numFloors(numFloorsIn) {}
+
+    void AddLevel(int resolution, int capacity);
+    void AddStandardLevels();
+
+    // Called by the simulator for every tick, in this order
+    void BeginTick(int time);
+    void RecordCall(int floor) { for (size_t i = 0; i < levels.size(); ++i) levels[i].openCells[floor - 1].calls++; }
+    void RecordBoarding(int floor, int waitTicks);
+    void RecordStop(int floor) { for (size_t i = 0; i < levels.size(); ++i) levels[i].openCells[floor - 1].stops++; }
+    void EndTick(const std::vector<int> &waitingPassengers) { EndTick(waitingPassengers.data()); }
+    void EndTick(const int *waitingPassengers);   // numFloors entries
+
+    // Close the partly filled slots (done before writing)
+    void Flush();
+
+    int GetNumFloors() const { return numFloors; }
+    int GetNumLevels() const { return static_cast<int>(levels.size()); }
+    const ECRollupLevel &GetLevel(int level) const { return levels[level]; }
+
+    // Finest level that holds the whole run in at most maxSlots slots; the coarsest if none does
+    int ChooseLevel(int maxSlots) const;
+
+    // Text format: "rollup floors levels", then per level "level resolution slots"
+    // followed by one line per slot: start, ticks, then the nine cell fields per floor
+    void Write(std::ostream &out) const;
+    bool Write(const std::string &filename) const;
+    bool Load(const std::string &filename);
+
+    // Everything, including the slots still open, so a resumed run ends up identical
+    void SaveState(std::ostream &out) const;
+    bool LoadState(std::istream &in);
+
+private:
+    int numFloors;
+    std::vector<ECRollupLevel> levels;
+};
+
+#endif /* ECTIMEROLLUP_H */
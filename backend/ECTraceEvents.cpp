@@ -0,0 +1,97 @@
+#include "ECTraceEvents.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+const size_t BUFFER_EVENTS = 1 << 14;     // events buffered per thread before handing them over
+
+struct TraceEvent
+{
+    const char *name;
+    unsigned long long start;
+    unsigned long long end;
+    int tid;
+};
+
+std::mutex sharedMutex;
+std::vector<TraceEvent> sharedEvents;               // events handed over by threads
+std::vector<std::pair<int, std::string> > threadNames;
+std::atomic<int> nextThreadId(1);
+
+unsigned long long SteadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const unsigned long long traceStart = SteadyNanos();
+
+// Per-thread event buffer; hands its events over when full and when the thread exits
+struct ThreadBuffer
+{
+    ThreadBuffer() : tid(nextThreadId.fetch_add(1)) { events.reserve(BUFFER_EVENTS); }
+    ~ThreadBuffer() { Flush(); }
+
+    void Flush() {
+        std::lock_guard<std::mutex> lock(sharedMutex);
+        sharedEvents.insert(sharedEvents.end(), events.begin(), events.end());
+        events.clear();
+    }
+
+    std::vector<TraceEvent> events;
+    int tid;
+};
+
+thread_local ThreadBuffer threadBuffer;
+}
+
+unsigned long long ECTraceEvents::Now() {
+    return SteadyNanos();
+}
+
+void ECTraceEvents::SetThreadName(const char *name) {
+    int tid = threadBuffer.tid;
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    threadNames.push_back(std::make_pair(tid, std::string(name)));
+}
+
+void ECTraceEvents::Record(const char *name, unsigned long long startNanos, unsigned long long endNanos) {
+    ThreadBuffer &buffer = threadBuffer;
+    if (buffer.events.size() == BUFFER_EVENTS) {
+        buffer.Flush();
+    }
+    TraceEvent event = { name, startNanos, endNanos, buffer.tid };
+    buffer.events.push_back(event);
+}
+
+bool ECTraceEvents::WriteChromeJSON(const std::string &filename) {
+    threadBuffer.Flush();
+
+    std::ofstream outFile(filename);
+    if (!outFile.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing." << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    outFile << std::fixed << std::setprecision(3);
+    outFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    outFile << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"elevator_sim\"}}";
+    for (size_t i = 0; i < threadNames.size(); ++i) {
+        outFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadNames[i].first
+                << ",\"args\":{\"name\":\"" << threadNames[i].second << "\"}}";
+    }
+    // Timestamps are microseconds since the trace started
+    for (size_t i = 0; i < sharedEvents.size(); ++i) {
+        const TraceEvent &event = sharedEvents[i];
+        outFile << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.tid
+                << ",\"ts\":" << (event.start - traceStart) / 1000.0
+                << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+    }
+    outFile << "\n]}\n";
+    return true;
+}
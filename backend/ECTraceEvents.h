@@ -0,0 +1,52 @@
+#ifndef ECTRACEEVENTS_H
+#define ECTRACEEVENTS_H
+
+#include <string>
+
+//*****************************************************************************
+// Timeline tracing in the Chrome trace-event format, which Perfetto
+// (ui.perfetto.dev) and chrome://tracing open directly. Build with
+// -DEC_SIM_TRACE to record; otherwise the macros below expand to nothing.
+//
+// Events go to a buffer owned by the recording thread, so tracing a scope costs
+// two clock reads and an append. Full buffers, and the buffers of threads that
+// exit, are handed to a shared list under a mutex.
+
+class ECTraceEvents
+{
+public:
+    // Name the calling thread on the timeline
+    static void SetThreadName(const char *name);
+
+    // Record a complete event; name must be a string literal (it is not copied)
+    static void Record(const char *name, unsigned long long startNanos, unsigned long long endNanos);
+
+    static unsigned long long Now();
+
+    // Write every event recorded so far as Chrome trace JSON. Events still buffered
+    // by other running threads are not included; call once those threads are done.
+    static bool WriteChromeJSON(const std::string &filename);
+};
+
+//*****************************************************************************
+// Records the enclosing scope as one event
+class ECTraceScope
+{
+public:
+    explicit ECTraceScope(const char *nameIn) : name(nameIn), start(ECTraceEvents::Now()) {}
+    ~ECTraceScope() { ECTraceEvents::Record(name, start, ECTraceEvents::Now()); }
+
+private:
+    const char *name;
+    unsigned long long start;
+};
+
+#ifdef EC_SIM_TRACE
+#define EC_TRACE_SCOPE(name) ECTraceScope ecTraceScope(name)
+#define EC_TRACE_THREAD_NAME(name) ECTraceEvents::SetThreadName(name)
+#else
+#define EC_TRACE_SCOPE(name) ((void)0)
+#define EC_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif /* ECTRACEEVENTS_H */
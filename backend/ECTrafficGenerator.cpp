@@ -0,0 +1,54 @@
+#include "ECTrafficGenerator.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+// Largest rate drawn by inversion in one go; exp(-rate) loses precision, then underflows, above it
+const double MAX_PIECE_RATE = 30.0;
+}
+
+std::vector<ECElevatorSimRequest> ECTrafficGenerator::Generate(uint64_t seed) const {
+    std::vector<ECElevatorSimRequest> requests;
+    if (config.numFloors < 2 || config.callsPerTick <= 0) {
+        return requests;
+    }
+    double peak = std::max(config.peakCallsPerTick, config.callsPerTick);
+    double keepChance = config.callsPerTick / peak;
+    // A sum of Poisson counts is a Poisson count, so a high rate is drawn in equal pieces
+    int numPieces = static_cast<int>(ceil(peak / MAX_PIECE_RATE));
+    double noArrivals = exp(-peak / numPieces);
+
+    ECRandom random(seed);
+    for (int time = 0; time < config.duration; ++time) {
+        // Poisson count by inversion, O(calls) draws per tick
+        int numCalls = 0;
+        for (int piece = 0; piece < numPieces; ++piece) {
+            double product = random.NextDouble();
+            while (product > noArrivals) {
+                numCalls++;
+                product *= random.NextDouble();
+            }
+        }
+        for (int i = 0; i < numCalls; ++i) {
+            double fromLobby = random.NextDouble();
+            int floorAny = 1 + random.NextInt(config.numFloors);
+            int destOffset = random.NextInt(config.numFloors - 1);
+            double keep = random.NextDouble();
+            if (keep >= keepChance) {
+                continue;
+            }
+            int floorSrc = fromLobby < config.lobbyShare ? 1 : floorAny;
+            int floorDest = 1 + destOffset;
+            if (floorDest >= floorSrc) {
+                floorDest++;   // skip the source floor
+            }
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return requests;
+}
+
+uint64_t ECTrafficGenerator::StreamSeed(uint64_t baseSeed, int stream) {
+    ECRandom mixer(baseSeed * 0x9e3779b97f4a7c15ULL + static_cast<uint64_t>(stream));
+    return mixer.NextU64();
+}
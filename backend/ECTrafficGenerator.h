@@ -0,0 +1,65 @@
+#ifndef ECTRAFFICGENERATOR_H
+#define ECTRAFFICGENERATOR_H
+
+#include "ECElevatorSim1.h"
+#include <vector>
+#include <cstdint>
+
+//*****************************************************************************
+// Small seeded generator (splitmix64): the same seed gives the same numbers on
+// every platform and compiler, which <random>'s distributions do not promise.
+class ECRandom
+{
+public:
+    explicit ECRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t NextU64() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    double NextDouble() { return (NextU64() >> 11) * (1.0 / 9007199254740992.0); }   // [0, 1)
+    int NextInt(int n) { return static_cast<int>(NextDouble() * n); }                // [0, n)
+
+private:
+    uint64_t state;
+};
+
+//*****************************************************************************
+// Random hall calls for one building: Poisson arrivals at any rate, including
+// several calls a tick, a share of them from the lobby (floor 1) and the rest
+// from any floor, each going to a different floor chosen uniformly.
+//
+// Calls are drawn at peakCallsPerTick and each is kept with probability
+// callsPerTick / peakCallsPerTick, every candidate using the same number of
+// random draws whether kept or not. Configurations that share a seed and a
+// peak rate therefore see the same people, which is what comparisons with
+// common random numbers need.
+struct ECTrafficConfig
+{
+    ECTrafficConfig() : numFloors(10), duration(3600), callsPerTick(0.05), peakCallsPerTick(0), lobbyShare(0.3) {}
+
+    int numFloors;
+    int duration;              // ticks with arrivals
+    double callsPerTick;
+    double peakCallsPerTick;   // candidate rate; 0 means callsPerTick
+    double lobbyShare;         // of calls made at floor 1
+};
+
+class ECTrafficGenerator
+{
+public:
+    explicit ECTrafficGenerator(const ECTrafficConfig &configIn) : config(configIn) {}
+
+    // Sorted by time, ready for ECElevatorSim
+    std::vector<ECElevatorSimRequest> Generate(uint64_t seed) const;
+
+    // Seed of one replication's stream, well apart from its neighbours'
+    static uint64_t StreamSeed(uint64_t baseSeed, int stream);
+
+private:
+    ECTrafficConfig config;
+};
+
+#endif /* ECTRAFFICGENERATOR_H */
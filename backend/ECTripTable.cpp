@@ -0,0 +1,214 @@
+#include "ECTripTable.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//*****************************************************************************
+// Writer
+
+ECTripTableWriter::ECTripTableWriter(const std::string &pathIn, int rowsPerGroupIn)
+    : path(pathIn), rowsPerGroup(std::max(rowsPerGroupIn, 1)), file(NULL), fFailed(false), groupRows(0), numGroups(0), numRows(0) {}
+
+ECTripTableWriter::~ECTripTableWriter() {
+    Close();
+}
+
+bool ECTripTableWriter::Open() {
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        std::cerr << "Error: Could not open trip table " << path << " for writing." << std::endl;
+        return false;
+    }
+    timeCalls.assign(rowsPerGroup, 0);
+    timeBoards.assign(rowsPerGroup, 0);
+    timeArrives.assign(rowsPerGroup, 0);
+    floorSrcs.assign(rowsPerGroup, 0);
+    floorDests.assign(rowsPerGroup, 0);
+    cars.assign(rowsPerGroup, 0);
+    fFailed = false;
+    groupRows = 0;
+    numGroups = 0;
+    numRows = 0;
+    WriteHeader();   // rewritten with the real counts at Close
+    return true;
+}
+
+bool ECTripTableWriter::Close() {
+    if (file == NULL) {
+        return !fFailed;
+    }
+    if (groupRows > 0) {
+        FlushGroup();
+    }
+    if (!fFailed && fseek(file, 0, SEEK_SET) != 0) {
+        fFailed = true;
+    }
+    WriteHeader();
+    if (fclose(file) != 0) {
+        fFailed = true;
+    }
+    file = NULL;
+    if (fFailed) {
+        std::cerr << "Error: Could not write trip table " << path << "; it is incomplete." << std::endl;
+    }
+    return !fFailed;
+}
+
+void ECTripTableWriter::Write(const void *bytes, size_t size, size_t count) {
+    if (!fFailed && fwrite(bytes, size, count, file) != count) {
+        fFailed = true;
+    }
+}
+
+void ECTripTableWriter::FlushGroup() {
+    ECTripGroupHeader groupHeader;
+    memset(&groupHeader, 0, sizeof(groupHeader));
+    groupHeader.numRows = groupRows;
+    groupHeader.timeCallMin = *std::min_element(timeCalls.begin(), timeCalls.begin() + groupRows);
+    groupHeader.timeCallMax = *std::max_element(timeCalls.begin(), timeCalls.begin() + groupRows);
+    Write(&groupHeader, sizeof(groupHeader), 1);
+    Write(timeCalls.data(), sizeof(int32_t), groupRows);
+    Write(timeBoards.data(), sizeof(int32_t), groupRows);
+    Write(timeArrives.data(), sizeof(int32_t), groupRows);
+    Write(floorSrcs.data(), sizeof(uint16_t), groupRows);
+    Write(floorDests.data(), sizeof(uint16_t), groupRows);
+    Write(cars.data(), sizeof(uint16_t), groupRows);
+
+    size_t written = sizeof(groupHeader) + static_cast<size_t>(groupRows) * (3 * sizeof(int32_t) + 3 * sizeof(uint16_t));
+    static const char padding[8] = {0};
+    Write(padding, 1, ECTripGroupBytes(groupRows) - written);
+
+    numGroups++;
+    numRows += groupRows;
+    groupRows = 0;
+}
+
+void ECTripTableWriter::WriteHeader() {
+    ECTripTableHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = EC_TRIP_TABLE_MAGIC;
+    header.version = EC_TRIP_TABLE_VERSION;
+    header.rowsPerGroup = rowsPerGroup;
+    header.numGroups = numGroups;
+    header.numRows = numRows;
+    Write(&header, sizeof(header), 1);
+}
+
+//*****************************************************************************
+// Reader
+
+namespace {
+// Whether the header's counts are consistent and its groups exactly fill a file of size bytes
+bool CountsFit(const ECTripTableHeader &header, size_t size) {
+    if (header.numGroups < 0 || header.numRows < 0) {
+        return false;
+    }
+    if (header.numGroups == 0) {
+        return header.numRows == 0 && size == sizeof(header);
+    }
+    long long lastRows = header.numRows - static_cast<long long>(header.numGroups - 1) * header.rowsPerGroup;
+    if (lastRows < 1 || lastRows > header.rowsPerGroup) {
+        return false;
+    }
+    size_t groupBytes = ECTripGroupBytes(header.rowsPerGroup);
+    size_t available = size - sizeof(header);
+    if (static_cast<size_t>(header.numGroups - 1) > available / groupBytes) {
+        return false;
+    }
+    size_t expected = static_cast<size_t>(header.numGroups - 1) * groupBytes + ECTripGroupBytes(static_cast<int>(lastRows));
+    return expected == available;
+}
+}
+
+int ECTripTableReader::GroupRows(int group) const {
+    if (group < header.numGroups - 1) {
+        return header.rowsPerGroup;
+    }
+    return static_cast<int>(header.numRows - static_cast<long long>(header.numGroups - 1) * header.rowsPerGroup);
+}
+
+bool ECTripTableReader::Open(const std::string &path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open trip table " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ECTripTableHeader)) {
+        std::cerr << "Error: " << path << " is not a trip table" << std::endl;
+        close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    void *mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map trip table " << path << std::endl;
+        size = 0;
+        return false;
+    }
+    data = static_cast<const unsigned char *>(mapped);
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != EC_TRIP_TABLE_MAGIC || header.version != EC_TRIP_TABLE_VERSION || header.rowsPerGroup < 1) {
+        std::cerr << "Error: " << path << " is not a version " << EC_TRIP_TABLE_VERSION << " trip table" << std::endl;
+        Close();
+        return false;
+    }
+    // A table cut short (the writer never closed it, or ran out of disk) has no trustworthy counts
+    if (!CountsFit(header, size)) {
+        std::cerr << "Error: trip table " << path << " is incomplete" << std::endl;
+        Close();
+        return false;
+    }
+    // Every group must hold the rows the header promises, or its columns would run past the file
+    for (int group = 0; group < header.numGroups; ++group) {
+        ECTripGroupHeader groupHeader;
+        memcpy(&groupHeader, data + sizeof(header) + static_cast<size_t>(group) * ECTripGroupBytes(header.rowsPerGroup), sizeof(groupHeader));
+        if (groupHeader.numRows != GroupRows(group)) {
+            std::cerr << "Error: trip table " << path << " is corrupt: group " << group << " claims "
+                      << groupHeader.numRows << " rows" << std::endl;
+            Close();
+            return false;
+        }
+    }
+    // The scan reads a lot of memory once, front to back
+    madvise(const_cast<unsigned char *>(data), size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void ECTripTableReader::Close() {
+    if (data != NULL) {
+        munmap(const_cast<unsigned char *>(data), size);
+        data = NULL;
+        size = 0;
+    }
+}
+
+ECTripGroupView ECTripTableReader::GetGroup(int group) const {
+    if (data == NULL || group < 0 || group >= header.numGroups) {
+        ECTripGroupView empty;
+        memset(&empty, 0, sizeof(empty));
+        return empty;
+    }
+    const unsigned char *base = data + sizeof(header) + static_cast<size_t>(group) * ECTripGroupBytes(header.rowsPerGroup);
+    ECTripGroupHeader groupHeader;
+    memcpy(&groupHeader, base, sizeof(groupHeader));
+
+    ECTripGroupView view;
+    view.numRows = groupHeader.numRows;
+    view.timeCallMin = groupHeader.timeCallMin;
+    view.timeCallMax = groupHeader.timeCallMax;
+    const unsigned char *column = base + sizeof(groupHeader);
+    view.timeCall = reinterpret_cast<const int32_t *>(column);
+    view.timeBoard = view.timeCall + view.numRows;
+    view.timeArrive = view.timeBoard + view.numRows;
+    view.floorSrc = reinterpret_cast<const uint16_t *>(view.timeArrive + view.numRows);
+    view.floorDest = view.floorSrc + view.numRows;
+    view.car = view.floorDest + view.numRows;
+    return view;
+}
@@ -0,0 +1,133 @@
+#ifndef ECTRIPTABLE_H
+#define ECTRIPTABLE_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+
+//*****************************************************************************
+// Trip table: one row per passenger who reached their floor (hall call time,
+// source, destination, boarding time, arrival time, car), stored by column so a
+// query reads only the columns it needs, straight from a memory-mapped file.
+//
+// File: a header, then row groups back to back. Each group is a small header
+// (row count, range of call times, so a query can skip groups outside its time
+// window) followed by the columns: call, board and arrive times as int32_t,
+// then source, destination and car as uint16_t, padded to 8 bytes. Every group
+// but the last holds rowsPerGroup rows, so group g starts at a fixed offset.
+const uint32_t EC_TRIP_TABLE_MAGIC = 0x50525445;   // "ETRP" on little endian
+const uint32_t EC_TRIP_TABLE_VERSION = 1;
+const int EC_TRIP_TABLE_DEFAULT_GROUP_ROWS = 1 << 16;
+
+struct ECTripTableHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t rowsPerGroup;
+    int32_t numGroups;
+    int64_t numRows;
+};
+
+struct ECTripGroupHeader
+{
+    int32_t numRows;
+    int32_t timeCallMin;
+    int32_t timeCallMax;
+    int32_t reserved;
+};
+
+// Bytes of a group of numRows rows, header included
+inline size_t ECTripGroupBytes(int numRows) {
+    size_t bytes = sizeof(ECTripGroupHeader) + static_cast<size_t>(numRows) * (3 * sizeof(int32_t) + 3 * sizeof(uint16_t));
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+//*****************************************************************************
+// Appends rows to a trip table. Column buffers are sized once at Open, so
+// adding a row never allocates; a full group goes to the file in one go.
+class ECTripTableWriter
+{
+public:
+    explicit ECTripTableWriter(const std::string &pathIn, int rowsPerGroupIn = EC_TRIP_TABLE_DEFAULT_GROUP_ROWS);
+    ~ECTripTableWriter();
+
+    bool Open();
+    bool Close();   // writes the last group and the final row count; false if any write failed
+    bool IsOpen() const { return file != NULL; }
+
+    void AddTrip(int timeCall, int floorSrc, int floorDest, int timeBoard, int timeArrive, int car) {
+        timeCalls[groupRows] = timeCall;
+        timeBoards[groupRows] = timeBoard;
+        timeArrives[groupRows] = timeArrive;
+        floorSrcs[groupRows] = static_cast<uint16_t>(floorSrc);
+        floorDests[groupRows] = static_cast<uint16_t>(floorDest);
+        cars[groupRows] = static_cast<uint16_t>(car);
+        if (++groupRows == rowsPerGroup) {
+            FlushGroup();
+        }
+    }
+    long long GetNumRows() const { return numRows + groupRows; }
+
+private:
+    void FlushGroup();
+    void WriteHeader();
+    void Write(const void *bytes, size_t size, size_t count);   // notes the first failure
+
+
+    std::string path;
+    int rowsPerGroup;
+    FILE *file;
+    bool fFailed;             // a write failed; nothing more is written
+    int groupRows;            // rows in the group being filled
+    int numGroups;            // groups written
+    long long numRows;        // rows in the groups written
+    std::vector<int32_t> timeCalls;
+    std::vector<int32_t> timeBoards;
+    std::vector<int32_t> timeArrives;
+    std::vector<uint16_t> floorSrcs;
+    std::vector<uint16_t> floorDests;
+    std::vector<uint16_t> cars;
+};
+
+//*****************************************************************************
+// Columns of one row group, pointing into the mapped file
+struct ECTripGroupView
+{
+    int numRows;
+    int timeCallMin;
+    int timeCallMax;
+    const int32_t *timeCall;
+    const int32_t *timeBoard;
+    const int32_t *timeArrive;
+    const uint16_t *floorSrc;
+    const uint16_t *floorDest;
+    const uint16_t *car;
+};
+
+// Maps a trip table read-only; groups can be read from any number of threads.
+// Open checks that every group's row count matches the header and that every
+// group lies inside the file, so GetGroup never reads past the mapping.
+class ECTripTableReader
+{
+public:
+    ECTripTableReader() : data(NULL), size(0) {}
+    ~ECTripTableReader() { Close(); }
+
+    bool Open(const std::string &path);
+    void Close();
+
+    int GetNumGroups() const { return header.numGroups; }
+    long long GetNumRows() const { return header.numRows; }
+    ECTripGroupView GetGroup(int group) const;   // no rows if group is out of range
+
+private:
+    int GroupRows(int group) const;   // rows group must hold, by the header
+
+    const unsigned char *data;
+    size_t size;
+    ECTripTableHeader header;
+};
+
+#endif /* ECTRIPTABLE_H */
@@ -0,0 +1,117 @@
+#include "ECWaitHistogram.h"
+
+namespace {
+const int LINEAR_BUCKETS = 64;     // one bucket per tick below this
+const int LINEAR_BITS = 6;         // log2(LINEAR_BUCKETS)
+const int SUB_BUCKET_BITS = 3;     // eight buckets per power of two above it
+
+int FloorLog2(unsigned int value) {
+    int log = 0;
+    while (value >>= 1) {
+        ++log;
+    }
+    return log;
+}
+}
+
+void ECWaitHistogram::Clear() {
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] = 0;
+    }
+    count = 0;
+    sum = 0;
+    maxTicks = 0;
+}
+
+int ECWaitHistogram::GetBucket(int ticks) {
+    if (ticks < LINEAR_BUCKETS) {
+        return ticks < 0 ? 0 : ticks;
+    }
+    int exponent = FloorLog2(ticks);
+    int subBucket = (ticks >> (exponent - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+    return LINEAR_BUCKETS + ((exponent - LINEAR_BITS) << SUB_BUCKET_BITS) + subBucket;
+}
+
+int ECWaitHistogram::GetBucketLowerBound(int bucket) {
+    if (bucket < LINEAR_BUCKETS) {
+        return bucket;
+    }
+    int exponent = LINEAR_BITS + ((bucket - LINEAR_BUCKETS) >> SUB_BUCKET_BITS);
+    int subBucket = (bucket - LINEAR_BUCKETS) & ((1 << SUB_BUCKET_BITS) - 1);
+    return ((1 << SUB_BUCKET_BITS) + subBucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+void ECWaitHistogram::Add(int ticks) {
+    if (ticks < 0) {
+        ticks = 0;
+    }
+    buckets[GetBucket(ticks)]++;
+    count++;
+    sum += ticks;
+    if (ticks > maxTicks) {
+        maxTicks = ticks;
+    }
+}
+
+void ECWaitHistogram::Merge(const ECWaitHistogram &other) {
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    if (other.maxTicks > maxTicks) {
+        maxTicks = other.maxTicks;
+    }
+}
+
+int ECWaitHistogram::GetPercentile(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    long long rank = static_cast<long long>(fraction * count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    long long seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            int bound = GetBucketLowerBound(i);
+            return bound < maxTicks ? bound : maxTicks;
+        }
+    }
+    return maxTicks;
+}
+
+void ECWaitHistogram::Save(std::ostream &out) const {
+    int numUsed = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        if (buckets[i] != 0) {
+            numUsed++;
+        }
+    }
+    out << count << " " << sum << " " << maxTicks << " " << numUsed;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        if (buckets[i] != 0) {
+            out << " " << i << " " << buckets[i];
+        }
+    }
+    out << "\n";
+}
+
+bool ECWaitHistogram::Load(std::istream &in) {
+    Clear();
+    int numUsed = 0;
+    if (!(in >> count >> sum >> maxTicks >> numUsed)) {
+        return false;
+    }
+    for (int i = 0; i < numUsed; ++i) {
+        int bucket = 0;
+        long long bucketCount = 0;
+        if (!(in >> bucket >> bucketCount) || bucket < 0 || bucket >= NUM_BUCKETS) {
+            return false;
+        }
+        buckets[bucket] = bucketCount;
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef ECWAITHISTOGRAM_H
+#define ECWAITHISTOGRAM_H
+
+#include <iostream>
+
+//*****************************************************************************
+// Histogram of waiting times in ticks, for percentiles without keeping every
+// sample. Waits under 64 ticks get a bucket each; longer waits share buckets
+// eight to a power of two (within 12.5%). Fixed size, so adding never allocates.
+class ECWaitHistogram
+{
+public:
+    static const int NUM_BUCKETS = 64 + 25 * 8;   // waits up to 2^31 ticks
+
+    ECWaitHistogram() { Clear(); }
+
+    void Clear();
+    void Add(int ticks);
+    void Merge(const ECWaitHistogram &other);
+
+    long long GetCount() const { return count; }
+    long long GetSum() const { return sum; }
+    int GetMax() const { return maxTicks; }
+    double GetMean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+
+    // Smallest wait w such that at least fraction of the samples are <= w (exact below 64 ticks)
+    int GetPercentile(double fraction) const;
+
+    long long GetBucketCount(int bucket) const { return buckets[bucket]; }
+    static int GetBucket(int ticks);
+    static int GetBucketLowerBound(int bucket);
+
+    // Exact copy as text (non-empty buckets only), for checkpoints
+    void Save(std::ostream &out) const;
+    bool Load(std::istream &in);
+
+private:
+    long long buckets[NUM_BUCKETS];
+    long long count;
+    long long sum;
+    int maxTicks;
+};
+
+#endif /* ECWAITHISTOGRAM_H */
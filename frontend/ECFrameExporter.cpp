@@ -0,0 +1,126 @@
+#include "ECFrameExporter.h"
+#include "ECTraceEvents.h"
+#include <allegro5/allegro.h>
+#include <allegro5/allegro_image.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <cstdio>
+#include <cerrno>
+#include <sys/stat.h>
+
+// Parse the "Time Step / Floor / Passengers In Elevator / Waiting Passengers / --"
+// blocks written by ECElevatorSim::Simulate
+bool ECFrameExporter::LoadTrace(const std::string &traceFile) {
+    EC_TRACE_SCOPE("ECFrameExporter::LoadTrace");
+    std::ifstream inFile(traceFile);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << traceFile << std::endl;
+        return false;
+    }
+
+    int numFloors = 0;
+    int duration = 0;
+    ECSceneFrame frame;
+    std::string line;
+
+    frames.clear();
+    if (std::getline(inFile, line)) {
+        std::istringstream iss(line);
+        iss >> numFloors >> duration;
+    }
+    if (numFloors <= 0) {
+        std::cerr << "Error: " << traceFile << " does not start with the number of floors." << std::endl;
+        return false;
+    }
+
+    while (std::getline(inFile, line)) {
+        std::string::size_type colon = line.find(':');
+        std::istringstream values(colon == std::string::npos ? std::string() : line.substr(colon + 1));
+        int value;
+
+        if (line.compare(0, 10, "Time Step:") == 0) {
+            frame = ECSceneFrame();
+            frame.numFloors = numFloors;
+            values >> frame.stepIndex;
+        } else if (line.compare(0, 6, "Floor:") == 0) {
+            values >> frame.currentFloor;
+        } else if (line.compare(0, 23, "Passengers In Elevator:") == 0) {
+            while (values >> value) {
+                frame.elevatorPassengers.push_back(value);
+            }
+        } else if (line.compare(0, 19, "Waiting Passengers:") == 0) {
+            while (values >> value) {
+                frame.waitingPassengers.push_back(value);
+            }
+        } else if (line == "--") {
+            frame.elevatorFloorPos = frame.currentFloor;
+            frame.camera.SetBounds(numFloors, height);
+            frames.push_back(frame);
+        }
+    }
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        frames[i].numSteps = frames.size();
+    }
+    return true;
+}
+
+int ECFrameExporter::Export(const std::string &outDir, int numThreads) {
+    EC_TRACE_SCOPE("ECFrameExporter::Export");
+    if (mkdir(outDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error: Could not create directory " << outDir << std::endl;
+        return 0;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    std::atomic<int> nextFrame(0);
+    std::atomic<int> numWritten(0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numThreads; ++i) {
+        workers.push_back(std::thread(&ECFrameExporter::ExportWorker, this, std::cref(outDir),
+                                      std::ref(nextFrame), std::ref(numWritten)));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    return numWritten.load();
+}
+
+// Claim frames one at a time until none are left
+void ECFrameExporter::ExportWorker(const std::string &outDir, std::atomic<int> &nextFrame, std::atomic<int> &numWritten) const {
+    EC_TRACE_THREAD_NAME("export worker");
+
+    // Bitmap flags are per thread; memory bitmaps need no display or GPU context
+    al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+    ALLEGRO_BITMAP *bitmap = al_create_bitmap(width, height);
+    if (bitmap == NULL) {
+        std::cerr << "Error: Could not create a " << width << "x" << height << " bitmap." << std::endl;
+        return;
+    }
+
+    {
+        ECGraphicViewImp view(width, height, bitmap);
+        ECSceneRenderer renderer(view);
+        char path[1024];
+
+        for (int i = nextFrame.fetch_add(1); i < static_cast<int>(frames.size()); i = nextFrame.fetch_add(1)) {
+            EC_TRACE_SCOPE("ECFrameExporter::ExportFrame");
+            al_clear_to_color(al_map_rgb(255, 255, 255));
+            renderer.DrawScene(frames[i]);
+
+            snprintf(path, sizeof(path), "%s/frame_%06d.png", outDir.c_str(), i);
+            if (al_save_bitmap(path, bitmap)) {
+                numWritten.fetch_add(1);
+            } else {
+                std::cerr << "Error: Could not write " << path << std::endl;
+            }
+        }
+    }
+
+    al_set_target_bitmap(NULL);
+    al_destroy_bitmap(bitmap);
+}
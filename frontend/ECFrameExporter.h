@@ -0,0 +1,38 @@
+#ifndef ECFRAMEEXPORTER_H
+#define ECFRAMEEXPORTER_H
+
+#include "ECSceneRenderer.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+//*****************************************************************************
+// Offline export of a simulation trace as numbered PNG images, one per time
+// step (outDir/frame_000000.png, ...), e.g. to turn into a video with ffmpeg.
+// Nothing is shown and nothing sleeps: frames are drawn into memory bitmaps by
+// a pool of worker threads, each with its own bitmap, view and renderer.
+//
+// Allegro and its primitives, font, ttf and image addons must be initialized
+// before exporting; no display is needed.
+class ECFrameExporter
+{
+public:
+    ECFrameExporter(int widthIn, int heightIn) : width(widthIn), height(heightIn) {}
+
+    // Read the time steps of a simulation output file; false if it cannot be read
+    bool LoadTrace(const std::string &traceFile);
+    int GetNumFrames() const { return frames.size(); }
+
+    // Write every frame into outDir (created if missing) using numThreads workers.
+    // Returns the number of frames written.
+    int Export(const std::string &outDir, int numThreads);
+
+private:
+    void ExportWorker(const std::string &outDir, std::atomic<int> &nextFrame, std::atomic<int> &numWritten) const;
+
+    int width;
+    int height;
+    std::vector<ECSceneFrame> frames;
+};
+
+#endif /* ECFRAMEEXPORTER_H */
@@ -0,0 +1,32 @@
+#include "ECFrameStats.h"
+#include <algorithm>
+
+void ECTimingWindow::Add(double ms) {
+    samples[nextSample] = ms;
+    nextSample = (nextSample + 1) % WINDOW_SIZE;
+    if (numSamples < WINDOW_SIZE) {
+        numSamples++;
+    }
+}
+
+double ECTimingWindow::GetAverage() const {
+    if (numSamples == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (int i = 0; i < numSamples; ++i) {
+        sum += samples[i];
+    }
+    return sum / numSamples;
+}
+
+double ECTimingWindow::GetPercentile(double fraction) const {
+    if (numSamples == 0) {
+        return 0.0;
+    }
+    double sorted[WINDOW_SIZE];
+    std::copy(samples, samples + numSamples, sorted);
+    int index = static_cast<int>(fraction * (numSamples - 1) + 0.5);
+    std::nth_element(sorted, sorted + index, sorted + numSamples);
+    return sorted[index];
+}
@@ -0,0 +1,54 @@
+#ifndef ECFRAMESTATS_H
+#define ECFRAMESTATS_H
+
+//*****************************************************************************
+// Rolling window of timing samples (milliseconds), for average and percentiles
+class ECTimingWindow
+{
+public:
+    static const int WINDOW_SIZE = 240;   // about 4 seconds of frames at 60 FPS
+
+    ECTimingWindow() : numSamples(0), nextSample(0) {}
+
+    void Add(double ms);
+    double GetAverage() const;
+    double GetPercentile(double fraction) const;   // e.g. 0.99 for p99
+    int GetNumSamples() const { return numSamples; }
+
+private:
+    double samples[WINDOW_SIZE];
+    int numSamples;
+    int nextSample;
+};
+
+//*****************************************************************************
+// Frontend performance numbers shown by the profiler overlay
+class ECFrameStats
+{
+public:
+    ECFrameStats() : primitivesPerFrame(0), textCallsPerFrame(0) {}
+
+    ECTimingWindow &GetFrameTimes() { return frameTimes; }
+    ECTimingWindow &GetDrawTimes() { return drawTimes; }
+    ECTimingWindow &GetUpdateTimes() { return updateTimes; }
+    ECTimingWindow &GetEventLatencies() { return eventLatencies; }
+    const ECTimingWindow &GetFrameTimes() const { return frameTimes; }
+    const ECTimingWindow &GetDrawTimes() const { return drawTimes; }
+    const ECTimingWindow &GetUpdateTimes() const { return updateTimes; }
+    const ECTimingWindow &GetEventLatencies() const { return eventLatencies; }
+
+    // Draw calls made for the last presented frame
+    void SetDrawCounts(int primitives, int textCalls) { primitivesPerFrame = primitives; textCallsPerFrame = textCalls; }
+    int GetPrimitivesPerFrame() const { return primitivesPerFrame; }
+    int GetTextCallsPerFrame() const { return textCallsPerFrame; }
+
+private:
+    ECTimingWindow frameTimes;      // interval between presented frames
+    ECTimingWindow drawTimes;       // building and presenting one frame
+    ECTimingWindow updateTimes;     // ElevatorHandler::Update
+    ECTimingWindow eventLatencies;  // event generated -> event handled
+    int primitivesPerFrame;
+    int textCallsPerFrame;
+};
+
+#endif /* ECFRAMESTATS_H */
@@ -9,7 +9,10 @@
 #include "allegro5/allegro_primitives.h"
 #include <allegro5/allegro_image.h>
 #include <allegro5/allegro_ttf.h>
+#include <allegro5/allegro_memfile.h>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 
 
 using namespace std;
@@ -35,10 +38,24 @@ ALLEGRO_COLOR arrayAllegroColors[ECGV_NUM_COLORS] =
 // A graphic view implementation
 // This is built on top of Allegro library
 
-ECGraphicViewImp :: ECGraphicViewImp(int width, int height) : widthView(width), heightView(height), fRedraw(false), display(NULL), timer(NULL), event_queue(NULL)
+ECGraphicViewImp :: ECGraphicViewImp(int width, int height) : widthView(width), heightView(height), fRedraw(false),
+    numPrimitives(0), numTextCalls(0), lastFramePrimitives(0), lastFrameTextCalls(0), display(NULL), event_queue(NULL), timer(NULL), fontDef(NULL),
+    fFontBytesReady(false), fFontFailed(false), createTime(std::chrono::steady_clock::now()), timeToFirstFrame(-1.0), timeToFontReady(-1.0)
 {
     Init();
 }
+ECGraphicViewImp :: ECGraphicViewImp(int width, int height, ALLEGRO_BITMAP *target) : widthView(width), heightView(height), fRedraw(false),
+    numPrimitives(0), numTextCalls(0), lastFramePrimitives(0), lastFrameTextCalls(0), display(NULL), event_queue(NULL), timer(NULL), fontDef(NULL),
+    fFontBytesReady(false), fFontFailed(false), createTime(std::chrono::steady_clock::now()), timeToFirstFrame(-1.0), timeToFontReady(-1.0)
+{
+    // Allegro and its addons are initialized by the caller (InitAllegro)
+    al_set_target_bitmap(target);
+    this->fontDef = al_load_font("lucon.ttf", 40, 0);
+    if( this->fontDef == NULL )
+    {
+        cout << "Warning: font is not loaded!\n";
+    }
+}
 ECGraphicViewImp :: ~ECGraphicViewImp()
 {
     Shutdown();
@@ -141,15 +158,49 @@ void ECGraphicViewImp :: RenderStart()
 void ECGraphicViewImp :: RenderEnd()
 {
 //    al_draw_bitmap(algBitmap, GetPosX(), GetPosY(), 0);
+    FlipDisplay();
+}
+
+void ECGraphicViewImp :: FlipDisplay()
+{
+    if( timeToFirstFrame < 0 )
+    {
+        timeToFirstFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - createTime).count();
+    }
+    lastFramePrimitives = numPrimitives;
+    lastFrameTextCalls = numTextCalls;
+    numPrimitives = 0;
+    numTextCalls = 0;
     al_flip_display();
 }
 
     
-void ECGraphicViewImp :: Init()
+bool ECGraphicViewImp :: InitAllegro()
 {
-cout << "Start init..\n";
+    static bool fInitialized = false;
+    if( fInitialized )
+    {
+        return true;
+    }
     if(!al_init()) {
         cout << "failed to initialize allegro!\n";
+        return false;
+    }
+    al_init_image_addon();
+    al_init_primitives_addon();
+    al_init_font_addon();
+    al_init_ttf_addon();
+    fInitialized = true;
+    return true;
+}
+
+void ECGraphicViewImp :: Init()
+{
+cout << "Start init..\n";
+    // Start reading the font right away; it is only needed once text is drawn
+    fontReader = std::thread(&ECGraphicViewImp::ReadFontFile, this);
+
+    if(!InitAllegro()) {
         exit(-1);
     }
     
@@ -182,36 +233,68 @@ cout << "Start init..\n";
         Shutdown();
         exit( -1);
     }
-//cout << "3\n";
-//#if 0
     al_register_event_source(event_queue, al_get_display_event_source(display));
     al_register_event_source(event_queue, al_get_timer_event_source(timer));
     al_register_event_source(event_queue, al_get_keyboard_event_source());
     al_register_event_source(event_queue, al_get_mouse_event_source());
-//#endif
-    al_clear_to_color(al_map_rgb(255,255,255));
-    al_flip_display();
     al_start_timer(timer);
-    
-    // init image
-    al_init_image_addon();
-    al_init_primitives_addon();
+ 
+cout << "Done with initialization.\n";
+}
 
-    // init font
-    al_init_font_addon();
-    al_init_ttf_addon();
-    this->fontDef = al_load_font("lucon.ttf", 40, 0);
-    if( this->fontDef == NULL )
+// Read the font file into memory (runs on fontReader)
+void ECGraphicViewImp :: ReadFontFile()
+{
+    std::ifstream fontFile("lucon.ttf", std::ios::binary);
+    if( fontFile.is_open() )
+    {
+        fontBytes.assign(std::istreambuf_iterator<char>(fontFile), std::istreambuf_iterator<char>());
+    }
+    fFontBytesReady.store(true, std::memory_order_release);
+}
+
+// Create the font from the bytes read in the background; false while not (yet) available
+bool ECGraphicViewImp :: EnsureFont()
+{
+    if( fontDef != NULL )
+    {
+        return true;
+    }
+    if( fFontFailed || !fFontBytesReady.load(std::memory_order_acquire) )
+    {
+        return false;
+    }
+    if( !fontBytes.empty() )
+    {
+        // The memfile is owned (and closed) by the font
+        ALLEGRO_FILE *fontFile = al_open_memfile(&fontBytes[0], fontBytes.size(), "r");
+        if( fontFile != NULL )
+        {
+            fontDef = al_load_ttf_font_f(fontFile, "lucon.ttf", 40, 0);
+        }
+    }
+    if( fontDef == NULL )
     {
         cout << "Warning: font is not loaded!\n";
+        fFontFailed = true;
+        return false;
     }
- 
-cout << "Done with initialization.\n";
+    timeToFontReady = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - createTime).count();
+    return true;
 }
 
 void ECGraphicViewImp :: Shutdown()
 {
     //
+    if( fontReader.joinable() )
+    {
+        fontReader.join();
+    }
+    if( fontDef != NULL )
+    {
+        al_destroy_font(fontDef);
+        fontDef = NULL;
+    }
     if( display != NULL)
     {
         al_destroy_display(display);
@@ -235,7 +318,11 @@ ECGVEventType ECGraphicViewImp :: WaitForEvent()
     ALLEGRO_EVENT ev;
     al_wait_for_event(event_queue, &ev);
 //cout << "Process event...\n";
-    
+    return TranslateEvent(ev);
+}
+
+ECGVEventType ECGraphicViewImp :: TranslateEvent(const ALLEGRO_EVENT &ev)
+{
     if(ev.type == ALLEGRO_EVENT_DISPLAY_CLOSE)
     {
         return ECGV_EV_CLOSE;
@@ -271,6 +358,18 @@ ECGVEventType ECGraphicViewImp :: WaitForEvent()
             
             case ALLEGRO_KEY_G:
                 return ECGV_EV_KEY_DOWN_G;
+
+            case ALLEGRO_KEY_P:
+                return ECGV_EV_KEY_DOWN_P;
+
+            case ALLEGRO_KEY_F:
+                return ECGV_EV_KEY_DOWN_F;
+
+            case ALLEGRO_KEY_HOME:
+                return ECGV_EV_KEY_DOWN_HOME;
+
+            case ALLEGRO_KEY_H:
+                return ECGV_EV_KEY_DOWN_H;
                     
         }
     }
@@ -305,6 +404,18 @@ ECGVEventType ECGraphicViewImp :: WaitForEvent()
                 
             case ALLEGRO_KEY_G:
                 return ECGV_EV_KEY_UP_G;
+
+            case ALLEGRO_KEY_P:
+                return ECGV_EV_KEY_UP_P;
+
+            case ALLEGRO_KEY_F:
+                return ECGV_EV_KEY_UP_F;
+
+            case ALLEGRO_KEY_HOME:
+                return ECGV_EV_KEY_UP_HOME;
+
+            case ALLEGRO_KEY_H:
+                return ECGV_EV_KEY_UP_H;
                 
         }
     }
@@ -337,49 +448,69 @@ void ECGraphicViewImp :: GetCursorPosition(int &cx, int &cy) const
 void  ECGraphicViewImp :: DrawLine(int x1, int y1, int x2, int y2, int thickness, ECGVColor color)
 {
     // draw a line
+    numPrimitives++;
     al_draw_line(x1,y1,x2,y2,arrayAllegroColors[color],thickness);
 //cout << "Draw line: (" << x1 << "," << y1 << " to (" << x2 << "," << y2 << ")\n";
 }
 
 void ECGraphicViewImp :: DrawRectangle(int x1, int y1, int x2, int y2, int thickness, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_rectangle(x1, y1, x2, y2, arrayAllegroColors[color],thickness);
 }
 
 void ECGraphicViewImp :: DrawCircle(int xcenter, int ycenter, double radius, int thickness, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_circle(xcenter, ycenter, radius, arrayAllegroColors[color], thickness);
 }
 
 void ECGraphicViewImp :: DrawEllipse(int xcenter, int ycenter, double radiusx, double radiusy, int thickness, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_ellipse(xcenter, ycenter, radiusx, radiusy, arrayAllegroColors[color], thickness);
 }
 
 void ECGraphicViewImp :: DrawFilledRectangle(int x1, int y1, int x2, int y2, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_filled_rectangle(x1, y1, x2, y2, arrayAllegroColors[color]);;
 }
 
+void ECGraphicViewImp :: DrawFilledRectangleRGB(int x1, int y1, int x2, int y2, unsigned char r, unsigned char g, unsigned char b)
+{
+    numPrimitives++;
+    al_draw_filled_rectangle(x1, y1, x2, y2, al_map_rgb(r, g, b));
+}
+
 void ECGraphicViewImp :: DrawFilledCircle(int xcenter, int ycenter, double radius, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_filled_circle(xcenter, ycenter, radius, arrayAllegroColors[color]);
 }
 
 void ECGraphicViewImp :: DrawFilledEllipse(int xcenter, int ycenter, double radiusx, double radiusy, ECGVColor color)
 {
+    numPrimitives++;
     al_draw_filled_ellipse(xcenter, ycenter, radiusx, radiusy, arrayAllegroColors[color]);
 }
 
 void ECGraphicViewImp :: DrawText(int xcenter, int ycenter, const char *ptext, ECGVColor color)
 {
+    if( !EnsureFont() )
+    {
+        return;
+    }
+    numTextCalls++;
     al_draw_text(this->fontDef, arrayAllegroColors[color], xcenter, ycenter, ALLEGRO_ALIGN_CENTER, ptext);
 }
 
 void ECGraphicViewImp :: DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, int thickness, ECGVColor color) {
+	numPrimitives++;
 	al_draw_triangle(x1, y1, x2, y2, x3, y3, arrayAllegroColors[color], thickness);
 }
 
 void ECGraphicViewImp :: DrawFilledTriangle(int x1, int y1, int x2, int y2, int x3, int y3, ECGVColor color) {
+	numPrimitives++;
 	al_draw_filled_triangle(x1, y1, x2, y2, x3, y3, arrayAllegroColors[color]);
 }
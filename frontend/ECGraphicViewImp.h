@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "ECObserver.h"
 #include <allegro5/allegro.h>
 #include <allegro5/allegro_font.h>
@@ -37,7 +40,15 @@ enum ECGVEventType {
     ECGV_EV_KEY_UP_SPACE = 21,
     ECGV_EV_KEY_DOWN_SPACE = 22,
     ECGV_EV_KEY_DOWN_G = 23,
-    ECGV_EV_KEY_UP_G = 24
+    ECGV_EV_KEY_UP_G = 24,
+    ECGV_EV_KEY_DOWN_P = 25,
+    ECGV_EV_KEY_UP_P = 26,
+    ECGV_EV_KEY_DOWN_F = 27,
+    ECGV_EV_KEY_UP_F = 28,
+    ECGV_EV_KEY_DOWN_HOME = 29,
+    ECGV_EV_KEY_UP_HOME = 30,
+    ECGV_EV_KEY_DOWN_H = 31,
+    ECGV_EV_KEY_UP_H = 32
 };
 
 //***********************************************************
@@ -61,8 +72,17 @@ extern ALLEGRO_COLOR arrayAllegroColors[ECGV_NUM_COLORS];
 
 class ECGraphicViewImp : public ECObserverSubject {
 public:
-    // Create a view with size (width, height)
+    // Initialize Allegro and the addons the view uses (primitives, font, ttf,
+    // image). Safe to call more than once; only the first call does anything.
+    static bool InitAllegro();
+
+    // Create a view with size (width, height). The view owns the program's only
+    // display, timer and event queue. The font is read in the background and
+    // text is skipped until it is ready, so the first frame is not held up.
     ECGraphicViewImp(int width, int height);
+    // Create a headless view that draws into target (e.g. a memory bitmap) with no
+    // display, timer or events. Makes target the calling thread's drawing target.
+    ECGraphicViewImp(int width, int height, ALLEGRO_BITMAP *target);
     virtual ~ECGraphicViewImp();
     
     // Show the view. This would enter a forever loop, until quit is set. 
@@ -76,16 +96,39 @@ public:
     int GetWidth() const { return widthView; }
     int GetHeight() const { return heightView; }
     
+    // The window drawn to (NULL for a headless view). A thread other than the one
+    // that created it must make it current with al_set_target_backbuffer.
+    ALLEGRO_DISPLAY *GetDisplay() const { return display; }
+
+    // Display, keyboard, mouse and timer events; the timer starts at 60 ticks per second
+    ALLEGRO_EVENT_QUEUE *GetEventQueue() const { return event_queue; }
+    ALLEGRO_TIMER *GetTimer() const { return timer; }
+
+    // Startup timings, in ms since the view was created (-1 until they happen)
+    double GetTimeToFirstFrame() const { return timeToFirstFrame; }
+    double GetTimeToFontReady() const { return timeToFontReady; }
+
     // Get cursor position (cx, cy)
     void GetCursorPosition(int &cx, int &cy) const;
 
     // The current event
     ECGVEventType GetCurrEvent() const { return evtCurrent; }
 
+    // Map an Allegro event to the view's event codes
+    static ECGVEventType TranslateEvent(const ALLEGRO_EVENT &ev);
+
+    // Present the frame drawn so far and start counting draw calls for the next one
+    void FlipDisplay();
+
+    // Draw calls made for the last presented frame
+    int GetLastFramePrimitives() const { return lastFramePrimitives; }
+    int GetLastFrameTextCalls() const { return lastFrameTextCalls; }
+
     // Drawing functions
     void DrawLine(int x1, int y1, int x2, int y2, int thickness=3, ECGVColor color=ECGV_BLACK);
     void DrawRectangle(int x1, int y1, int x2, int y2, int thickness=3, ECGVColor color=ECGV_BLACK);
     void DrawFilledRectangle(int x1, int y1, int x2, int y2, ECGVColor color=ECGV_BLACK);
+    void DrawFilledRectangleRGB(int x1, int y1, int x2, int y2, unsigned char r, unsigned char g, unsigned char b);   // any color, for heatmaps
     void DrawCircle(int xcenter, int ycenter, double radius, int thickness=3, ECGVColor color=ECGV_BLACK);
     void DrawFilledCircle(int xcenter, int ycenter, double radius, ECGVColor color=ECGV_BLACK);
     void DrawEllipse(int xcenter, int ycenter, double radiusx, double radiusy, int thickness=3, ECGVColor color=ECGV_BLACK);
@@ -103,6 +146,8 @@ private:
     // Internal functions
     void Init();
     void Shutdown();
+    void ReadFontFile();     // background thread
+    bool EnsureFont();       // create the font once its bytes are in
     ECGVEventType  WaitForEvent();
 
     // Data members
@@ -111,11 +156,28 @@ private:
     bool fRedraw;
     ECGVEventType evtCurrent;
 
+    // Draw call counts: current frame, and the last presented one
+    int numPrimitives;
+    int numTextCalls;
+    int lastFramePrimitives;
+    int lastFrameTextCalls;
+
     // Allegro related data
     ALLEGRO_DISPLAY *display;
     ALLEGRO_EVENT_QUEUE *event_queue;
     ALLEGRO_TIMER *timer;
     ALLEGRO_FONT *fontDef;
+
+    // Lazily loaded font
+    std::thread fontReader;
+    std::vector<char> fontBytes;
+    std::atomic<bool> fFontBytesReady;
+    bool fFontFailed;
+
+    // Startup timings
+    std::chrono::steady_clock::time_point createTime;
+    double timeToFirstFrame;
+    double timeToFontReady;
 };
 
 #endif /* ECGraphicViewImp_h */
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "ECRenderThread.h"
+#include "ECTraceEvents.h"
+#include <chrono>
+
+void ECRenderThread::Start() {
+    if (fRunning.load()) {
+        return;
+    }
+    // An OpenGL/Direct3D context can only be current on one thread at a time
+    al_set_target_bitmap(NULL);
+    fRunning.store(true);
+    thread = std::thread(&ECRenderThread::Run, this);
+}
+
+void ECRenderThread::Stop() {
+    if (!fRunning.load()) {
+        return;
+    }
+    fRunning.store(false);
+    thread.join();
+    if (view.GetDisplay() != NULL) {
+        al_set_target_backbuffer(view.GetDisplay());
+    }
+}
+
+void ECRenderThread::Run() {
+    EC_TRACE_THREAD_NAME("render");
+    al_set_target_backbuffer(view.GetDisplay());
+
+    ECSceneRenderer renderer(view);
+    renderer.SetFrameBudget(1000.0 / 60.0);
+    renderer.SetRollup(rollup);
+    ECFrameStats stats;
+    double lastFlipTime = al_get_time();
+
+    while (fRunning.load()) {
+        if (!frames.Acquire()) {
+            // Nothing new to show
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        const ECSceneFrame &frame = frames.GetReadBuffer();
+
+        double drawStart = al_get_time();
+        renderer.DrawScene(frame);
+        if (frame.fShowProfilerOverlay) {
+            renderer.DrawProfilerOverlay(frame, stats);
+        }
+        {
+            EC_TRACE_SCOPE("al_flip_display");
+            view.FlipDisplay();
+        }
+
+        double flipTime = al_get_time();
+        stats.GetDrawTimes().Add((flipTime - drawStart) * 1000.0);
+        stats.GetFrameTimes().Add((flipTime - lastFlipTime) * 1000.0);
+        stats.SetDrawCounts(view.GetLastFramePrimitives(), view.GetLastFrameTextCalls());
+        renderer.ReportFrameTime((flipTime - drawStart) * 1000.0);
+        lastFlipTime = flipTime;
+    }
+
+    al_set_target_bitmap(NULL);
+}
@@ -0,0 +1,40 @@
+#ifndef ECRENDERTHREAD_H
+#define ECRENDERTHREAD_H
+
+#include "ECGraphicViewImp.h"
+#include "ECSceneRenderer.h"
+#include "ECTripleBuffer.h"
+#include <atomic>
+#include <thread>
+
+//*****************************************************************************
+// Draws scene frames on a thread of its own. The update thread publishes frames
+// into the triple buffer at its own pace; this thread draws and flips the
+// newest one whenever it changes, so slow frames never hold up input handling
+// or the simulation. Level of detail, draw timings and the profiler overlay's
+// frame numbers all live on this thread.
+class ECRenderThread
+{
+public:
+    ECRenderThread(ECGraphicViewImp &viewIn, ECTripleBuffer<ECSceneFrame> &framesIn) : view(viewIn), frames(framesIn), rollup(NULL), fRunning(false) {}
+    ~ECRenderThread() { Stop(); }
+
+    // Called on the thread that owns the display; it gives the display up to the render thread
+    void Start();
+    // Joins the render thread and makes the display current on the calling thread again
+    void Stop();
+
+    // Rollups for the demand heatmap; set before Start, and kept alive until Stop
+    void SetRollup(const ECTimeRollup *rollupIn) { rollup = rollupIn; }
+
+private:
+    void Run();
+
+    ECGraphicViewImp &view;
+    ECTripleBuffer<ECSceneFrame> &frames;
+    const ECTimeRollup *rollup;
+    std::thread thread;
+    std::atomic<bool> fRunning;
+};
+
+#endif /* ECRENDERTHREAD_H */
@@ -0,0 +1,344 @@
+#include "ECSceneRenderer.h"
+#include "ECTraceEvents.h"
+#include <string>
+#include <cstdio>
+
+namespace {
+const int MIN_FIGURE_FLOOR_PIXELS = 120;   // floors shorter than this are too small for figures
+}
+
+// Draw the entire graphical scene
+void ECSceneRenderer::DrawScene(const ECSceneFrame &frame) {
+    EC_TRACE_SCOPE("ECSceneRenderer::DrawScene");
+
+    if (frame.numFloors == 0) {
+        return;
+    }
+
+    view.DrawFilledRectangle(0, 0, view.GetWidth(), view.GetHeight(), ECGV_YELLOW);
+
+    DrawElevator(frame);
+    DrawWaitingPassengers(frame);
+
+    if (frame.numSteps > 0) {
+        DrawProgressBar(frame.stepIndex, frame.numSteps);
+    }
+    if (frame.fShowHeatmap) {
+        DrawDemandHeatmap(frame.stepIndex);
+    }
+
+    view.DrawText(500, 3, ("Time: " + std::to_string(frame.stepIndex)).c_str(), ECGV_BLACK);
+}
+
+// Create the elevator with its passengers
+void ECSceneRenderer::DrawElevator(const ECSceneFrame &frame) {
+    EC_TRACE_SCOPE("ECSceneRenderer::DrawElevator");
+
+    const ECViewCamera &camera = frame.camera;
+    int elevatorYPos = camera.GetScreenY(frame.elevatorFloorPos);
+    int elevatorHeight = camera.GetScreenY(frame.elevatorFloorPos - 1) - elevatorYPos;
+    int elevatorWidth = view.GetWidth() - 130;
+
+    // Culled when scrolled out of view
+    if (elevatorYPos + elevatorHeight < 0 || elevatorYPos > view.GetHeight()) {
+        return;
+    }
+
+    view.DrawFilledRectangle(30, elevatorYPos, 30 + elevatorWidth, elevatorYPos + elevatorHeight, ECGV_PURPLE);
+
+    int headSize = 25;
+    int offset = 60;
+    int numRiders = frame.elevatorPassengers.size();
+    int capacity = (elevatorWidth - 20 - headSize) / offset + 1;
+
+    if (!DrawIndividually(numRiders, capacity, camera)) {
+        int upCount = 0;
+        for (int i = 0; i < numRiders; ++i) {
+            if (frame.elevatorPassengers[i] > frame.currentFloor) {
+                upCount++;
+            }
+        }
+        int margin = elevatorHeight / 10;
+        DrawCrowdGlyph(50, elevatorYPos + margin, 30 + elevatorWidth - 20, elevatorYPos + elevatorHeight - margin,
+                       upCount, numRiders - upCount);
+        return;
+    }
+
+    for (int i = 0; i < numRiders; ++i) {
+        int headX = 30 + 20 + i * offset;
+
+        if (detail == EC_DETAIL_REDUCED) {
+            view.DrawFilledCircle(headX, elevatorYPos + headSize, headSize, ECGV_RED);
+        } else {
+            view.DrawCircle(headX, elevatorYPos + headSize, headSize, ECGV_RED);
+            view.DrawLine(headX, elevatorYPos + headSize * 2, headX, elevatorYPos + elevatorHeight - 10, ECGV_RED);
+        }
+        view.DrawText(headX - 5, elevatorYPos + headSize - 10, std::to_string(frame.elevatorPassengers[i]).c_str(), ECGV_BLACK);
+    }
+}
+
+// Draw waiting passengers on each visible floor
+void ECSceneRenderer::DrawWaitingPassengers(const ECSceneFrame &frame) {
+    EC_TRACE_SCOPE("ECSceneRenderer::DrawWaitingPassengers");
+
+    if (frame.numFloors == 0) {
+        return;
+    }
+
+    const ECViewCamera &camera = frame.camera;
+    int spacing = 40;
+    int capacity = (view.GetWidth() - spacing) / spacing;   // people that fit right-aligned on screen
+
+    // Only the floors in view
+    int lastFloor = camera.GetLastVisibleFloor();
+    if (lastFloor > static_cast<int>(frame.waitingPassengers.size())) {
+        lastFloor = frame.waitingPassengers.size();
+    }
+    for (int floor = camera.GetFirstVisibleFloor(); floor <= lastFloor; ++floor) {
+        int levelY = camera.GetScreenY(floor);
+        int levelHeight = camera.GetScreenY(floor - 1) - levelY;
+        int numWaiting = frame.waitingPassengers[floor - 1];
+
+        // Draw the floor line
+        view.DrawLine(0, levelY, view.GetWidth(), levelY, ECGV_BLACK);
+
+        if (numWaiting <= 0) {
+            continue;
+        }
+
+        // Half go up, the rest go down
+        int upCount = numWaiting / 2;
+
+        if (!DrawIndividually(numWaiting, capacity, camera)) {
+            int margin = levelHeight / 10;
+            DrawCrowdGlyph(view.GetWidth() / 2, levelY + margin, view.GetWidth() - 10, levelY + levelHeight - margin,
+                           upCount, numWaiting - upCount);
+            continue;
+        }
+
+        int passengerX = view.GetWidth() - (spacing * numWaiting);
+        int passengerY = levelY + levelHeight / 2 - 20;
+
+        for (int j = 0; j < numWaiting; ++j) {
+            int x = passengerX + j * spacing;
+
+            if (detail == EC_DETAIL_REDUCED) {
+                view.DrawFilledCircle(x, passengerY, 15, j < upCount ? ECGV_BLUE : ECGV_BLACK);
+                continue;
+            }
+
+            // Draw passenger circle and body
+            view.DrawCircle(x, passengerY, 15, ECGV_BLACK);
+            view.DrawLine(x, passengerY + 15, x, passengerY + 45, ECGV_BLACK);
+
+            // Draw direction indicator
+            if (j < upCount) {
+                view.DrawTriangle(x, passengerY - 20, x - 10, passengerY - 10, x + 10, passengerY - 10, ECGV_BLACK);
+            } else {
+                view.DrawTriangle(x, passengerY + 50, x - 10, passengerY + 40, x + 10, passengerY + 40, ECGV_BLACK);
+            }
+        }
+    }
+}
+
+bool ECSceneRenderer::DrawIndividually(int numPeople, int capacity, const ECViewCamera &camera) const {
+    return detail != EC_DETAIL_AGGREGATE && numPeople <= densityThreshold && numPeople <= capacity &&
+           camera.GetPixelsPerFloor() >= MIN_FIGURE_FLOOR_PIXELS;
+}
+
+// A crowd as two rows: an up arrow, a bar and the count of people going up,
+// then the same for down. Bars grow with the count but stay inside the box.
+// Boxes too short for text get a single row: the up bar, then the down bar.
+void ECSceneRenderer::DrawCrowdGlyph(int left, int top, int right, int bottom, int upCount, int downCount) {
+    const int arrowSize = 12;
+    const int pixelsPerPerson = 6;
+    const int minRowsHeight = 80;
+    int rowHeight = (bottom - top) / 2;
+
+    if (bottom - top < minRowsHeight) {
+        int maxBar = right - left;
+        int upLength = upCount * pixelsPerPerson;
+        int downLength = downCount * pixelsPerPerson;
+        if (upLength + downLength > maxBar) {
+            upLength = static_cast<long long>(maxBar) * upCount / (upCount + downCount);
+            downLength = maxBar - upLength;
+        }
+        int barBottom = bottom > top ? bottom : top + 1;
+        if (upLength > 0) {
+            view.DrawFilledRectangle(left, top, left + upLength, barBottom, ECGV_BLUE);
+        }
+        if (downLength > 0) {
+            view.DrawFilledRectangle(left + upLength, top, left + upLength + downLength, barBottom, ECGV_BLACK);
+        }
+        return;
+    }
+
+    int barLeft = left + 2 * arrowSize + 4;
+    int maxBar = right - barLeft - 80;   // room left for the count
+
+    int counts[] = { upCount, downCount };
+    for (int row = 0; row < 2; ++row) {
+        int centerY = top + row * rowHeight + rowHeight / 2;
+        int x = left + arrowSize;
+        if (row == 0) {
+            view.DrawFilledTriangle(x, centerY - arrowSize, x - arrowSize, centerY + arrowSize, x + arrowSize, centerY + arrowSize, ECGV_BLACK);
+        } else {
+            view.DrawFilledTriangle(x, centerY + arrowSize, x - arrowSize, centerY - arrowSize, x + arrowSize, centerY - arrowSize, ECGV_BLACK);
+        }
+
+        int barLength = counts[row] * pixelsPerPerson;
+        if (barLength > maxBar) {
+            barLength = maxBar;
+        }
+        if (barLength > 0) {
+            view.DrawFilledRectangle(barLeft, centerY - arrowSize / 2, barLeft + barLength, centerY + arrowSize / 2, ECGV_BLUE);
+        }
+        view.DrawText(barLeft + barLength + 40, centerY - 20, std::to_string(counts[row]).c_str(), ECGV_BLACK);
+    }
+}
+
+// Lower the detail after a few frames over budget; raise it after many comfortably under
+void ECSceneRenderer::ReportFrameTime(double ms) {
+    if (frameBudgetMs <= 0.0) {
+        return;
+    }
+
+    const int framesToLower = 3;
+    const int framesToRaise = 60;
+
+    if (ms > frameBudgetMs) {
+        underBudgetFrames = 0;
+        if (++overBudgetFrames >= framesToLower && detail != EC_DETAIL_AGGREGATE) {
+            detail = static_cast<EC_SCENE_DETAIL>(detail + 1);
+            overBudgetFrames = 0;
+        }
+    } else if (ms < frameBudgetMs / 2) {
+        overBudgetFrames = 0;
+        if (++underBudgetFrames >= framesToRaise && detail != EC_DETAIL_FULL) {
+            detail = static_cast<EC_SCENE_DETAIL>(detail - 1);
+            underBudgetFrames = 0;
+        }
+    } else {
+        overBudgetFrames = 0;
+        underBudgetFrames = 0;
+    }
+}
+
+// Draw progress bar for simulation time
+void ECSceneRenderer::DrawProgressBar(int currentTime, int maxTime) {
+    if (maxTime == 0) {
+        return;
+    }
+
+    int barWidth = view.GetWidth() - 20;
+
+    double progressRatio = static_cast<double>(currentTime) / maxTime;
+    int filledWidth = static_cast<int>(barWidth * progressRatio);
+
+    // Draw the filled portion of the progress bar, then its border
+    view.DrawFilledRectangle(10, 40, 10 + filledWidth, 60, ECGV_BLUE);
+    view.DrawRectangle(10, 40, 10 + barWidth, 60, 2, ECGV_BLACK);
+}
+
+// Draw frame timings (avg / p99, in ms), per-frame draw call counts and the level of detail in the top right corner
+void ECSceneRenderer::DrawProfilerOverlay(const ECSceneFrame &frame, const ECFrameStats &renderStats) {
+    const int left = view.GetWidth() - 480;
+    const int centerX = left + 235;
+    const int lineHeight = 45;
+    int y = 75;
+
+    view.DrawFilledRectangle(left, y - 5, view.GetWidth() - 10, y + 6 * lineHeight + 5, ECGV_WHITE);
+    view.DrawRectangle(left, y - 5, view.GetWidth() - 10, y + 6 * lineHeight + 5, 2, ECGV_BLACK);
+
+    char line[64];
+    double averages[] = { renderStats.GetFrameTimes().GetAverage(), renderStats.GetDrawTimes().GetAverage(),
+                          frame.updateMsAvg, frame.eventMsAvg };
+    double p99s[] = { renderStats.GetFrameTimes().GetPercentile(0.99), renderStats.GetDrawTimes().GetPercentile(0.99),
+                      frame.updateMsP99, frame.eventMsP99 };
+    const char *labels[] = { "frame", "draw", "update", "event" };
+    for (int i = 0; i < 4; ++i) {
+        snprintf(line, sizeof(line), "%s %.1f/%.1f", labels[i], averages[i], p99s[i]);
+        view.DrawText(centerX, y, line, ECGV_BLACK);
+        y += lineHeight;
+    }
+    snprintf(line, sizeof(line), "prims %d text %d", renderStats.GetPrimitivesPerFrame(), renderStats.GetTextCallsPerFrame());
+    view.DrawText(centerX, y, line, ECGV_BLACK);
+    y += lineHeight;
+
+    const char *detailNames[] = { "full", "reduced", "aggregate" };
+    snprintf(line, sizeof(line), "detail %s", detailNames[detail]);
+    view.DrawText(centerX, y, line, ECGV_BLACK);
+}
+
+void ECSceneRenderer::SetRollup(const ECTimeRollup *rollupIn) {
+    rollup = rollupIn;
+    heatmapLevel = -1;
+    heatmapMaxCalls = 0;
+    if (rollup == NULL || rollup->GetNumLevels() == 0) {
+        return;
+    }
+
+    // One slot per pixel column at most, at the finest resolution that covers the whole run
+    heatmapLevel = rollup->ChooseLevel(view.GetWidth() - 20);
+    const ECRollupLevel &level = rollup->GetLevel(heatmapLevel);
+    for (int slot = 0; slot < level.GetNumSlots(); ++slot) {
+        for (int floor = 1; floor <= rollup->GetNumFloors(); ++floor) {
+            if (level.GetCell(slot, floor).calls > heatmapMaxCalls) {
+                heatmapMaxCalls = level.GetCell(slot, floor).calls;
+            }
+        }
+    }
+}
+
+// Floors as rows (top floor on top) and rollup slots as columns, under the progress bar;
+// the busier the slot, the redder the cell. A line marks the current time.
+void ECSceneRenderer::DrawDemandHeatmap(int currentTime) {
+    if (heatmapLevel < 0) {
+        return;
+    }
+    EC_TRACE_SCOPE("ECSceneRenderer::DrawDemandHeatmap");
+
+    const ECRollupLevel &level = rollup->GetLevel(heatmapLevel);
+    int numFloors = rollup->GetNumFloors();
+    int numSlots = level.GetNumSlots();
+    if (numSlots == 0) {
+        return;
+    }
+
+    const int left = 10;
+    const int top = 65;
+    int width = view.GetWidth() - 20;
+    int rowHeight = 200 / numFloors > 4 ? 200 / numFloors : 4;
+    int bottom = top + rowHeight * numFloors;
+
+    view.DrawFilledRectangle(left, top, left + width, bottom, ECGV_WHITE);
+
+    int firstTime = level.GetSlotStart(0);
+    int spanTicks = level.GetSlotStart(numSlots - 1) + level.GetResolution() - firstTime;
+    for (int slot = 0; slot < numSlots; ++slot) {
+        int x1 = left + static_cast<long long>(level.GetSlotStart(slot) - firstTime) * width / spanTicks;
+        int x2 = left + static_cast<long long>(level.GetSlotStart(slot) + level.GetResolution() - firstTime) * width / spanTicks;
+        if (x2 <= x1) {
+            x2 = x1 + 1;
+        }
+        for (int floor = 1; floor <= numFloors; ++floor) {
+            int calls = level.GetCell(slot, floor).calls;
+            if (calls == 0 || heatmapMaxCalls == 0) {
+                continue;
+            }
+            int y = top + (numFloors - floor) * rowHeight;
+            unsigned char fade = static_cast<unsigned char>(230 - 230 * calls / heatmapMaxCalls);
+            view.DrawFilledRectangleRGB(x1, y, x2, y + rowHeight, 255, fade, fade);
+        }
+    }
+
+    if (currentTime >= firstTime && currentTime < firstTime + spanTicks) {
+        int x = left + static_cast<long long>(currentTime - firstTime) * width / spanTicks;
+        view.DrawLine(x, top, x, bottom, ECGV_BLACK);
+    }
+    view.DrawRectangle(left, top, left + width, bottom, 2, ECGV_BLACK);
+
+    char label[64];
+    snprintf(label, sizeof(label), "calls per %d s (max %d)", level.GetResolution(), heatmapMaxCalls);
+    view.DrawText(left + width / 2, bottom + 5, label, ECGV_BLACK);
+}
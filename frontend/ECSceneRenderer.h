@@ -0,0 +1,95 @@
+#ifndef ECSCENERENDERER_H
+#define ECSCENERENDERER_H
+
+#include "ECGraphicViewImp.h"
+#include "ECViewCamera.h"
+#include "ECFrameStats.h"
+#include "ECTimeRollup.h"
+#include <vector>
+
+//*****************************************************************************
+// Everything needed to draw one frame of the building. Self-contained, so a
+// frame can be built by one thread and drawn by another.
+struct ECSceneFrame
+{
+    ECSceneFrame() : numFloors(0), currentFloor(1), elevatorFloorPos(1.0), stepIndex(0), numSteps(0),
+        fShowHeatmap(false), fShowProfilerOverlay(false), updateMsAvg(0.0), updateMsP99(0.0), eventMsAvg(0.0), eventMsP99(0.0) {}
+
+    int numFloors;                        // floors in the building
+    int currentFloor;                     // floor the car is at (or last left)
+    double elevatorFloorPos;              // car position in floors (fractional while moving)
+    int stepIndex;                        // trace step shown (the clock)
+    int numSteps;                         // trace steps in total, for the progress bar
+    std::vector<int> elevatorPassengers;  // destination floor of each rider
+    std::vector<int> waitingPassengers;   // number of people waiting on each floor
+    ECViewCamera camera;                  // part of the building in view
+    bool fShowHeatmap;                    // draw the demand heatmap under the progress bar
+
+    // Profiler overlay; timings measured on the thread that built the frame
+    bool fShowProfilerOverlay;
+    double updateMsAvg;
+    double updateMsP99;
+    double eventMsAvg;
+    double eventMsP99;
+};
+
+//*****************************************************************************
+// How people are drawn. A car or floor holding more people than fit, or more
+// than the density threshold, is always drawn aggregated.
+typedef enum {
+    EC_DETAIL_FULL = 0,     // a figure with a direction arrow per person
+    EC_DETAIL_REDUCED,      // a dot per person
+    EC_DETAIL_AGGREGATE     // counts and direction bars only
+} EC_SCENE_DETAIL;
+
+//*****************************************************************************
+// Draws scene frames onto a view. Holds no scene state of its own; each thread
+// that renders needs its own view (and so its own renderer).
+//
+// With a frame budget set, ReportFrameTime() acts as a governor: a run of
+// frames over budget lowers the detail a step, and a long run well under
+// budget raises it again.
+class ECSceneRenderer
+{
+public:
+    explicit ECSceneRenderer(ECGraphicViewImp &viewIn) : view(viewIn), detail(EC_DETAIL_FULL), densityThreshold(10),
+        frameBudgetMs(0.0), overBudgetFrames(0), underBudgetFrames(0), rollup(NULL), heatmapLevel(-1), heatmapMaxCalls(0) {}
+
+    void DrawScene(const ECSceneFrame &frame);
+    void DrawElevator(const ECSceneFrame &frame);  // the car and its riders
+    void DrawWaitingPassengers(const ECSceneFrame &frame);  // people waiting on each floor
+    void DrawProgressBar(int currentTime, int maxTime);  // simulation time so far
+    void DrawProfilerOverlay(const ECSceneFrame &frame, const ECFrameStats &renderStats);  // timings, draw calls, detail
+    void DrawDemandHeatmap(int currentTime);  // hall calls per floor over time, from the rollups
+
+    // Rollups the heatmap is drawn from (not owned; NULL for none). Never changed while drawing.
+    void SetRollup(const ECTimeRollup *rollupIn);
+
+    ECGraphicViewImp &GetView() { return view; }
+
+    // Level of detail
+    void SetDetail(EC_SCENE_DETAIL detailIn) { detail = detailIn; }
+    EC_SCENE_DETAIL GetDetail() const { return detail; }
+    void SetDensityThreshold(int numPeople) { densityThreshold = numPeople; }   // most people drawn one by one per car/floor
+
+    // Frame-budget governor; a budget of 0 turns it off
+    void SetFrameBudget(double ms) { frameBudgetMs = ms; }
+    void ReportFrameTime(double ms);
+
+private:
+    bool DrawIndividually(int numPeople, int capacity, const ECViewCamera &camera) const;
+    void DrawCrowdGlyph(int left, int top, int right, int bottom, int upCount, int downCount);
+
+    ECGraphicViewImp &view;
+    EC_SCENE_DETAIL detail;
+    int densityThreshold;
+    double frameBudgetMs;
+    int overBudgetFrames;    // consecutive frames over budget
+    int underBudgetFrames;   // consecutive frames under half the budget
+
+    const ECTimeRollup *rollup;
+    int heatmapLevel;        // rollup level that fits the heatmap's width; -1 if none
+    int heatmapMaxCalls;     // busiest cell of that level, for the color scale
+};
+
+#endif /* ECSCENERENDERER_H */
@@ -0,0 +1,50 @@
+#ifndef ECTRIPLEBUFFER_H
+#define ECTRIPLEBUFFER_H
+
+#include <atomic>
+
+//*****************************************************************************
+// Lock-free triple buffer for handing whole values from one writer thread to
+// one reader thread. The writer fills GetWriteBuffer() and calls Publish();
+// the reader calls Acquire() and, if it returns true, reads the newest value
+// from GetReadBuffer(). Neither side ever waits for the other: the writer can
+// publish faster than the reader draws (older values are skipped), and the
+// reader keeps its current value for as long as it needs.
+//
+// Buffers are reused, so a writer that assigns into the existing members
+// (vector::assign and friends) does not allocate once capacities settle.
+template <class T>
+class ECTripleBuffer
+{
+public:
+    ECTripleBuffer() : writeIndex(0), sharedState(1), readIndex(2) {}
+
+    // Writer side
+    T &GetWriteBuffer() { return buffers[writeIndex]; }
+    void Publish() {
+        int previous = sharedState.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side; true if a newer value was published since the last call
+    bool Acquire() {
+        if ((sharedState.load(std::memory_order_acquire) & FRESH_BIT) == 0) {
+            return false;
+        }
+        int previous = sharedState.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+    const T &GetReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH_BIT = 4;      // set in sharedState when it holds an unread value
+
+    T buffers[3];
+    int writeIndex;                      // owned by the writer
+    std::atomic<int> sharedState;        // index of the buffer in the middle, plus FRESH_BIT
+    int readIndex;                       // owned by the reader
+};
+
+#endif /* ECTRIPLEBUFFER_H */
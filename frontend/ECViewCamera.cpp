@@ -0,0 +1,84 @@
+#include "ECViewCamera.h"
+#include <cmath>
+
+namespace {
+const double MIN_PIXELS_PER_FLOOR = 4.0;
+const double MAX_PIXELS_PER_FLOOR = 400.0;
+}
+
+void ECViewCamera::SetBounds(int numFloorsIn, int viewHeightIn) {
+    if (numFloorsIn == numFloors && viewHeightIn == viewHeight) {
+        return;
+    }
+    numFloors = numFloorsIn > 0 ? numFloorsIn : 1;
+    viewHeight = viewHeightIn > 0 ? viewHeightIn : 1;
+    if (mode == EC_CAMERA_FIT) {
+        Fit();
+    } else {
+        Clamp();
+    }
+}
+
+void ECViewCamera::Fit() {
+    mode = EC_CAMERA_FIT;
+    pixelsPerFloor = static_cast<double>(viewHeight) / numFloors;
+    centerFloor = numFloors / 2.0;
+}
+
+void ECViewCamera::Scroll(double floors) {
+    mode = EC_CAMERA_FREE;
+    centerFloor += floors;
+    Clamp();
+}
+
+void ECViewCamera::Zoom(double factor) {
+    if (mode == EC_CAMERA_FIT) {
+        mode = EC_CAMERA_FREE;
+    }
+    pixelsPerFloor *= factor;
+    if (pixelsPerFloor < MIN_PIXELS_PER_FLOOR) {
+        pixelsPerFloor = MIN_PIXELS_PER_FLOOR;
+    } else if (pixelsPerFloor > MAX_PIXELS_PER_FLOOR) {
+        pixelsPerFloor = MAX_PIXELS_PER_FLOOR;
+    }
+    Clamp();
+}
+
+void ECViewCamera::ToggleFollow() {
+    mode = (mode == EC_CAMERA_FOLLOW) ? EC_CAMERA_FREE : EC_CAMERA_FOLLOW;
+}
+
+void ECViewCamera::Track(double carFloorPos) {
+    if (mode == EC_CAMERA_FOLLOW) {
+        centerFloor = carFloorPos - 0.5;   // middle of the car
+        Clamp();
+    }
+}
+
+// Keep the building filling the view, or centered if it is shorter than the view
+void ECViewCamera::Clamp() {
+    double halfSpan = viewHeight / 2.0 / pixelsPerFloor;
+    if (2 * halfSpan >= numFloors) {
+        centerFloor = numFloors / 2.0;
+    } else if (centerFloor < halfSpan) {
+        centerFloor = halfSpan;
+    } else if (centerFloor > numFloors - halfSpan) {
+        centerFloor = numFloors - halfSpan;
+    }
+}
+
+int ECViewCamera::GetScreenY(double floorPos) const {
+    return static_cast<int>(std::floor(viewHeight / 2.0 - (floorPos - centerFloor) * pixelsPerFloor + 0.5));
+}
+
+int ECViewCamera::GetFirstVisibleFloor() const {
+    double bottom = centerFloor - viewHeight / 2.0 / pixelsPerFloor;
+    int floor = static_cast<int>(std::floor(bottom)) + 1;
+    return floor < 1 ? 1 : floor;
+}
+
+int ECViewCamera::GetLastVisibleFloor() const {
+    double top = centerFloor + viewHeight / 2.0 / pixelsPerFloor;
+    int floor = static_cast<int>(std::ceil(top));
+    return floor > numFloors ? numFloors : floor;
+}
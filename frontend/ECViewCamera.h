@@ -0,0 +1,54 @@
+#ifndef ECVIEWCAMERA_H
+#define ECVIEWCAMERA_H
+
+//*****************************************************************************
+// Maps building coordinates to the screen. The building is measured in floors:
+// floor f spans [f-1, f), so a car at floor f has its bottom at f-1 and its
+// top at f. The camera looks at a center point with a zoom in pixels per floor.
+//
+// By default the whole building fits the view. Scrolling switches to a free
+// camera, as does zooming unless following; follow mode keeps the car centered.
+typedef enum {
+    EC_CAMERA_FIT = 0,      // whole building on screen
+    EC_CAMERA_FREE,         // scrolled / zoomed by hand
+    EC_CAMERA_FOLLOW        // centered on the car
+} EC_CAMERA_MODE;
+
+class ECViewCamera
+{
+public:
+    ECViewCamera() : mode(EC_CAMERA_FIT), numFloors(1), viewHeight(1), centerFloor(0.5), pixelsPerFloor(1.0) {}
+
+    // Size of the building and of the view; refits if in fit mode
+    void SetBounds(int numFloorsIn, int viewHeightIn);
+
+    // User controls
+    void Scroll(double floors);     // positive scrolls up
+    void Zoom(double factor);       // > 1 zooms in
+    void ToggleFollow();
+    void Fit();
+
+    // Keep the car centered when following
+    void Track(double carFloorPos);
+
+    EC_CAMERA_MODE GetMode() const { return mode; }
+    double GetPixelsPerFloor() const { return pixelsPerFloor; }
+
+    // Screen Y of a building height (in floors)
+    int GetScreenY(double floorPos) const;
+
+    // Floors (1-based) intersecting the view; empty if first > last
+    int GetFirstVisibleFloor() const;
+    int GetLastVisibleFloor() const;
+
+private:
+    void Clamp();
+
+    EC_CAMERA_MODE mode;
+    int numFloors;
+    int viewHeight;
+    double centerFloor;       // building height shown at the middle of the view
+    double pixelsPerFloor;
+};
+
+#endif /* ECVIEWCAMERA_H */
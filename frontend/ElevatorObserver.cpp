@@ -1,25 +1,27 @@
 #include "ElevatorObserver.h"
+#include "ECTraceEvents.h"
 #include <cstdlib>  // For random number generation
 #include <thread>   // For std::this_thread::sleep_for
 #include <chrono>   // For std::chrono::milliseconds
 #include <fstream>  // For file input
 #include <sstream>  // For string streams
 #include <iostream>
+#include <cstdio>
 
 // Constructor for ElevatorHandler
 ElevatorHandler::ElevatorHandler(ECGraphicViewImp &viewInstance, std::shared_ptr<ECElevatorSim> simInstance, const std::string &dataFile)
     : graphicView(viewInstance), elevatorSim(simInstance), isPaused(false), isSimulationComplete(false), currentTick(0),
       currentFloor(1), targetFloor(1), numFloors(elevatorSim->GetTotalFloors()), 
-      totalTicks(0), ticksPerFloor(10), moveEndTime(0), moveSpeed(0),isElevatorMoving(false), hasPrintedCompletionMessage(false) {
+      totalTicks(0), ticksPerFloor(10), moveEndTime(0), moveSpeed(0),isElevatorMoving(false), hasPrintedCompletionMessage(false),
+      showProfilerOverlay(false), showHeatmap(false) {
 
-    int floorHeight = graphicView.GetHeight() / numFloors;
-    elevatorYPos = graphicView.GetHeight() - (currentFloor * floorHeight);
+    elevatorFloorPos = currentFloor;
 
     waitingPassengers.resize(numFloors, 0);
     waitingDirections.resize(numFloors, 0);
-    elevatorPassengers.clear();
+    elevatorPassengers = ECCarLoad(numFloors);
 
-    std::cout << "ElevatorHandler initialized. NumFloors: " << numFloors << ", ElevatorYPos: " << elevatorYPos << std::endl;
+    std::cout << "ElevatorHandler initialized. NumFloors: " << numFloors << ", ElevatorFloorPos: " << elevatorFloorPos << std::endl;
 
     LoadSimulationData(dataFile);
 
@@ -33,6 +35,7 @@ ElevatorHandler::ElevatorHandler(ECGraphicViewImp &viewInstance, std::shared_ptr
 
 // Function to load the simulation data from a file
 void ElevatorHandler::LoadSimulationData(const std::string &filename) {
+    EC_TRACE_SCOPE("ElevatorHandler::LoadSimulationData");
     std::ifstream inFile(filename);
     if (!inFile.is_open()) {
         std::cerr << "Error opening file: " << filename << std::endl;
@@ -80,6 +83,7 @@ void ElevatorHandler::LoadSimulationData(const std::string &filename) {
 }
 
 void ElevatorHandler::ParseAndUpdateFromStep(const std::string &stepData) {
+    EC_TRACE_SCOPE("ElevatorHandler::ParseAndUpdateFromStep");
     if (stepData.find("Waiting Passengers:") != std::string::npos) {
         std::istringstream iss(stepData.substr(stepData.find(":") + 1));
         bool validData = true;
@@ -113,8 +117,7 @@ void ElevatorHandler::ParseAndUpdateFromStep(const std::string &stepData) {
 
 void ElevatorHandler::ProcessPassengers() {
     // Synchronize boarding and alighting logic with backend
-    auto currentPassengers = elevatorSim->GetElevatorPassengers();
-    elevatorPassengers = currentPassengers;
+    elevatorPassengers = elevatorSim->GetCarLoad();
 
     // Update waiting passengers after boarding
     auto updatedWaiting = elevatorSim->GetWaitingPassengers();
@@ -143,9 +146,11 @@ bool isElevatorMoving = false;
 
 // Main event update function for the elevator
 void ElevatorHandler::Update() {
+    EC_TRACE_SCOPE("ElevatorHandler::Update");
+
     // Synchronize state from backend
     waitingPassengers = elevatorSim->GetWaitingPassengers();
-    elevatorPassengers = elevatorSim->GetElevatorPassengers();
+    elevatorPassengers = elevatorSim->GetCarLoad();
 
     std::cout << "[Update] Current waiting passengers: ";
     for (int count : waitingPassengers) std::cout << count << " ";
@@ -173,10 +178,10 @@ void ElevatorHandler::Update() {
                 std::cout << "Simulation over." << std::endl;
                 hasPrintedCompletionMessage = true;
             }
-            DrawScene();
+            PublishScene();
             return;
         } else {
-            DrawScene();
+            PublishScene();
             return;
         }
     }
@@ -189,7 +194,13 @@ void ElevatorHandler::Update() {
     }
 
     if (isPaused) {
-        DrawScene();
+        PublishScene();
+        return;
+    }
+
+    // Holding after the last step: keep the picture current without advancing
+    if (std::chrono::steady_clock::now() < holdUntil) {
+        PublishScene();
         return;
     }
 
@@ -212,14 +223,14 @@ void ElevatorHandler::Update() {
     if (!isElevatorMoving && currentFloor == targetFloor) {
         StopAndHandle();
 
-        if (!elevatorPassengers.empty() || 
+        if (!elevatorPassengers.IsEmpty() || 
             std::any_of(waitingPassengers.begin(), waitingPassengers.end(), [](int count) { return count > 0; })) {
             UpdateDirectionAndTarget();
             isElevatorMoving = true;
         } else {
             // Check if simulation is complete
             bool allRequestsHandled = currentStepIndex >= simulationSteps.size();
-            bool elevatorEmpty = elevatorPassengers.empty();
+            bool elevatorEmpty = elevatorPassengers.IsEmpty();
             bool noWaitingPassengers = std::all_of(waitingPassengers.begin(), waitingPassengers.end(), [](int count) { return count == 0; });
 
             if (allRequestsHandled && elevatorEmpty && noWaitingPassengers) {
@@ -229,13 +240,13 @@ void ElevatorHandler::Update() {
             }
         }
 
-        DrawScene();
+        PublishScene();
         return;
     }
 
-    DrawScene(); // Redraw the scene
-    
-    std::this_thread::sleep_for(std::chrono::milliseconds(5000)); // Adjust the duration to slow down the simulation
+    PublishScene(); // Redraw the scene
+
+    holdUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(5000); // Adjust the duration to slow down the simulation
 
 }
 
@@ -243,7 +254,7 @@ void ElevatorHandler::Update() {
 // Function to initialize waiting passengers from backend
 void ElevatorHandler::InitializePassengersFromBackend() {
     // Load initial passenger states from the backend once during initialization
-    elevatorPassengers = elevatorSim->GetElevatorPassengers();
+    elevatorPassengers = elevatorSim->GetCarLoad();
     waitingPassengers = elevatorSim->GetWaitingPassengers();
     std::cout << "Initialized passengers from backend." << std::endl;
 
@@ -265,23 +276,21 @@ bool ElevatorHandler::HasPrintedCompletionMessage() const {
 
 // Function to move the elevator incrementally to a target floor
 void ElevatorHandler::IncrementallyMoveElevator(int targetFloor) {
-    int targetYPos = CalculateYPosForFloor(targetFloor);
-
-    const int moveSpeed = 20; // Pixels per update cycle
+    const double moveSpeed = 0.1; // Floors per update cycle
 
-    if (elevatorYPos < targetYPos) {
-        elevatorYPos += moveSpeed;
-        if (elevatorYPos >= targetYPos) {
-            elevatorYPos = targetYPos;
+    if (elevatorFloorPos > targetFloor) {
+        elevatorFloorPos -= moveSpeed;
+        if (elevatorFloorPos <= targetFloor) {
+            elevatorFloorPos = targetFloor;
             currentFloor = targetFloor;
             isElevatorMoving = false;
             StopAndHandle();
             std::cout << "Elevator reached target floor: " << currentFloor << std::endl;
         }
-    } else if (elevatorYPos > targetYPos) {
-        elevatorYPos -= moveSpeed;
-        if (elevatorYPos <= targetYPos) {
-            elevatorYPos = targetYPos;
+    } else if (elevatorFloorPos < targetFloor) {
+        elevatorFloorPos += moveSpeed;
+        if (elevatorFloorPos >= targetFloor) {
+            elevatorFloorPos = targetFloor;
             currentFloor = targetFloor;
             isElevatorMoving = false;
             StopAndHandle();
@@ -289,82 +298,89 @@ void ElevatorHandler::IncrementallyMoveElevator(int targetFloor) {
         }
     }
 
-    DrawScene();
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    PublishScene();
+    holdUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
 }
 
-int ElevatorHandler::CalculateYPosForFloor(int floor) const {
-    // Assuming floors are indexed starting at 1 (i.e., floor 1 is at the bottom)
-    int floorHeight = 200;  // Height in pixels per floor (this can be adjusted as needed)
-    int totalBuildingHeight = floorHeight * numFloors;
-
-    // Calculate Y position
-    // Assuming Y=0 is at the top, and each floor is evenly spaced by floorHeight.
-    int yPos = totalBuildingHeight - (floor * floorHeight);
-
-    return yPos;
+// Copy what the scene shows right now into a (reused) frame
+void ElevatorHandler::FillSceneFrame(ECSceneFrame &frame) {
+    camera.SetBounds(numFloors, graphicView.GetHeight());
+    camera.Track(elevatorFloorPos);
+
+    frame.numFloors = numFloors;
+    frame.currentFloor = currentFloor;
+    frame.elevatorFloorPos = elevatorFloorPos;
+    frame.stepIndex = currentStepIndex;
+    frame.numSteps = simulationSteps.size();
+    frame.elevatorPassengers.clear();
+    for (int dest : elevatorPassengers) {
+        frame.elevatorPassengers.push_back(dest);
+    }
+    frame.waitingPassengers.assign(waitingPassengers.begin(), waitingPassengers.end());
+    frame.camera = camera;
+
+    frame.fShowHeatmap = showHeatmap;
+    frame.fShowProfilerOverlay = showProfilerOverlay;
+    if (showProfilerOverlay) {
+        frame.updateMsAvg = frameStats.GetUpdateTimes().GetAverage();
+        frame.updateMsP99 = frameStats.GetUpdateTimes().GetPercentile(0.99);
+        frame.eventMsAvg = frameStats.GetEventLatencies().GetAverage();
+        frame.eventMsP99 = frameStats.GetEventLatencies().GetPercentile(0.99);
+    }
 }
 
 // Function to move the elevator smoothly to a target floor
 void ElevatorHandler::MoveElevatorToFloor(int targetFloor) {
     std::cout << "Moving elevator to floor: " << targetFloor << std::endl;
 
-    // Calculate the level height for each floor
-    int levelHeight = graphicView.GetHeight() / numFloors;
-    int targetYPos = graphicView.GetHeight() - (targetFloor * levelHeight);
-
-    // Set up the speed for elevator movement (pixels per millisecond)
-    const double speed = 0.5;  // Adjust this value to make the movement slower or faster
+    // Set up the speed for elevator movement (floors per millisecond)
+    const double speed = 0.0025;  // Adjust this value to make the movement slower or faster
 
     // Track the time using a steady clock
     auto startTime = std::chrono::steady_clock::now();
 
     // Determine the direction of movement
-    int direction = (targetYPos > elevatorYPos) ? 1 : -1;
+    int direction = (targetFloor > elevatorFloorPos) ? 1 : -1;
 
     // Loop to move the elevator smoothly
-    while ((direction > 0 && elevatorYPos < targetYPos) || (direction < 0 && elevatorYPos > targetYPos)) {
+    while ((direction > 0 && elevatorFloorPos < targetFloor) || (direction < 0 && elevatorFloorPos > targetFloor)) {
         // Calculate elapsed time
         auto currentTime = std::chrono::steady_clock::now();
         std::chrono::duration<double, std::milli> elapsed = currentTime - startTime;
 
         // Move elevator based on elapsed time and speed
-        elevatorYPos += direction * speed * elapsed.count();
+        elevatorFloorPos += direction * speed * elapsed.count();
         startTime = currentTime;
 
         // Prevent overshooting the target position
-        if ((direction > 0 && elevatorYPos > targetYPos) || (direction < 0 && elevatorYPos < targetYPos)) {
-            elevatorYPos = targetYPos;
+        if ((direction > 0 && elevatorFloorPos > targetFloor) || (direction < 0 && elevatorFloorPos < targetFloor)) {
+            elevatorFloorPos = targetFloor;
         }
 
         // Redraw scene
-        DrawScene();
+        PublishScene();
 
         // Sleep for a short time to control the update frequency
         std::this_thread::sleep_for(std::chrono::milliseconds(16));  // ~60 frames per second
     }
 
     // Ensure elevator is at the exact position of the target floor
-    elevatorYPos = targetYPos;
+    elevatorFloorPos = targetFloor;
     currentFloor = targetFloor;  // Update current floor
     std::cout << "Elevator reached floor: " << currentFloor << std::endl;
 
     // Final draw to make sure the elevator is rendered properly in its final position
-    DrawScene();
+    PublishScene();
 }
 
 // Function to handle passengers at a floor (boarding and alighting)
 void ElevatorHandler::StopAndHandle() {
     std::cout << "Handling passengers at floor: " << currentFloor << std::endl;
 
-    // Passengers alighting
-    for (auto it = elevatorPassengers.begin(); it != elevatorPassengers.end();) {
-        if (*it == currentFloor) {
-            std::cout << "Passenger alighted at floor: " << currentFloor << std::endl;
-            it = elevatorPassengers.erase(it); // Remove passenger from elevator
-        } else {
-            ++it;
-        }
+    // Passengers alighting, all at once
+    int numAlighted = elevatorPassengers.Unload(currentFloor);
+    for (int i = 0; i < numAlighted; ++i) {
+        std::cout << "Passenger alighted at floor: " << currentFloor << std::endl;
     }
 
     // Passengers boarding
@@ -379,7 +395,7 @@ void ElevatorHandler::StopAndHandle() {
             destination = (rand() % numFloors) + 1;
         } while (destination == currentFloor);
 
-        elevatorPassengers.push_back(destination); // Add passenger to elevator
+        elevatorPassengers.Board(destination, currentFloor); // Add passenger to elevator
         std::cout << "New passenger boarded with destination: " << destination << std::endl;
     }
 
@@ -396,34 +412,27 @@ void ElevatorHandler::StopAndHandle() {
 
 
 
-// Draw the entire graphical scene
-void ElevatorHandler::DrawScene() {
+// Hand the current state to the render thread as a new scene frame
+void ElevatorHandler::PublishScene() {
+    EC_TRACE_SCOPE("ElevatorHandler::PublishScene");
+
     if (numFloors == 0) {
-        std::cerr << "DrawScene: numFloors is zero, cannot draw." << std::endl;
+        std::cerr << "PublishScene: numFloors is zero, cannot draw." << std::endl;
         return;
     }
 
-    std::cout << "Drawing entire scene. Current tick: " << currentTick << std::endl;
-
-    graphicView.DrawFilledRectangle(0, 0, graphicView.GetWidth(), graphicView.GetHeight(), ECGV_YELLOW);
+    std::cout << "Publishing scene. Current tick: " << currentTick << std::endl;
 
-    DrawElevator();
-    DrawWaitingPassengers();
-
-    if (simulationSteps.size() > 0) {
-        DrawProgressBar(currentStepIndex, simulationSteps.size());
-    }
-
-    graphicView.DrawText(500, 3, ("Time: " + std::to_string(currentStepIndex)).c_str(), ECGV_BLACK);
-    graphicView.SetRedraw(true);
+    FillSceneFrame(sceneBuffer.GetWriteBuffer());
+    sceneBuffer.Publish();
 }
 
 void ElevatorHandler::UpdateDirectionAndTarget() {
     bool foundTarget = false;
 
     // Prioritize passengers in the elevator
-    if (!elevatorPassengers.empty()) {
-        targetFloor = elevatorPassengers.front();
+    if (!elevatorPassengers.IsEmpty()) {
+        targetFloor = elevatorPassengers.GetFirstDestination();
         direction = (targetFloor > currentFloor) ? Direction::UP : Direction::DOWN;
         foundTarget = true;
     }
@@ -450,118 +459,6 @@ void ElevatorHandler::UpdateDirectionAndTarget() {
 }
 
 
-// Create the elevator with its passengers
-void ElevatorHandler::DrawElevator() {
-    std::cout << "Drawing elevator at floor: " << currentFloor << ", ElevatorYPos: " << elevatorYPos << std::endl;
-
-    int elevatorHeight = 200;
-    int elevatorWidth = graphicView.GetWidth() - 130;
-
-    graphicView.DrawFilledRectangle(30, elevatorYPos, 30 + elevatorWidth, elevatorYPos + elevatorHeight, ECGV_PURPLE);
-
-    int headSize = 25;
-    int offset = 60;
-
-    std::cout << "Number of passengers in elevator: " << elevatorPassengers.size() << std::endl;
-
-    for (size_t i = 0; i < elevatorPassengers.size(); ++i) {
-        int headX = 30 + 20 + i * offset;
-
-        if (headX + headSize > 30 + elevatorWidth) {
-            std::cout << "Not enough space to draw passenger " << i << " at headX: " << headX << std::endl;
-            break;
-        }
-
-        graphicView.DrawCircle(headX, elevatorYPos + headSize, headSize, ECGV_RED);
-        graphicView.DrawLine(headX, elevatorYPos + headSize * 2, headX, elevatorYPos + elevatorHeight - 10, ECGV_RED);
-        graphicView.DrawText(headX - 5, elevatorYPos + headSize - 10, std::to_string(elevatorPassengers[i]).c_str(), ECGV_BLACK);
-
-        std::cout << "Drawing passenger " << i << " in elevator with destination floor: " << elevatorPassengers[i]
-                  << ", Position: (" << headX << ", " << (elevatorYPos + headSize) << ")" << std::endl;
-    }
-
-    graphicView.SetRedraw(true);
-}
-
-// Draw waiting passengers on each floor
-void ElevatorHandler::DrawWaitingPassengers() {
-    if (numFloors == 0) {
-        std::cerr << "[DrawWaitingPassengers] Error: numFloors is zero!" << std::endl;
-        return;
-    }
-
-    std::cout << "[DrawWaitingPassengers] Drawing passengers on all floors." << std::endl;
-
-    int levelHeight = graphicView.GetHeight() / numFloors;
-
-    for (int i = 0; i < numFloors; ++i) {
-        int levelY = graphicView.GetHeight() - (i + 1) * levelHeight;
-
-        // Draw the floor line
-        graphicView.DrawLine(0, levelY, graphicView.GetWidth(), levelY, ECGV_BLACK);
-
-        // Check if there are passengers waiting on this floor
-        if (waitingPassengers[i] > 0) {
-            int passengerX = graphicView.GetWidth() - (40 * waitingPassengers[i]);
-            int passengerY = levelY + levelHeight / 2 - 20;
-
-            // Divide passengers into "up" and "down" groups
-            int upCount = waitingPassengers[i] / 2; // Half go up
-            int downCount = waitingPassengers[i] - upCount; // Remaining go down
-
-            int passengerIndex = 0;
-            for (int j = 0; j < waitingPassengers[i]; ++j) {
-                int offset = passengerIndex * 40;
-
-                // Draw passenger circle and body
-                graphicView.DrawCircle(passengerX + offset, passengerY, 15, ECGV_BLACK);
-                graphicView.DrawLine(passengerX + offset, passengerY + 15, 
-                                     passengerX + offset, passengerY + 45, ECGV_BLACK);
-
-                // Draw direction indicator
-                if (j < upCount) {
-                    // Draw upward arrow for passengers going up
-                    graphicView.DrawTriangle(passengerX + offset, passengerY - 20, 
-                                             passengerX + offset - 10, passengerY - 10, 
-                                             passengerX + offset + 10, passengerY - 10, ECGV_BLACK);
-                } else {
-                    // Draw downward arrow for passengers going down
-                    graphicView.DrawTriangle(passengerX + offset, passengerY + 50, 
-                                             passengerX + offset - 10, passengerY + 40, 
-                                             passengerX + offset + 10, passengerY + 40, ECGV_BLACK);
-                }
-
-                std::cout << "[DrawWaitingPassengers] Passenger " << (j + 1) 
-                          << " at Floor " << (i + 1) 
-                          << " drawn at (" << (passengerX + offset) << ", " << passengerY << ")."
-                          << (j < upCount ? " (Up)" : " (Down)") << std::endl;
-
-                ++passengerIndex;
-            }
-        }
-    }
-}
-
-// Draw progress bar for simulation time
-void ElevatorHandler::DrawProgressBar(int currentTime, int maxTime) {
-    if (maxTime == 0) {
-        std::cerr << "Error: maxTime is zero. Cannot draw progress bar." << std::endl;
-        return;
-    }
-
-    int barWidth = graphicView.GetWidth() - 20;
-
-    // Adjust filledWidth calculation to make the progress bar movement smoother
-    double progressRatio = static_cast<double>(currentTime) / maxTime;
-    int filledWidth = static_cast<int>(barWidth * progressRatio);
-
-    // Draw the filled portion of the progress bar
-    graphicView.DrawFilledRectangle(10, 40, 10 + filledWidth, 60, ECGV_BLUE);
-
-    // Draw the border for the progress bar
-    graphicView.DrawRectangle(10, 40, 10 + barWidth, 60, 2, ECGV_BLACK);
-}
-
 // Getter for the current time tick
 int ElevatorHandler::GetCurrentTime() const {
     return currentTick;
@@ -587,6 +484,27 @@ void ElevatorHandler::TogglePause() {
     isPaused = !isPaused;
 }
 
+// Handle a key event forwarded from the view
+void ElevatorHandler::HandleViewEvent(ECGVEventType event) {
+    if (event == ECGV_EV_KEY_DOWN_P) {
+        showProfilerOverlay = !showProfilerOverlay;
+    } else if (event == ECGV_EV_KEY_DOWN_H) {
+        showHeatmap = !showHeatmap;
+    } else if (event == ECGV_EV_KEY_DOWN_UP) {
+        camera.Scroll(1.0);
+    } else if (event == ECGV_EV_KEY_DOWN_DOWN) {
+        camera.Scroll(-1.0);
+    } else if (event == ECGV_EV_KEY_DOWN_RIGHT) {
+        camera.Zoom(1.25);
+    } else if (event == ECGV_EV_KEY_DOWN_LEFT) {
+        camera.Zoom(0.8);
+    } else if (event == ECGV_EV_KEY_DOWN_F) {
+        camera.ToggleFollow();
+    } else if (event == ECGV_EV_KEY_DOWN_HOME) {
+        camera.Fit();
+    }
+}
+
 bool ElevatorHandler::ShouldStopAtCurrentFloor() const {
     return elevatorSim->IsSimulationComplete();
 }
\ No newline at end of file
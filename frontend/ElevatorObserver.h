@@ -4,10 +4,15 @@
 #include "ECObserver.h"
 #include "ECGraphicViewImp.h"
 #include "ECElevatorSim1.h"
+#include "ECFrameStats.h"
+#include "ECSceneRenderer.h"
+#include "ECTripleBuffer.h"
 #include <vector>
 #include <memory>
 #include <queue>
 #include <string>
+#include <unordered_map>
+#include <chrono>
 
 // Enum to represent elevator direction
 enum Direction {
@@ -24,8 +29,7 @@ public:
 
 
     void MoveElevatorToFloor(int targetFloor);  // Move elevator to a target floor
-    void DrawScene();  // Draw the scene
-    void DrawProgressBar(int currentTime, int maxTime);  // Function to draw a progress bar indicating the current time
+    void PublishScene();  // Hand the scene to the render thread
     bool IsSimulationComplete() const;  // Getter to check if the simulation is complete
     bool HasPrintedCompletionMessage() const;  // Getter to check if the completion message has been printed
     void InitializePassengersFromBackend();
@@ -36,6 +40,9 @@ public:
     int GetMaxTime() const;  // Get the maximum simulation time
     int GetTargetFloor() const;  // Get the current target floor
     void TogglePause();  // Toggle the simulation pause state
+    void HandleViewEvent(ECGVEventType event);  // Keys handled by the view (P overlay, arrows/F/HOME camera)
+    ECFrameStats &GetFrameStats() { return frameStats; }  // Update and event timings fed by the main loop for the overlay
+    ECTripleBuffer<ECSceneFrame> &GetSceneBuffer() { return sceneBuffer; }  // Frames for the render thread
     void HandlePassengers();  // Handle passengers when the elevator reaches a floor
     void UpdateDirectionAndTarget();
 
@@ -52,8 +59,7 @@ private:
     void UpdateDisappearingPassengers();
 
 
-    void DrawElevator();  // Function to draw the elevator and passengers inside it
-    void DrawWaitingPassengers();  // Function to draw waiting passengers at each floor
+    void FillSceneFrame(ECSceneFrame &frame);  // Copy of the state the scene is drawn from
     void ProcessPassengers();  // Handles passengers boarding or leaving the elevator
     bool ShouldStopAtCurrentFloor() const;  // Determines whether the elevator should stop at a floor
     void StopAndHandle();  // Stops the elevator to manage passengers boarding or leaving
@@ -79,24 +85,29 @@ private:
 
     int currentFloor;  // Tracks the current floor of the elevator
     int targetFloor;  // The target floor the elevator is currently moving to
-    int elevatorYPos;  // Current y-coordinate of the elevator for smooth movement
+    double elevatorFloorPos;  // Car position in floors, fractional while moving
     int numFloors;  // Total number of floors in the building
     int totalTicks;  // Total number of time ticks from input file
     int currentTick;  // Current time tick for progress bar 
     int moveEndTime;  // The target time when the elevator must reach its destination
     int ticksPerFloor;  // Number of ticks required to move between floors
     int currentStepIndex;  // Keeps track of the current simulation step index
-    int CalculateYPosForFloor(int floor) const;  // Calculates Y position for a given floor
     int CalculateMoveDuration(int startFloor, int targetFloor) const;  // Calculates the duration in ticks to move between floors
 
     double moveSpeed;  // Pixels per tick to ensure timely arrival at the target
 
     bool isElevatorMoving;  // Tracks whether the elevator is currently moving
+    bool showProfilerOverlay;  // Draw the profiler overlay on top of the scene
+    bool showHeatmap;          // Draw the demand heatmap from the rollups
+    ECFrameStats frameStats;  // Update thread timings shown by the overlay
+    ECViewCamera camera;  // Scroll, zoom and follow-car state
+    ECTripleBuffer<ECSceneFrame> sceneBuffer;  // Scene frames handed to the render thread
+    std::chrono::steady_clock::time_point holdUntil;  // Update does not advance the animation before this
     bool stopNext;  // Indicates if elevator should stop at the next floor
 
     std::queue<int> floorQueue;  // Queue to track floor requests
     std::vector<int> waitingPassengers;  // Tracks passengers waiting at each floor
-    std::vector<int> elevatorPassengers;  // Tracks passengers inside the elevator and their target floors
+    ECCarLoad elevatorPassengers;  // Tracks passengers inside the elevator and their target floors
     std::vector<int> waitingDirections;  // Direction of waiting passengers (-1 for down, 1 for up)
     std::vector<std::string> simulationSteps;  // Stores all the simulation steps loaded from the output file
 };
@@ -1,18 +1,27 @@
 #include "ECElevatorSim1.h"
+#include "ECLiveRequestSource.h"
+#include "ECSimProfiler.h"
+#include "ECTraceEvents.h"
 #include "ECGraphicViewImp.h"
 #include "ElevatorObserver.h"
+#include "ECFrameExporter.h"
+#include "ECRenderThread.h"
+#include "ECTelemetry.h"
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <memory>
+#include <cstdlib>
+#include <climits>
+#include <csignal>
 #include <allegro5/allegro.h>
-#include <allegro5/allegro_primitives.h>
-#include <allegro5/allegro_font.h>
-#include <allegro5/allegro_ttf.h>
+#include <thread>
+#include <chrono>
 
 // Function to read requests from input file
 std::vector<ECElevatorSimRequest> ReadRequestsFromFile(const std::string &filename) {
+    EC_TRACE_SCOPE("ReadRequestsFromFile");
     std::vector<ECElevatorSimRequest> requests;
     std::ifstream inFile(filename);
     if (!inFile.is_open()) {
@@ -40,71 +49,216 @@ std::vector<ECElevatorSimRequest> ReadRequestsFromFile(const std::string &filena
     return requests;
 }
 
+// Set by SIGINT/SIGTERM during a live run; the backend finishes the tick and writes its output
+static volatile std::sig_atomic_t fStopRequested = 0;
+
+static void RequestStop(int) {
+    fStopRequested = 1;
+}
+
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file>" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> [--floors 5] [--duration 50]"
+                  << " [--live <fifo_or_socket>] [--tick-ms <n>] [--queue <n>] [--block]"
+                  << " [--export-frames <dir>] [--export-threads <n>] [--telemetry <shm_name>]"
+                  << " [--checkpoint-every <ticks>] [--resume]" << std::endl;
         return 1;
     }
 
+    std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
     std::string inputFilename = argv[1];
     std::string outputFilename = argv[2];
+    EC_TRACE_THREAD_NAME("main");
+    int numFloors = 5;
+    int duration = 0;   // 0: 50 ticks, or in live mode until the feed ends
 
-    // Initialize Allegro
-    if (!al_init()) {
-        std::cerr << "Failed to initialize Allegro." << std::endl;
-        return -1;
-    }
-    al_init_primitives_addon();
-    al_init_font_addon();
-    al_init_ttf_addon();
-    al_install_keyboard();
+    // Optional live input: hall calls streamed in while the backend runs
+    std::string livePath;
+    int liveTickMillis = 1000;
+    int liveQueueCapacity = 4096;
+    EC_LIVE_OVERLOAD_POLICY livePolicy = EC_LIVE_DROP_NEWEST;
+
+    // Optional offline export: write every step as a PNG instead of playing it back
+    std::string exportDir;
+    int exportThreads = std::thread::hardware_concurrency();
 
-    // Create Allegro display
-    ALLEGRO_DISPLAY *display = al_create_display(1000, 1000);
-    if (!display) {
-        std::cerr << "Failed to create display." << std::endl;
-        return -1;
+    // Optional shared-memory telemetry for dashboards, e.g. "/elevator_sim"
+    std::string telemetryName;
+
+    // Optional crash safety: checkpoints to <output_file>.ckpt, and resuming from the latest one
+    int checkpointEveryTicks = 0;
+    bool fResume = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--floors" && i + 1 < argc) {
+            numFloors = atoi(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = atoi(argv[++i]);
+        } else if (arg == "--live" && i + 1 < argc) {
+            livePath = argv[++i];
+        } else if (arg == "--tick-ms" && i + 1 < argc) {
+            liveTickMillis = atoi(argv[++i]);
+        } else if (arg == "--queue" && i + 1 < argc) {
+            liveQueueCapacity = atoi(argv[++i]);
+        } else if (arg == "--block") {
+            livePolicy = EC_LIVE_BLOCK;
+        } else if (arg == "--export-frames" && i + 1 < argc) {
+            exportDir = argv[++i];
+        } else if (arg == "--export-threads" && i + 1 < argc) {
+            exportThreads = atoi(argv[++i]);
+        } else if (arg == "--telemetry" && i + 1 < argc) {
+            telemetryName = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            checkpointEveryTicks = atoi(argv[++i]);
+        } else if (arg == "--resume") {
+            fResume = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
     }
 
-    // Create Allegro timer for frame updates (10 FPS)
-    ALLEGRO_TIMER *frame_timer = al_create_timer(1.0 / 10.0);
-    ALLEGRO_EVENT_QUEUE *event_queue = al_create_event_queue();
-    al_register_event_source(event_queue, al_get_timer_event_source(frame_timer));
-    al_register_event_source(event_queue, al_get_display_event_source(display));
-    al_register_event_source(event_queue, al_get_keyboard_event_source());
+    if (numFloors < 1) {
+        std::cerr << "Error: --floors must be positive" << std::endl;
+        return 1;
+    }
+    if (duration <= 0) {
+        duration = livePath.empty() ? 50 : INT_MAX;
+    }
 
     // Run the backend to generate the simulation output file
     std::vector<ECElevatorSimRequest> requests = ReadRequestsFromFile(inputFilename);
-    ECElevatorSim elevatorSim(5, requests);
-    elevatorSim.Simulate(50, outputFilename);  // Corrected to use `outputFilename`
+    for (const ECElevatorSimRequest &request : requests) {
+        int floors[2] = { request.GetFloorSrc(), request.GetFloorDest() };
+        for (int floor : floors) {
+            if (floor < 1 || floor > numFloors) {
+                std::cerr << "Error: the request at time " << request.GetTime() << " names floor " << floor
+                          << ", outside 1.." << numFloors << " (set --floors)" << std::endl;
+                return 1;
+            }
+        }
+    }
+    ECElevatorSim elevatorSim(numFloors, requests);
+    elevatorSim.SetVerbose(true);
+    elevatorSim.EnableRollups();   // written to <output_file>.rollup
+    if (fResume) {
+        if (!elevatorSim.ResumeFromCheckpoint(outputFilename + ".ckpt")) {
+            return 1;
+        }
+        std::cout << "Resuming from " << outputFilename << ".ckpt at Time Step: " << elevatorSim.GetCurrentTime() << std::endl;
+    }
+    if (checkpointEveryTicks > 0) {
+        elevatorSim.EnableCheckpoints(outputFilename + ".ckpt", checkpointEveryTicks);
+    }
+
+    ECLiveRequestSource liveSource(livePath, liveQueueCapacity, livePolicy);
+    if (!livePath.empty()) {
+        if (!liveSource.Open()) {
+            return 1;
+        }
+        elevatorSim.AttachLiveSource(&liveSource, liveTickMillis);
+        std::cout << "Live input on " << livePath << ", one tick every " << liveTickMillis << " ms" << std::endl;
+
+        // Run until the feed ends, --duration ticks pass, or we are told to stop
+        signal(SIGINT, RequestStop);
+        signal(SIGTERM, RequestStop);
+        elevatorSim.SetStopFlag(&fStopRequested);
+    }
 
-    // Create the graphical view
+    ECTelemetryWriter telemetry(telemetryName);
+    if (!telemetryName.empty()) {
+        if (!telemetry.Open()) {
+            return 1;
+        }
+        elevatorSim.AttachTelemetry(&telemetry);
+        std::cout << "Publishing telemetry to shared memory " << telemetryName << std::endl;
+    }
+
+    elevatorSim.Simulate(duration, outputFilename);
+    if (elevatorSim.IsLive()) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        elevatorSim.SetStopFlag(NULL);
+    }
+
+#ifdef EC_SIM_PROFILE
+    // Per-phase timings and counters of the backend run
+    std::ofstream profileFile(outputFilename + ".profile.json");
+    ECSimProfiler::WriteJSON(profileFile);
+    std::cout << "Profile written to " << outputFilename << ".profile.json" << std::endl;
+#endif
+
+    if (elevatorSim.IsLive()) {
+        const ECLiveSourceStats &stats = liveSource.GetStats();
+        std::cout << "Live input: received " << stats.received << ", dropped " << stats.dropped
+                  << ", rejected " << stats.rejected << ", lagged " << stats.lagged
+                  << " (max " << stats.maxLagTicks << " ticks), queue high water "
+                  << stats.queueHighWater << "/" << liveSource.GetCapacity() << std::endl;
+        elevatorSim.AttachLiveSource(NULL, 0);
+        liveSource.Close();
+    }
+
+    if (!exportDir.empty()) {
+        // Headless: memory bitmaps only, no display
+        if (!ECGraphicViewImp::InitAllegro()) {
+            return -1;
+        }
+
+        ECFrameExporter exporter(1000, 1000);
+        if (!exporter.LoadTrace(outputFilename)) {
+            return 1;
+        }
+        double exportStart = al_get_time();
+        int numWritten = exporter.Export(exportDir, exportThreads);
+        std::cout << "Exported " << numWritten << " of " << exporter.GetNumFrames() << " frames to " << exportDir
+                  << " in " << (al_get_time() - exportStart) << " s" << std::endl;
+#ifdef EC_SIM_TRACE
+        ECTraceEvents::WriteChromeJSON(outputFilename + ".trace.json");
+#endif
+        return numWritten == exporter.GetNumFrames() ? 0 : 1;
+    }
+
+    // Create the graphical view; it initializes Allegro and owns the display, timer and event queue
+    double viewCreatedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
     ECGraphicViewImp graphicView(1000, 1000);
+    ALLEGRO_EVENT_QUEUE *event_queue = graphicView.GetEventQueue();
+    ALLEGRO_TIMER *frame_timer = graphicView.GetTimer();
+    al_set_timer_speed(frame_timer, 1.0 / 10.0);   // frame updates at 10 FPS
 
     // Create the ElevatorHandler with the output file to visualize the states
     std::cout << "Initializing ElevatorHandler..." << std::endl;
-    ElevatorHandler elevatorHandler(graphicView, std::make_shared<ECElevatorSim>(elevatorSim), outputFilename); // Corrected to use `outputFilename`
+    ElevatorHandler elevatorHandler(graphicView, elevatorSim.Fork(), outputFilename); // Corrected to use `outputFilename`
     std::cout << "ElevatorHandler initialized." << std::endl;
 
     // Attach the ElevatorHandler as an observer to the graphic view
     graphicView.Attach(&elevatorHandler);
 
-    // Start the timer and event loop
-    al_start_timer(frame_timer);
+    // Drawing happens on its own thread; this one handles input and updates
+    elevatorHandler.PublishScene();
+    ECRenderThread renderThread(graphicView, elevatorHandler.GetSceneBuffer());
+    ECTimeRollup demandRollup;
+    if (demandRollup.Load(outputFilename + ".rollup")) {
+        renderThread.SetRollup(&demandRollup);
+    }
+    renderThread.Start();
 
-    bool redraw = true;
     bool running = true;
+    ECFrameStats &frameStats = elevatorHandler.GetFrameStats();
 
     while (running && !elevatorHandler.IsSimulationComplete()) {
         ALLEGRO_EVENT ev;
-        al_wait_for_event(event_queue, &ev);
+        {
+            EC_TRACE_SCOPE("al_wait_for_event");
+            al_wait_for_event(event_queue, &ev);
+        }
+        frameStats.GetEventLatencies().Add((al_get_time() - ev.any.timestamp) * 1000.0);
 
         if (ev.type == ALLEGRO_EVENT_TIMER) {
             if (ev.timer.source == frame_timer) {
-                redraw = true;
-
                 // ElevatorHandler handles its updates internally
+                double updateStart = al_get_time();
                 elevatorHandler.Update();
+                frameStats.GetUpdateTimes().Add((al_get_time() - updateStart) * 1000.0);
 
                 // Check if the simulation is complete
                 if (elevatorHandler.IsSimulationComplete()) {
@@ -118,16 +272,22 @@ int main(int argc, char **argv) {
                 elevatorHandler.TogglePause();
             } else if (ev.keyboard.keycode == ALLEGRO_KEY_ESCAPE) {
                 running = false;
+            } else {
+                elevatorHandler.HandleViewEvent(ECGraphicViewImp::TranslateEvent(ev));
+                elevatorHandler.PublishScene();  // show camera and overlay changes without waiting for a tick
             }
         }
+    }
+    renderThread.Stop();
 
-        if (redraw && al_is_event_queue_empty(event_queue)) {
-            redraw = false;
-
-            // Draw scene
-            elevatorHandler.DrawScene();
-            al_flip_display();
+    // Startup cost: launch (including the backend run) and view creation to the first frame on screen
+    if (graphicView.GetTimeToFirstFrame() >= 0) {
+        std::cout << "Time to first frame: " << graphicView.GetTimeToFirstFrame() << " ms after creating the view, "
+                  << (viewCreatedMs + graphicView.GetTimeToFirstFrame()) << " ms after launch";
+        if (graphicView.GetTimeToFontReady() >= 0) {
+            std::cout << " (font ready at " << graphicView.GetTimeToFontReady() << " ms)";
         }
+        std::cout << std::endl;
     }
 
     // Print the final simulation message if not already done
@@ -135,10 +295,13 @@ int main(int argc, char **argv) {
         std::cout << "Simulation over." << std::endl;
     }
 
-    // Clean up
-    al_destroy_timer(frame_timer);
-    al_destroy_event_queue(event_queue);
-    al_destroy_display(display);
+#ifdef EC_SIM_TRACE
+    // Timeline of the whole run, for Perfetto or chrome://tracing
+    if (ECTraceEvents::WriteChromeJSON(outputFilename + ".trace.json")) {
+        std::cout << "Trace written to " << outputFilename << ".trace.json" << std::endl;
+    }
+#endif
 
+    // The view destroys the display, timer and event queue
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#!/bin/bash
+#
+#  run_checks.sh
+#
+#  Builds the checking tools from this tree and runs them on the request files
+#  in tests/, printing PASS or FAIL for each and exiting with status 1 if any
+#  fails. Needs only g++; the graphical front end is not built.
+#
+#    tests/run_checks.sh [request_file...]
+#
+
+cd "$(dirname "$0")/.." || exit 2
+BIN=$(mktemp -d)
+trap 'rm -rf "$BIN"' EXIT
+
+if [ $# -gt 0 ]; then
+    FILES=("$@")
+else
+    FILES=(tests/test-file-*)
+fi
+
+ENGINE="backend/ECElevatorSim1.cpp backend/ECLiveRequestSource.cpp backend/ECWaitHistogram.cpp backend/ECTelemetry.cpp backend/ECTimeRollup.cpp backend/ECCheckpoint.cpp backend/ECStateDigest.cpp backend/ECTripTable.cpp backend/ECDemandForecast.cpp"
+CXX="g++ -std=c++11 -O2 -Ibackend -pthread"
+SIMD=""
+if echo 'int main() { return 0; }' | g++ -mavx2 -x c++ - -o "$BIN/avx2" 2>/dev/null && "$BIN/avx2"; then
+    SIMD="-mavx2"
+fi
+
+NUM_FAILED=0
+Check() {
+    local name="$1"
+    shift
+    if "$@" > "$BIN/log" 2>&1; then
+        echo "PASS $name"
+    else
+        echo "FAIL $name"
+        sed 's/^/     /' "$BIN/log"
+        NUM_FAILED=$((NUM_FAILED + 1))
+    fi
+}
+
+Build() {
+    local name="$1"
+    shift
+    if ! $CXX "$@" -o "$BIN/$name" 2> "$BIN/build.log"; then
+        echo "FAIL build $name"
+        cat "$BIN/build.log"
+        exit 1
+    fi
+}
+
+Build alloc_profile tools/ECAllocProfile.cpp $ENGINE
+Build headless_sim tools/ECHeadlessSim.cpp backend/ECFixedElevatorSim.cpp $ENGINE
+Build digest_diff tools/ECDigestDiff.cpp backend/ECFixedElevatorSim.cpp backend/ECBatchElevatorSim.cpp $ENGINE
+Build batch_bench $SIMD tools/ECBatchBench.cpp backend/ECBatchElevatorSim.cpp $ENGINE
+Build call_cost_bench $SIMD tools/ECCallCostBench.cpp backend/ECCallCostKernel.cpp
+Build self_test tools/ECSelfTest.cpp backend/ECBatchElevatorSim.cpp backend/ECGroupElevatorSim.cpp backend/ECGroupController.cpp $ENGINE
+
+# The fixed-size and runtime engines must agree tick for tick
+SameDigests() {
+    local file="$1" floors="$2"
+    "$BIN/headless_sim" "$file" "$BIN/fixed.txt" --floors "$floors" --duration 200 --digest "$BIN/fixed.digest" &&
+    "$BIN/headless_sim" "$file" "$BIN/runtime.txt" --floors "$floors" --duration 200 --engine runtime --digest "$BIN/runtime.digest" &&
+    "$BIN/digest_diff" "$BIN/fixed.digest" "$BIN/runtime.digest" --input "$file"
+}
+
+for file in "${FILES[@]}"; do
+    Check "alloc_profile $file" "$BIN/alloc_profile" "$file" --ticks 20000
+    for floors in 5 10; do
+        Check "fixed and runtime engines, $floors floors, $file" SameDigests "$file" "$floors"
+    done
+done
+Check "batch_bench" "$BIN/batch_bench" --buildings 64 --ticks 500
+Check "call_cost_bench" "$BIN/call_cost_bench" --calls 256 --reps 1
+Check "self_test" "$BIN/self_test" "${FILES[@]}"
+
+if [ $NUM_FAILED -ne 0 ]; then
+    echo "$NUM_FAILED check(s) failed"
+    exit 1
+fi
+echo "All checks passed"
@@ -0,0 +1,163 @@
+//
+//  ECAllocProfile.cpp
+//
+//  Counts heap allocations made by the simulator, per run phase (setup,
+//  warm-up, steady state), through an instrumented global operator new.
+//  Exits with status 1 if any steady-state tick allocates, so it can gate
+//  changes to the tick path. Also reports the peak resident set size.
+//
+//  Without an input file a repeating synthetic workload is generated, so the
+//  run is long enough to have a real steady state.
+//
+
+#include "ECElevatorSim1.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <sys/resource.h>
+
+//*****************************************************************************
+// Instrumented global allocator
+
+static std::atomic<long long> numAllocations(0);
+static std::atomic<long long> numBytes(0);
+
+void *operator new(std::size_t size) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    numBytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    free(p);
+}
+
+//*****************************************************************************
+// Allocation counts between two points of the run
+
+struct ECAllocPhase
+{
+    ECAllocPhase() : allocationsStart(numAllocations.load()), bytesStart(numBytes.load()) {}
+
+    long long GetAllocations() const { return numAllocations.load() - allocationsStart; }
+    long long GetBytes() const { return numBytes.load() - bytesStart; }
+
+    long long allocationsStart;
+    long long bytesStart;
+};
+
+static void ReportPhase(const char *name, const ECAllocPhase &phase, int ticks) {
+    std::cout << name << ": " << phase.GetAllocations() << " allocations, " << phase.GetBytes() << " bytes";
+    if (ticks > 0) {
+        std::cout << " over " << ticks << " ticks (" << static_cast<double>(phase.GetAllocations()) / ticks << " per tick)";
+    }
+    std::cout << std::endl;
+}
+
+static std::vector<ECElevatorSimRequest> ReadRequests(const std::string &filename) {
+    std::vector<ECElevatorSimRequest> requests;
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(2);
+    }
+    std::string line;
+    int time, floorSrc, floorDest;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        if (iss >> time >> floorSrc >> floorDest) {
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return requests;
+}
+
+// Same calls every `period` ticks, so the peak load is reached during warm-up
+static std::vector<ECElevatorSimRequest> MakeRepeatingWorkload(int numFloors, int numTicks) {
+    std::vector<ECElevatorSimRequest> requests;
+    const int period = 4 * numFloors;
+    for (int t = 0; t < numTicks; ++t) {
+        int k = t % period;
+        int floorSrc = (k * 7) % numFloors + 1;
+        int floorDest = (k * 3 + 1) % numFloors + 1;
+        if (floorDest == floorSrc) {
+            floorDest = floorSrc % numFloors + 1;
+        }
+        requests.emplace_back(t, floorSrc, floorDest);
+    }
+    return requests;
+}
+
+int main(int argc, char **argv) {
+    std::string inputFilename;
+    int numFloors = 10;
+    int numTicks = 100000;
+    int warmupTicks = 1000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--floors" && i + 1 < argc) {
+            numFloors = atoi(argv[++i]);
+        } else if (arg == "--ticks" && i + 1 < argc) {
+            numTicks = atoi(argv[++i]);
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmupTicks = atoi(argv[++i]);
+        } else if (arg[0] != '-' && inputFilename.empty()) {
+            inputFilename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [input_file] [--floors <n>] [--ticks <n>] [--warmup <n>]" << std::endl;
+            return 2;
+        }
+    }
+
+    ECAllocPhase setup;
+    std::vector<ECElevatorSimRequest> requests = inputFilename.empty() ?
+        MakeRepeatingWorkload(numFloors, numTicks) : ReadRequests(inputFilename);
+    ECElevatorSim sim(numFloors, requests);
+    ReportPhase("setup", setup, 0);
+
+    ECAllocPhase warmup;
+    ECElevatorStepResult warmupResult = sim.StepN(warmupTicks);
+    ReportPhase("warm-up", warmup, warmupResult.ticksRun);
+
+    ECAllocPhase steady;
+    ECElevatorStepResult steadyResult = sim.RunUntil(numTicks);
+    long long steadyAllocations = steady.GetAllocations();
+    ReportPhase("steady", steady, steadyResult.ticksRun);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "peak resident set: " << usage.ru_maxrss << " KB" << std::endl;
+
+    if (steadyAllocations > 0) {
+        std::cout << "FAIL: the steady-state tick allocates" << std::endl;
+        return 1;
+    }
+    std::cout << "OK: no steady-state allocations" << std::endl;
+    return 0;
+}
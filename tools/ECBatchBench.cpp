@@ -0,0 +1,138 @@
+//
+//  ECBatchBench.cpp
+//
+//  Simulates a portfolio of small single-car buildings twice: one scalar
+//  ECElevatorSim per building, then with ECBatchElevatorSim using every kernel
+//  compiled in. Checks that each building ends up exactly the same and reports
+//  building-ticks per second. Exits with status 1 on any mismatch.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECBatchElevatorSim.h"
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+// Small deterministic generator, so runs are repeatable
+static unsigned int NextRandom(unsigned long long &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<unsigned int>(state >> 33);
+}
+
+static std::vector<ECElevatorSimRequest> MakeRequests(int numFloors, int numRequests, int spanTicks, unsigned long long &state) {
+    std::vector<ECElevatorSimRequest> requests;
+    for (int i = 0; i < numRequests; ++i) {
+        int time = NextRandom(state) % spanTicks;
+        int src = 1 + NextRandom(state) % numFloors;
+        int dest = 1 + NextRandom(state) % (numFloors - 1);
+        if (dest >= src) {
+            dest++;
+        }
+        requests.push_back(ECElevatorSimRequest(time, src, dest));
+    }
+    return requests;
+}
+
+static bool SameResult(const ECBatchBuildingResult &lhs, const ECBatchBuildingResult &rhs) {
+    return lhs.timeNow == rhs.timeNow && lhs.currentFloor == rhs.currentFloor && lhs.direction == rhs.direction &&
+           lhs.numRiders == rhs.numRiders && lhs.requests == rhs.requests && lhs.boardings == rhs.boardings &&
+           lhs.alightings == rhs.alightings && lhs.moves == rhs.moves && lhs.waitTicksSum == rhs.waitTicksSum &&
+           lhs.fComplete == rhs.fComplete;
+}
+
+int main(int argc, char **argv) {
+    int numBuildings = 4096;
+    int numFloors = 10;
+    int numTicks = 2000;
+    int requestsPerBuilding = 400;
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--buildings" && i + 1 < argc) {
+            numBuildings = atoi(argv[++i]);
+        } else if (arg == "--floors" && i + 1 < argc) {
+            numFloors = atoi(argv[++i]);
+        } else if (arg == "--ticks" && i + 1 < argc) {
+            numTicks = atoi(argv[++i]);
+        } else if (arg == "--requests" && i + 1 < argc) {
+            requestsPerBuilding = atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--buildings 4096] [--floors 10] [--ticks 2000] [--requests 400] [--seed 1]" << std::endl;
+            return 1;
+        }
+    }
+    if (numFloors < 2 || numFloors > ECBatchElevatorSim::MAX_FLOORS) {
+        std::cerr << "Error: --floors must be 2.." << ECBatchElevatorSim::MAX_FLOORS << std::endl;
+        return 1;
+    }
+
+    std::vector<std::shared_ptr<const std::vector<ECElevatorSimRequest> > > schedules;
+    for (int i = 0; i < numBuildings; ++i) {
+        std::vector<ECElevatorSimRequest> requests = MakeRequests(numFloors, requestsPerBuilding, numTicks, seed);
+        ECElevatorSim sim(numFloors, requests);   // sorts them the way the engine does
+        schedules.push_back(sim.GetSharedRequestSchedule());
+    }
+
+    // Reference: one scalar simulator per building
+    std::vector<ECBatchBuildingResult> expected(numBuildings);
+    long long scalarTicks = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numBuildings; ++i) {
+        ECElevatorSim sim(numFloors, schedules[i]);
+        ECElevatorStepResult step = sim.StepN(numTicks);
+        ECBatchBuildingResult &result = expected[i];
+        result.timeNow = step.timeNow;
+        result.currentFloor = sim.GetCurrentFloor();
+        result.direction = sim.IsGoingUp() ? EC_ELEVATOR_UP : (sim.IsGoingDown() ? EC_ELEVATOR_DOWN : EC_ELEVATOR_STOPPED);
+        result.numRiders = sim.GetNumberOfRiders();
+        result.requests = sim.GetTotalRequests();
+        result.boardings = sim.GetTotalBoardings();
+        result.alightings = sim.GetTotalAlightings();
+        result.moves = sim.GetTotalMoves();
+        result.waitTicksSum = sim.GetWaitTimes().GetSum();
+        result.fComplete = step.fComplete;
+        scalarTicks += step.ticksRun;
+    }
+    double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "ECElevatorSim      " << scalarTicks / scalarSeconds / 1e6 << " M building-ticks/s" << std::endl;
+
+    bool fAllMatch = true;
+    EC_BATCH_KERNEL kernels[] = { EC_BATCH_KERNEL_SCALAR, EC_BATCH_KERNEL_AVX2, EC_BATCH_KERNEL_AVX512 };
+    for (int k = 0; k < 3; ++k) {
+        if (!ECBatchElevatorSim::IsKernelAvailable(kernels[k])) {
+            continue;
+        }
+        ECBatchElevatorSim batch(numFloors);
+        batch.SetKernel(kernels[k]);
+        for (int i = 0; i < numBuildings; ++i) {
+            if (batch.AddBuilding(schedules[i]) < 0) {
+                std::cerr << "Error: building " << i << " has a request outside 1.." << numFloors << std::endl;
+                return 1;
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        batch.StepN(numTicks);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int numMismatched = 0;
+        for (int i = 0; i < numBuildings; ++i) {
+            if (!SameResult(batch.GetResult(i), expected[i])) {
+                if (numMismatched == 0) {
+                    std::cerr << "Building " << i << " differs from ECElevatorSim" << std::endl;
+                }
+                numMismatched++;
+            }
+        }
+        fAllMatch = fAllMatch && numMismatched == 0 && batch.GetBuildingTicks() == scalarTicks;
+
+        std::cout << "batch " << ECBatchElevatorSim::GetKernelName(kernels[k]) << std::string(13 - std::string(ECBatchElevatorSim::GetKernelName(kernels[k])).size(), ' ')
+                  << batch.GetBuildingTicks() / seconds / 1e6 << " M building-ticks/s ("
+                  << scalarSeconds / seconds << "x), " << numMismatched << " buildings differ" << std::endl;
+    }
+    return fAllMatch ? 0 : 1;
+}
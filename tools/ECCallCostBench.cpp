@@ -0,0 +1,132 @@
+//
+//  ECCallCostBench.cpp
+//
+//  Scores batches of random hall calls against banks of 4, 16 and 64 cars
+//  (or --cars) with every ECCallCostKernel kernel compiled in. Checks that
+//  each kernel gives exactly the scalar kernel's costs and best cars, and
+//  reports call-car pairs scored per second, with the full cost matrix and
+//  with the best car only. Exits with status 1 on any mismatch.
+//
+
+#include "ECCallCostKernel.h"
+#include "ECTrafficGenerator.h"
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Seconds per Score call, best of a few rounds so a stray interruption does not count
+static double TimeScore(const ECCallCostKernel &kernel, const std::vector<int> &src, const std::vector<int> &dest,
+                        float *costs, std::vector<int> &bestCar, int reps) {
+    double best = 1e30;
+    for (int round = 0; round < 3; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < reps; ++rep) {
+            kernel.Score(src.data(), dest.data(), static_cast<int>(src.size()), costs, bestCar.data());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / reps;
+        best = std::min(best, seconds);
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> carCounts = { 4, 16, 64 };
+    int numCalls = 4096;
+    int numFloors = 40;
+    int reps = 20;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool fHasValue = i + 1 < argc;
+        if (arg == "--cars" && fHasValue) {
+            carCounts.clear();
+            std::istringstream in(argv[++i]);
+            std::string item;
+            while (std::getline(in, item, ',')) {
+                carCounts.push_back(atoi(item.c_str()));
+            }
+        } else if (arg == "--calls" && fHasValue) {
+            numCalls = atoi(argv[++i]);
+        } else if (arg == "--floors" && fHasValue) {
+            numFloors = atoi(argv[++i]);
+        } else if (arg == "--reps" && fHasValue) {
+            reps = atoi(argv[++i]);
+        } else if (arg == "--seed" && fHasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--cars 4,16,64] [--calls 4096] [--floors 40] [--reps 20] [--seed 1]" << std::endl;
+            return 1;
+        }
+    }
+    if (numCalls < 1 || numFloors < 2 || reps < 1) {
+        std::cerr << "Error: need at least one call, two floors and one repetition" << std::endl;
+        return 1;
+    }
+
+    ECRandom random(seed);
+    std::vector<int> src(numCalls), dest(numCalls);
+    for (int call = 0; call < numCalls; ++call) {
+        src[call] = 1 + random.NextInt(numFloors);
+        dest[call] = 1 + random.NextInt(numFloors - 1);
+        if (dest[call] >= src[call]) {
+            dest[call]++;
+        }
+    }
+
+    bool fAllMatch = true;
+    EC_COST_KERNEL kernels[] = { EC_COST_KERNEL_SCALAR, EC_COST_KERNEL_AVX2, EC_COST_KERNEL_AVX512 };
+    for (int numCars : carCounts) {
+        if (numCars < 1) {
+            continue;
+        }
+        ECCallCostKernel bank(numCars);
+        const int capacity = 16;
+        for (int car = 0; car < numCars; ++car) {
+            bank.SetCar(car, 1 + random.NextInt(numFloors), random.NextInt(3) - 1, random.NextInt(capacity + 1), capacity, random.NextInt(8));
+        }
+        size_t matrixSize = static_cast<size_t>(numCalls) * bank.GetStride();
+        std::vector<float> expectedCosts(matrixSize), costs(matrixSize);
+        std::vector<int> expectedBest(numCalls), best(numCalls);
+
+        double pairs = static_cast<double>(numCalls) * numCars;
+        double scalarSeconds = 0;
+        std::cout << numCars << " cars x " << numCalls << " calls" << std::endl;
+        for (int k = 0; k < 3; ++k) {
+            if (!ECCallCostKernel::IsKernelAvailable(kernels[k])) {
+                continue;
+            }
+            bank.SetKernel(kernels[k]);
+            bool fScalar = kernels[k] == EC_COST_KERNEL_SCALAR;
+            std::vector<float> &matrix = fScalar ? expectedCosts : costs;
+            std::vector<int> &cars = fScalar ? expectedBest : best;
+            double matrixSeconds = TimeScore(bank, src, dest, matrix.data(), cars, reps);
+            double bestOnlySeconds = TimeScore(bank, src, dest, NULL, cars, reps);
+            if (fScalar) {
+                scalarSeconds = bestOnlySeconds;
+            }
+
+            int numMismatched = 0;
+            if (!fScalar) {
+                for (int call = 0; call < numCalls; ++call) {
+                    if (best[call] != expectedBest[call] ||
+                        memcmp(&costs[static_cast<size_t>(call) * bank.GetStride()], &expectedCosts[static_cast<size_t>(call) * bank.GetStride()],
+                               sizeof(float) * numCars) != 0) {
+                        numMismatched++;
+                    }
+                }
+            }
+            fAllMatch = fAllMatch && numMismatched == 0;
+
+            std::cout << "  " << std::left << std::setw(8) << ECCallCostKernel::GetKernelName(kernels[k]) << std::right << std::fixed
+                      << std::setprecision(0) << std::setw(6) << pairs / matrixSeconds / 1e6 << " M pairs/s with costs, "
+                      << std::setw(6) << pairs / bestOnlySeconds / 1e6 << " M pairs/s best car only (" << std::setprecision(1)
+                      << scalarSeconds / bestOnlySeconds << "x), " << numMismatched << " calls differ" << std::endl;
+        }
+    }
+    return fAllMatch ? 0 : 1;
+}
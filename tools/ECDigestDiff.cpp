@@ -0,0 +1,193 @@
+//
+//  ECDigestDiff.cpp
+//
+//  Compares two digest streams (see ECStateDigest.h) and reports the first
+//  tick where the runs diverge. With --input, both engines named in the
+//  headers are re-run on the request file up to that tick and their states
+//  are printed side by side, differing lines marked with '*'. --input-b gives
+//  the second run its own request file when the inputs are what changed.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECFixedElevatorSim.h"
+#include "ECBatchElevatorSim.h"
+#include "ECStateDigest.h"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+static std::vector<ECElevatorSimRequest> ReadRequests(const std::string &filename) {
+    std::vector<ECElevatorSimRequest> requests;
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+    std::string line;
+    int time, floorSrc, floorDest;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        if (iss >> time >> floorSrc >> floorDest) {
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return requests;
+}
+
+static std::shared_ptr<const std::vector<ECElevatorSimRequest> > ReadSchedule(const std::string &filename, int numFloors) {
+    std::vector<ECElevatorSimRequest> requests = ReadRequests(filename);
+    ECElevatorSim sorter(numFloors, requests);   // sorts the schedule as every engine expects
+    return sorter.GetSharedRequestSchedule();
+}
+
+// Re-runs the named engine for numTicks ticks; false for an engine that cannot be re-run here
+static bool RunEngineToState(const std::string &engineName, int numFloors,
+                             std::shared_ptr<const std::vector<ECElevatorSimRequest> > schedule,
+                             int numTicks, ECEngineState &state) {
+    if (engineName == "ECElevatorSim") {
+        ECElevatorSim sim(numFloors, schedule);
+        sim.StepN(numTicks);
+        sim.FillState(state);
+        return true;
+    }
+    if (engineName == "ECFixedElevatorSim") {
+        return ECFixedEngines::RunToState(numFloors, schedule, numTicks, state);
+    }
+    if (engineName == "ECBatchElevatorSim") {
+        ECBatchElevatorSim batch(numFloors);
+        int building = batch.AddBuilding(schedule);
+        if (building < 0) {
+            return false;
+        }
+        batch.StepN(numTicks);
+        batch.FillState(building, state);
+        return true;
+    }
+    return false;
+}
+
+static std::vector<std::string> DumpLines(const ECEngineState &state) {
+    std::ostringstream out;
+    state.Dump(out);
+    std::vector<std::string> lines;
+    std::istringstream in(out.str());
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static void PrintSideBySide(const std::string &nameA, const ECEngineState &stateA,
+                            const std::string &nameB, const ECEngineState &stateB) {
+    std::vector<std::string> linesA = DumpLines(stateA);
+    std::vector<std::string> linesB = DumpLines(stateB);
+    const int width = 52;
+    std::cout << "  " << std::left << std::setw(width) << nameA << nameB << std::endl;
+    size_t numLines = std::max(linesA.size(), linesB.size());
+    for (size_t i = 0; i < numLines; ++i) {
+        std::string lineA = i < linesA.size() ? linesA[i] : "";
+        std::string lineB = i < linesB.size() ? linesB[i] : "";
+        std::cout << (lineA == lineB ? "  " : "* ") << std::left << std::setw(width) << lineA << lineB << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <a.digest> <b.digest> [--input <request_file> [--input-b <request_file>]]" << std::endl;
+        return 2;
+    }
+    std::string inputFilename;
+    std::string inputFilenameB;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc) {
+            inputFilename = argv[++i];
+        } else if (arg == "--input-b" && i + 1 < argc) {
+            inputFilenameB = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    ECDigestReader readerA, readerB;
+    if (!readerA.Open(argv[1]) || !readerB.Open(argv[2])) {
+        return 2;
+    }
+    const ECDigestHeader &headerA = readerA.GetHeader();
+    const ECDigestHeader &headerB = readerB.GetHeader();
+    if (headerA.numFloors != headerB.numFloors) {
+        std::cout << "Runs differ in building height: " << headerA.numFloors << " vs " << headerB.numFloors << " floors" << std::endl;
+        return 1;
+    }
+    if (headerA.firstTick != headerB.firstTick) {
+        // Rolling digests depend on every earlier tick, so streams must start together
+        std::cerr << "Error: streams start at different ticks (" << headerA.firstTick << " vs " << headerB.firstTick
+                  << "); record both runs from the same point" << std::endl;
+        return 2;
+    }
+
+    // Tick t is the record whose state is "t ticks run"
+    int tick = headerA.firstTick;
+    uint64_t digestA = 0, digestB = 0;
+    bool fMoreA = false, fMoreB = false;
+    while (true) {
+        fMoreA = readerA.Next(digestA);
+        fMoreB = readerB.Next(digestB);
+        if (!fMoreA || !fMoreB) {
+            break;
+        }
+        ++tick;
+        if (digestA != digestB) {
+            break;
+        }
+    }
+
+    std::string engineA = readerA.GetEngineName();
+    std::string engineB = readerB.GetEngineName();
+    if (fMoreA && fMoreB) {
+        std::cout << "First divergence after " << tick << " ticks (" << engineA << " vs " << engineB << ")" << std::endl;
+    } else if (fMoreA != fMoreB) {
+        // Same states for as long as both ran: one run just stopped sooner
+        int numTicksShort = tick;
+        int numTicksLong = tick + 1;
+        uint64_t digest;
+        ECDigestReader &longer = fMoreA ? readerA : readerB;
+        while (longer.Next(digest)) {
+            numTicksLong++;
+        }
+        std::cout << "Identical for " << numTicksShort << " ticks; " << (fMoreA ? engineA : engineB) << " ran on to "
+                  << numTicksLong << " ticks" << std::endl;
+        return 1;
+    } else {
+        std::cout << "Identical: " << tick << " ticks (" << engineA << " vs " << engineB << ")" << std::endl;
+        return 0;
+    }
+
+    if (!inputFilename.empty()) {
+        int numFloors = headerA.numFloors;
+        std::shared_ptr<const std::vector<ECElevatorSimRequest> > scheduleA = ReadSchedule(inputFilename, numFloors);
+        std::shared_ptr<const std::vector<ECElevatorSimRequest> > scheduleB =
+            inputFilenameB.empty() ? scheduleA : ReadSchedule(inputFilenameB, numFloors);
+
+        ECEngineState stateA(numFloors), stateB(numFloors);
+        bool fRanA = RunEngineToState(engineA, numFloors, scheduleA, tick, stateA);
+        bool fRanB = RunEngineToState(engineB, numFloors, scheduleB, tick, stateB);
+        if (!fRanA || !fRanB) {
+            std::cerr << "Error: cannot re-run " << (fRanA ? engineB : engineA) << " for a state dump" << std::endl;
+            return 1;
+        }
+        std::cout << std::endl;
+        PrintSideBySide(engineA, stateA, engineB, stateB);
+    }
+    return 1;
+}
@@ -0,0 +1,178 @@
+//
+//  ECGroupSim.cpp
+//
+//  Runs a building of several cars under destination dispatch
+//  (ECGroupElevatorSim) on an input file or generated traffic, and reports
+//  waits, rides and how long each car assignment took against the 1 ms
+//  budget of live mode. --single runs the same calls through one car under
+//  the same dispatcher, for reference. --dwell sets how many ticks a car
+//  stands at each stop. With --live the building takes its calls from a FIFO
+//  or socket instead, as elevator_sim does, pacing ticks --tick-ms apart and
+//  printing a status line every --report ticks until interrupted.
+//
+
+#include "ECGroupElevatorSim.h"
+#include "ECLiveRequestSource.h"
+#include "ECTrafficGenerator.h"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <string>
+
+static const char *USAGE = " [--input <file>] [--cars 4] [--floors 10] [--duration 3600] [--rate 0.05] [--lobby 0.3]"
+                           " [--dwell 2] [--seed 1] [--single] [--live <path> [--tick-ms 100] [--report 10]]";
+
+static bool ReadRequests(const std::string &filename, std::vector<ECElevatorSimRequest> &requests) {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::string line;
+    int time, floorSrc, floorDest;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        if (iss >> time >> floorSrc >> floorDest) {
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return true;
+}
+
+static void PrintWaits(const char *label, const ECWaitHistogram &waits) {
+    std::cout << std::fixed << std::setprecision(2) << label << " mean " << waits.GetMean() << ", p50 " << waits.GetPercentile(0.5)
+              << ", p95 " << waits.GetPercentile(0.95) << ", max " << waits.GetMax() << std::endl;
+}
+
+static void PrintAssignTimes(const ECGroupElevatorSim &sim) {
+    const ECWaitHistogram &nanos = sim.GetAssignNanos();
+    double p99Micros = nanos.GetPercentile(0.99) / 1000.0;
+    std::cout << std::fixed << std::setprecision(1) << "assignment: mean " << nanos.GetMean() / 1000.0 << " us, p99 "
+              << p99Micros << " us, max " << nanos.GetMax() / 1000.0 << " us over " << nanos.GetCount() << " calls, "
+              << sim.GetMaxActiveCalls() << " calls active at most (" << (p99Micros < 1000.0 ? "within" : "over")
+              << " the 1 ms budget)" << std::endl;
+}
+
+static int RunLive(ECGroupElevatorSim &sim, const std::string &path, int tickMillis, int reportTicks) {
+    ECLiveRequestSource source(path);
+    if (!source.Open()) {
+        return 1;
+    }
+    sim.AttachLiveSource(&source);
+    std::cout << "Listening for calls on " << path << " (" << sim.GetNumCars() << " cars, " << sim.GetNumFloors() << " floors)" << std::endl;
+    auto nextTick = std::chrono::steady_clock::now();
+    while (true) {
+        sim.Step();
+        if (reportTicks > 0 && sim.GetCurrentTime() % reportTicks == 0) {
+            std::cout << "t=" << sim.GetCurrentTime() << " active " << sim.GetNumActiveCalls() << " cars";
+            for (int car = 0; car < sim.GetNumCars(); ++car) {
+                std::cout << " " << sim.GetCarFloor(car) << "(" << sim.GetNumRiders(car) << ")";
+            }
+            std::cout << std::fixed << std::setprecision(2) << " mean wait " << sim.GetWaitTimes().GetMean()
+                      << " p99 assign " << sim.GetAssignNanos().GetPercentile(0.99) / 1000.0 << " us" << std::endl;
+        }
+        nextTick += std::chrono::milliseconds(tickMillis);
+        std::this_thread::sleep_until(nextTick);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string inputFilename;
+    std::string livePath;
+    int numCars = 4;
+    int dwellTicks = 2;
+    int tickMillis = 100;
+    int reportTicks = 10;
+    bool fSingle = false;
+    uint64_t seed = 1;
+    ECTrafficConfig traffic;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool fHasValue = i + 1 < argc;
+        if (arg == "--input" && fHasValue) {
+            inputFilename = argv[++i];
+        } else if (arg == "--cars" && fHasValue) {
+            numCars = atoi(argv[++i]);
+        } else if (arg == "--floors" && fHasValue) {
+            traffic.numFloors = atoi(argv[++i]);
+        } else if (arg == "--duration" && fHasValue) {
+            traffic.duration = atoi(argv[++i]);
+        } else if (arg == "--rate" && fHasValue) {
+            traffic.callsPerTick = atof(argv[++i]);
+        } else if (arg == "--lobby" && fHasValue) {
+            traffic.lobbyShare = atof(argv[++i]);
+        } else if (arg == "--dwell" && fHasValue) {
+            dwellTicks = atoi(argv[++i]);
+        } else if (arg == "--seed" && fHasValue) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--single") {
+            fSingle = true;
+        } else if (arg == "--live" && fHasValue) {
+            livePath = argv[++i];
+        } else if (arg == "--tick-ms" && fHasValue) {
+            tickMillis = atoi(argv[++i]);
+        } else if (arg == "--report" && fHasValue) {
+            reportTicks = atoi(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << USAGE << std::endl;
+            return 1;
+        }
+    }
+    if (numCars < 1 || traffic.numFloors < 2 || dwellTicks < 1) {
+        std::cerr << "Error: need at least one car, two floors and a dwell of a tick" << std::endl;
+        return 1;
+    }
+
+    if (!livePath.empty()) {
+        std::vector<ECElevatorSimRequest> none;
+        ECGroupElevatorSim sim(traffic.numFloors, numCars, none);
+        sim.GetController().SetDwellTicks(dwellTicks);
+        return RunLive(sim, livePath, tickMillis, reportTicks);
+    }
+
+    std::vector<ECElevatorSimRequest> requests;
+    if (!inputFilename.empty()) {
+        if (!ReadRequests(inputFilename, requests)) {
+            return 1;
+        }
+    } else {
+        requests = ECTrafficGenerator(traffic).Generate(ECTrafficGenerator::StreamSeed(seed, 0));
+    }
+    for (const ECElevatorSimRequest &request : requests) {
+        if (request.GetFloorSrc() < 1 || request.GetFloorSrc() > traffic.numFloors ||
+            request.GetFloorDest() < 1 || request.GetFloorDest() > traffic.numFloors) {
+            std::cerr << "Error: a request names a floor outside 1.." << traffic.numFloors << " (set --floors)" << std::endl;
+            return 1;
+        }
+    }
+
+    ECGroupElevatorSim sim(traffic.numFloors, numCars, requests);
+    sim.GetController().SetDwellTicks(dwellTicks);
+    auto start = std::chrono::steady_clock::now();
+    ECElevatorStepResult result = sim.StepN(100 * traffic.duration + 100000);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << numCars << " cars, " << traffic.numFloors << " floors: " << sim.GetTotalRequests() << " calls served in "
+              << result.timeNow << " ticks (" << sim.GetTotalMoves() << " car moves, " << std::setprecision(3) << seconds << " s)"
+              << (result.fComplete ? "" : ", NOT all served") << std::endl;
+    PrintWaits("wait:", sim.GetWaitTimes());
+    PrintWaits("ride:", sim.GetRideTimes());
+    PrintAssignTimes(sim);
+
+    if (fSingle) {
+        ECGroupElevatorSim single(traffic.numFloors, 1, requests);
+        single.GetController().SetDwellTicks(dwellTicks);
+        single.StepN(100 * traffic.duration + 100000);
+        PrintWaits("single car wait:", single.GetWaitTimes());
+    }
+    return result.fComplete ? 0 : 1;
+}
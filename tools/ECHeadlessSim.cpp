@@ -0,0 +1,152 @@
+//
+//  ECHeadlessSim.cpp
+//
+//  Runs the backend alone, without the frontend: writes the same trace and
+//  <output_file>.rollup as elevator_sim. When the building height has a
+//  compiled-in specialization (ECFixedEngines) that engine is used; any other
+//  height falls back to the runtime-sized ECElevatorSim. With --digest the run
+//  also writes a digest stream for ECDigestDiff, and with --trips a trip table
+//  for ECTripQuery. --park turns on idle parking, which only the runtime
+//  engine has, so it always runs ECElevatorSim. A request naming a floor
+//  outside 1..--floors is an error.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECFixedElevatorSim.h"
+#include "ECStateDigest.h"
+#include "ECTripTable.h"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+static std::vector<ECElevatorSimRequest> ReadRequests(const std::string &filename) {
+    std::vector<ECElevatorSimRequest> requests;
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+    std::string line;
+    int time, floorSrc, floorDest;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        if (iss >> time >> floorSrc >> floorDest) {
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return requests;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <output_file> [--floors 5] [--duration 50]"
+                  << " [--engine auto|runtime] [--no-rollups] [--park] [--digest <file>] [--trips <file>]" << std::endl;
+        return 1;
+    }
+    std::string inputFilename = argv[1];
+    std::string outputFilename = argv[2];
+    int numFloors = 5;
+    int duration = 50;
+    bool fRuntimeEngine = false;
+    bool fRollups = true;
+    bool fParking = false;
+    std::string digestFilename;
+    std::string tripsFilename;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--floors" && i + 1 < argc) {
+            numFloors = atoi(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration = atoi(argv[++i]);
+        } else if (arg == "--engine" && i + 1 < argc) {
+            std::string engine = argv[++i];
+            if (engine != "auto" && engine != "runtime") {
+                std::cerr << "Error: --engine must be auto or runtime" << std::endl;
+                return 1;
+            }
+            fRuntimeEngine = engine == "runtime";
+        } else if (arg == "--no-rollups") {
+            fRollups = false;
+        } else if (arg == "--park") {
+            fParking = true;
+        } else if (arg == "--digest" && i + 1 < argc) {
+            digestFilename = argv[++i];
+        } else if (arg == "--trips" && i + 1 < argc) {
+            tripsFilename = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (numFloors < 1) {
+        std::cerr << "Error: --floors must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<ECElevatorSimRequest> requests = ReadRequests(inputFilename);
+    for (const ECElevatorSimRequest &request : requests) {
+        int floors[2] = { request.GetFloorSrc(), request.GetFloorDest() };
+        for (int floor : floors) {
+            if (floor < 1 || floor > numFloors) {
+                std::cerr << "Error: the request at time " << request.GetTime() << " names floor " << floor
+                          << ", outside 1.." << numFloors << " (set --floors)" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (fParking && !fRuntimeEngine && ECFixedEngines::HasSpecialization(numFloors)) {
+        std::cout << "Note: --park runs ECElevatorSim; ECFixedElevatorSim has no idle parking" << std::endl;
+        fRuntimeEngine = true;
+    }
+    ECElevatorSim sim(numFloors, requests);   // sorts the schedule; also the fallback engine
+
+    bool fFixedEngine = !fRuntimeEngine && ECFixedEngines::HasSpecialization(numFloors);
+    const char *engineName = fFixedEngine ? "ECFixedElevatorSim" : "ECElevatorSim";
+    ECDigestWriter digest(digestFilename, engineName);
+    if (!digestFilename.empty() && !digest.Open()) {
+        return 1;
+    }
+    ECDigestWriter *digestOrNull = digest.IsOpen() ? &digest : NULL;
+    ECTripTableWriter trips(tripsFilename);
+    if (!tripsFilename.empty() && !trips.Open()) {
+        return 1;
+    }
+    ECTripTableWriter *tripsOrNull = trips.IsOpen() ? &trips : NULL;
+
+    auto start = std::chrono::steady_clock::now();
+    if (fFixedEngine) {
+        ECFixedEngines::Simulate(numFloors, sim.GetSharedRequestSchedule(),
+                                 duration, outputFilename, fRollups, digestOrNull, tripsOrNull);
+    } else {
+        if (fRollups) {
+            sim.EnableRollups();
+        }
+        if (fParking) {
+            sim.EnableIdleParking();
+        }
+        sim.AttachDigest(digestOrNull);
+        sim.AttachTripTable(tripsOrNull);
+        sim.Simulate(duration, outputFilename);
+    }
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Simulated " << numFloors << " floors with " << engineName << " in " << millis << " ms" << std::endl;
+    if (digestOrNull != NULL) {
+        digest.Close();
+        std::cout << "Digest: " << digest.GetNumRecords() << " ticks to " << digestFilename << std::endl;
+    }
+    if (tripsOrNull != NULL) {
+        if (!trips.Close()) {
+            return 1;
+        }
+        std::cout << "Trips: " << trips.GetNumRows() << " rows to " << tripsFilename << std::endl;
+    }
+    return 0;
+}
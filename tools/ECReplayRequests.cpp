@@ -0,0 +1,153 @@
+//
+//  ECReplayRequests.cpp
+//
+//  Replays a request file into a running simulator's live input
+//  (a FIFO or a Unix domain socket), at a chosen number of ticks per second.
+//
+
+#include "ECLiveRequestSource.h"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Read "time src dest" lines, skipping comments and the "floors duration" header
+static std::vector<ECLiveRequest> ReadRequests(const std::string &filename) {
+    std::vector<ECLiveRequest> requests;
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        exit(1);
+    }
+
+    std::string line;
+    while (std::getline(inFile, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        ECLiveRequest request;
+        if (iss >> request.time >> request.floorSrc >> request.floorDest) {
+            requests.push_back(request);
+        }
+    }
+    return requests;
+}
+
+// Open the simulator's live input for writing
+static int OpenTarget(const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISFIFO(st.st_mode)) {
+        return open(path.c_str(), O_WRONLY);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool WriteAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <fifo_or_socket> [--rate <ticks_per_sec>] [--binary]" << std::endl
+                  << "  --rate 0 sends everything at once (useful to exercise overload handling)" << std::endl;
+        return 1;
+    }
+
+    std::string inputFilename = argv[1];
+    std::string targetPath = argv[2];
+    double ticksPerSecond = 1.0;
+    bool fBinary = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--rate" && i + 1 < argc) {
+            ticksPerSecond = atof(argv[++i]);
+        } else if (arg == "--binary") {
+            fBinary = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<ECLiveRequest> requests = ReadRequests(inputFilename);
+
+    signal(SIGPIPE, SIG_IGN);
+    int fd = OpenTarget(targetPath);
+    if (fd < 0) {
+        std::cerr << "Error: Could not connect to " << targetPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Requests are sent when their tick comes up, relative to the first request
+    auto start = std::chrono::steady_clock::now();
+    int firstTime = requests.empty() ? 0 : requests.front().time;
+    long long sent = 0;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const ECLiveRequest &request = requests[i];
+        if (ticksPerSecond > 0) {
+            std::chrono::duration<double> offset((request.time - firstTime) / ticksPerSecond);
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+        }
+
+        bool ok;
+        if (fBinary) {
+            char frame[EC_LIVE_FRAME_SIZE];
+            int fields[3] = { request.time, request.floorSrc, request.floorDest };
+            memcpy(frame, &EC_LIVE_FRAME_MAGIC, sizeof(EC_LIVE_FRAME_MAGIC));
+            memcpy(frame + sizeof(EC_LIVE_FRAME_MAGIC), fields, sizeof(fields));
+            ok = WriteAll(fd, frame, sizeof(frame));
+        } else {
+            std::ostringstream oss;
+            oss << request.time << " " << request.floorSrc << " " << request.floorDest << "\n";
+            ok = WriteAll(fd, oss.str().data(), oss.str().size());
+        }
+        if (!ok) {
+            std::cerr << "Error: Simulator closed the connection after " << sent << " requests." << std::endl;
+            close(fd);
+            return 1;
+        }
+        ++sent;
+    }
+
+    close(fd);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Sent " << sent << " requests in " << elapsed.count() << " s." << std::endl;
+    return 0;
+}
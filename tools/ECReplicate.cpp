@@ -0,0 +1,169 @@
+//
+//  ECReplicate.cpp
+//
+//  Runs replications of random traffic through ECElevatorSim until the mean
+//  and 90th-percentile waits are known to the requested precision, printing
+//  the confidence intervals as each replication finishes. With --compare-rate
+//  a second configuration (the same building under a different call rate) runs
+//  on the same random numbers as the first, and the stopping rule applies to
+//  the difference between the two. --compare-parking does the same with the
+//  same traffic and idle parking turned on.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECTrafficGenerator.h"
+#include "ECReplicationRunner.h"
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+static const char *USAGE = " [--floors 10] [--duration 3600] [--rate 0.05] [--lobby 0.3] [--compare-rate r]"
+                           " [--compare-parking] [--precision 0.02] [--confidence 0.95] [--min-runs 5] [--max-runs 1000]"
+                           " [--threads n] [--seed 1] [--independent] [--quiet]";
+
+// One replication: the building runs until every call is served, or for four times the arrival period
+static void RunReplication(const ECTrafficConfig &traffic, bool fParking, uint64_t seed, std::vector<double> &metrics) {
+    std::vector<ECElevatorSimRequest> requests = ECTrafficGenerator(traffic).Generate(seed);
+    ECElevatorSim sim(traffic.numFloors, requests);
+    if (fParking) {
+        sim.EnableIdleParking();
+    }
+    sim.StepN(4 * traffic.duration);
+    const ECWaitHistogram &waits = sim.GetWaitTimes();
+    metrics[0] = waits.GetMean();
+    metrics[1] = waits.GetPercentile(0.90);
+}
+
+static std::string FormatRate(double callsPerTick) {
+    std::ostringstream out;
+    out << "rate " << callsPerTick;
+    return out.str();
+}
+
+static std::string FormatInterval(const ECRunningStats &stats, double confidence) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << stats.GetMean() << " +/- " << stats.GetHalfWidth(confidence);
+    return out.str();
+}
+
+int main(int argc, char **argv) {
+    ECTrafficConfig baseline;
+    double compareRate = -1;
+    bool fCompareParking = false;
+    ECReplicationOptions options;
+    options.numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    bool fQuiet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool fHasValue = i + 1 < argc;
+        if (arg == "--floors" && fHasValue) {
+            baseline.numFloors = atoi(argv[++i]);
+        } else if (arg == "--duration" && fHasValue) {
+            baseline.duration = atoi(argv[++i]);
+        } else if (arg == "--rate" && fHasValue) {
+            baseline.callsPerTick = atof(argv[++i]);
+        } else if (arg == "--lobby" && fHasValue) {
+            baseline.lobbyShare = atof(argv[++i]);
+        } else if (arg == "--compare-rate" && fHasValue) {
+            compareRate = atof(argv[++i]);
+        } else if (arg == "--compare-parking") {
+            fCompareParking = true;
+        } else if (arg == "--precision" && fHasValue) {
+            options.relativePrecision = atof(argv[++i]);
+        } else if (arg == "--confidence" && fHasValue) {
+            options.confidence = atof(argv[++i]);
+        } else if (arg == "--min-runs" && fHasValue) {
+            options.minRuns = atoi(argv[++i]);
+        } else if (arg == "--max-runs" && fHasValue) {
+            options.maxRuns = atoi(argv[++i]);
+        } else if (arg == "--threads" && fHasValue) {
+            options.numThreads = atoi(argv[++i]);
+        } else if (arg == "--seed" && fHasValue) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--independent") {
+            options.fCommonRandomNumbers = false;
+        } else if (arg == "--quiet") {
+            fQuiet = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << USAGE << std::endl;
+            return 1;
+        }
+    }
+    if (baseline.numFloors < 2 || baseline.duration < 1 || baseline.callsPerTick <= 0 ||
+        options.confidence <= 0 || options.confidence >= 1) {
+        std::cerr << "Error: need at least 2 floors, a positive duration and rate, and a confidence in (0, 1)" << std::endl;
+        return 1;
+    }
+    if (compareRate > 0 && fCompareParking) {
+        std::cerr << "Error: --compare-rate and --compare-parking cannot be used together" << std::endl;
+        return 1;
+    }
+
+    // Both configurations draw candidates at the higher rate and thin them, so they share their people
+    std::vector<ECTrafficConfig> configs(1, baseline);
+    std::vector<std::string> variantNames(1, FormatRate(baseline.callsPerTick));
+    std::vector<bool> parking(1, false);
+    if (compareRate > 0) {
+        configs.push_back(baseline);
+        configs[1].callsPerTick = compareRate;
+        configs[0].peakCallsPerTick = configs[1].peakCallsPerTick = std::max(baseline.callsPerTick, compareRate);
+        variantNames.push_back(FormatRate(compareRate));
+        parking.push_back(false);
+    } else if (fCompareParking) {
+        configs.push_back(baseline);
+        variantNames.push_back(FormatRate(baseline.callsPerTick) + ", parking");
+        parking.push_back(true);
+    }
+    std::vector<std::string> metricNames = { "mean wait", "p90 wait" };
+
+    ECReplicationRunner runner(variantNames, metricNames, [&configs, &parking](int variant, uint64_t seed, std::vector<double> &metrics) {
+        RunReplication(configs[variant], parking[variant], seed, metrics);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    runner.Run(options, [fQuiet](const ECReplicationRunner &progress) {
+        if (fQuiet) {
+            return;
+        }
+        std::cout << "run " << std::setw(4) << progress.GetNumRuns();
+        for (int metric = 0; metric < progress.GetNumMetrics(); ++metric) {
+            const ECRunningStats &stats = progress.GetNumVariants() == 2 ? progress.GetDifference(metric) : progress.GetStats(0, metric);
+            std::cout << "  " << progress.GetMetricName(metric) << (progress.GetNumVariants() == 2 ? " diff " : " ")
+                      << FormatInterval(stats, progress.GetConfidence());
+        }
+        std::cout << std::endl;
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << (runner.IsPrecise() ? "Reached" : "Did not reach") << " +/-" << options.relativePrecision * 100 << "% at "
+              << options.confidence * 100 << "% confidence after " << runner.GetNumRuns() << " replications ("
+              << (options.fCommonRandomNumbers ? "common" : "independent") << " random numbers, "
+              << options.numThreads << " threads, " << seconds << " s)" << std::endl;
+    for (int variant = 0; variant < runner.GetNumVariants(); ++variant) {
+        std::cout << runner.GetVariantName(variant) << ":";
+        for (int metric = 0; metric < runner.GetNumMetrics(); ++metric) {
+            std::cout << "  " << runner.GetMetricName(metric) << " " << FormatInterval(runner.GetStats(variant, metric), options.confidence);
+        }
+        std::cout << std::endl;
+    }
+    if (runner.GetNumVariants() == 2) {
+        std::cout << "difference:";
+        for (int metric = 0; metric < runner.GetNumMetrics(); ++metric) {
+            const ECRunningStats &difference = runner.GetDifference(metric);
+            std::cout << "  " << runner.GetMetricName(metric) << " " << FormatInterval(difference, options.confidence);
+            // Independent runs would need this many times the replications for the same interval
+            double independentVariance = runner.GetStats(0, metric).GetVariance() + runner.GetStats(1, metric).GetVariance();
+            if (options.fCommonRandomNumbers && difference.GetVariance() > 0) {
+                std::cout << " (" << std::fixed << std::setprecision(1) << independentVariance / difference.GetVariance() << "x the runs if independent)";
+            }
+        }
+        std::cout << std::endl;
+    }
+    return runner.IsPrecise() ? 0 : 1;
+}
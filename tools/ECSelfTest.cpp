@@ -0,0 +1,351 @@
+//
+//  ECSelfTest.cpp
+//
+//  Checks on the request files given that no other tool makes, printing one
+//  line per check and exiting with status 1 if any fails:
+//
+//    resume   a simulator restored from a checkpoint taken part way through a
+//             run (with rollups, with and without idle parking) ends in the
+//             same state as the unbroken run
+//    live     every call streamed over a socket is either delivered or
+//             counted: none lost under --block with a tiny queue, received =
+//             delivered + dropped + still queued when dropping, and malformed,
+//             overlong and out-of-range lines rejected; a live run ends
+//             once the writer has hung up and its calls are served
+//    trips    a trip table reads back the trips written to it; a failed write
+//             and a group claiming more rows than it holds are reported
+//    batch    ECBatchElevatorSim refuses heights outside 1..MAX_FLOORS and
+//             buildings with a request outside 1..numFloors
+//    group    the dispatcher's predicted waits and rides match the simulated
+//             ones for calls far enough apart not to meet
+//
+//  tests/run_checks.sh runs it along with the other checking tools.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECLiveRequestSource.h"
+#include "ECBatchElevatorSim.h"
+#include "ECGroupElevatorSim.h"
+#include "ECTripTable.h"
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <climits>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static bool ReadFile(const std::string &filename, std::string &text, std::vector<ECElevatorSimRequest> &requests) {
+    std::ifstream inFile(filename);
+    if (!inFile.is_open()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    std::stringstream contents;
+    contents << inFile.rdbuf();
+    text = contents.str();
+
+    std::istringstream lines(text);
+    std::string line;
+    int time, floorSrc, floorDest;
+    while (std::getline(lines, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        if (iss >> time >> floorSrc >> floorDest) {
+            requests.emplace_back(time, floorSrc, floorDest);
+        }
+    }
+    return true;
+}
+
+static bool Report(const std::string &check, bool fOk, const std::string &detail) {
+    std::cout << (fOk ? "ok   " : "FAIL ") << check << (detail.empty() ? "" : ": ") << detail << std::endl;
+    return fOk;
+}
+
+static std::string SaveState(const ECElevatorSim &sim) {
+    std::ostringstream out;
+    sim.SaveState(out, 0);
+    return out.str();
+}
+
+static int HighestFloor(const std::vector<ECElevatorSimRequest> &requests) {
+    int numFloors = 2;
+    for (const ECElevatorSimRequest &request : requests) {
+        numFloors = std::max(numFloors, std::max(request.GetFloorSrc(), request.GetFloorDest()));
+    }
+    return numFloors;
+}
+
+//*****************************************************************************
+// Checkpoint and resume
+
+static bool CheckResume(const std::string &filename, std::vector<ECElevatorSimRequest> &requests) {
+    int numFloors = HighestFloor(requests);
+    int numTicks = 0;
+    for (const ECElevatorSimRequest &request : requests) {
+        numTicks = std::max(numTicks, request.GetTime());
+    }
+    numTicks += 4 * numFloors + 10;
+
+    int numChecked = 0, numDiffering = 0;
+    for (int parking = 0; parking < 2; ++parking) {
+        for (int split = 1; split < numTicks; split += 1 + split / 2) {
+            ECElevatorSim unbroken(numFloors, requests);
+            unbroken.EnableRollups();
+            if (parking) {
+                unbroken.EnableIdleParking(10, 4, 5);
+            }
+            unbroken.StepN(split);
+            std::istringstream checkpoint(SaveState(unbroken));
+
+            ECElevatorSim resumed(numFloors, requests);
+            long long outputOffset = 0;
+            bool fLoaded = resumed.LoadState(checkpoint, outputOffset);
+            unbroken.StepN(numTicks - split);
+            resumed.StepN(numTicks - split);
+            numChecked++;
+            if (!fLoaded || SaveState(unbroken) != SaveState(resumed)) {
+                numDiffering++;
+            }
+        }
+    }
+    std::ostringstream detail;
+    detail << filename << ", " << numChecked << " resume points, " << numDiffering << " differ";
+    return Report("resume", numDiffering == 0, detail.str());
+}
+
+//*****************************************************************************
+// Live source
+
+static bool SendOverSocket(const std::string &path, const std::string &data) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    bool fOk = fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 &&
+               write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    if (fd >= 0) {
+        close(fd);
+    }
+    return fOk;
+}
+
+// Streams data to a fresh source and drains it one call a tick, like a slow simulator
+static bool StreamCalls(const std::string &data, int capacity, EC_LIVE_OVERLOAD_POLICY policy, int numTicks,
+                        ECLiveSourceStats &stats, int &numDelivered, int &numQueued) {
+    std::ostringstream path;
+    path << "/tmp/ec_selftest_" << getpid() << ".sock";
+    ECLiveRequestSource source(path.str(), capacity, policy);
+    if (!source.Open() || !SendOverSocket(path.str(), data)) {
+        return false;
+    }
+    numDelivered = 0;
+    for (int tick = 0; tick < numTicks; ++tick) {
+        source.Poll();
+        ECLiveRequest request;
+        if (source.PopDue(INT_MAX, request)) {
+            numDelivered++;
+        }
+    }
+    numQueued = source.GetQueuedCount();
+    source.Close();
+    stats = source.GetStats();
+    return true;
+}
+
+// Runs a simulator fed only by the live source, with no tick limit to speak of
+static bool CheckLiveRunEnds(const std::string &filename, const std::string &text, const std::vector<ECElevatorSimRequest> &requests) {
+    const int MAX_TICKS = 1000000;
+    int numValid = 0;
+    for (const ECElevatorSimRequest &request : requests) {
+        numValid += request.GetFloorSrc() != request.GetFloorDest() ? 1 : 0;
+    }
+    std::ostringstream path, outputFilename;
+    path << "/tmp/ec_selftest_" << getpid() << ".sock";
+    outputFilename << "/tmp/ec_selftest_" << getpid() << ".txt";
+
+    std::vector<ECElevatorSimRequest> none;
+    ECElevatorSim sim(HighestFloor(requests), none);
+    ECLiveRequestSource source(path.str(), 4, EC_LIVE_BLOCK);
+    bool fRan = source.Open() && SendOverSocket(path.str(), text);
+    if (fRan) {
+        sim.AttachLiveSource(&source, 0);
+        sim.Simulate(MAX_TICKS, outputFilename.str());
+        sim.AttachLiveSource(NULL, 0);
+    }
+    source.Close();
+    unlink(outputFilename.str().c_str());
+
+    std::ostringstream detail;
+    detail << filename << ", run until the writer hangs up: ended at tick " << sim.GetCurrentTime() << " with "
+           << sim.GetTotalAlightings() << " of " << numValid << " calls served";
+    return Report("live", fRan && sim.GetCurrentTime() < MAX_TICKS && sim.GetTotalAlightings() == numValid, detail.str());
+}
+
+static bool CheckLiveSource(const std::string &filename, const std::string &text, const std::vector<ECElevatorSimRequest> &requests) {
+    int numCalls = static_cast<int>(requests.size());
+    bool fAllOk = true;
+    ECLiveSourceStats stats;
+    int numDelivered = 0, numQueued = 0;
+
+    bool fRan = StreamCalls(text, 4, EC_LIVE_BLOCK, 4 * numCalls + 20, stats, numDelivered, numQueued);
+    std::ostringstream detail;
+    detail << filename << ", --block with a queue of 4: " << numDelivered << " of " << numCalls << " calls delivered, "
+           << stats.dropped << " dropped";
+    fAllOk = Report("live", fRan && numDelivered == numCalls && stats.received == numCalls && stats.dropped == 0, detail.str()) && fAllOk;
+
+    fRan = StreamCalls(text, 2, EC_LIVE_DROP_NEWEST, numCalls / 2 + 1, stats, numDelivered, numQueued);
+    detail.str("");
+    detail << filename << ", dropping with a queue of 2: " << stats.received << " received = " << numDelivered << " delivered + "
+           << stats.dropped << " dropped + " << numQueued << " queued";
+    fAllOk = Report("live", fRan && stats.received == numCalls && stats.received == numDelivered + stats.dropped + numQueued,
+                    detail.str()) && fAllOk;
+
+    std::string malformed = "1 2\n5 1 99999999999\n" + std::string(5000, '1') + "\n3 1 2";
+    fRan = StreamCalls(malformed, 16, EC_LIVE_BLOCK, 20, stats, numDelivered, numQueued);
+    detail.str("");
+    detail << "malformed lines: " << stats.rejected << " of 3 rejected, " << numDelivered << " of 1 call delivered";
+    fAllOk = Report("live", fRan && stats.rejected == 3 && numDelivered == 1, detail.str()) && fAllOk;
+    return CheckLiveRunEnds(filename, text, requests) && fAllOk;
+}
+
+//*****************************************************************************
+// Trip tables
+
+static bool CheckTripTable(const std::string &filename, std::vector<ECElevatorSimRequest> &requests) {
+    std::ostringstream path;
+    path << "/tmp/ec_selftest_" << getpid() << ".trips";
+    ECElevatorSim sim(HighestFloor(requests), requests);
+    ECTripTableWriter writer(path.str(), 3);   // several groups even for a short file
+    bool fWritten = writer.Open();
+    if (fWritten) {
+        sim.AttachTripTable(&writer);
+        sim.StepN(1000000);
+        fWritten = writer.Close();
+    }
+
+    long long numRead = 0, waitSum = 0;
+    ECTripTableReader reader;
+    bool fRead = fWritten && reader.Open(path.str());
+    for (int g = 0; fRead && g < reader.GetNumGroups(); ++g) {
+        ECTripGroupView group = reader.GetGroup(g);
+        for (int i = 0; i < group.numRows; ++i) {
+            waitSum += group.timeBoard[i] - group.timeCall[i];
+        }
+        numRead += group.numRows;
+    }
+    reader.Close();
+
+    // A group header claiming more rows than the group holds must not be trusted
+    bool fCorruptRefused = true;
+    if (fRead && reader.Open(path.str()) && reader.GetNumGroups() > 0) {
+        reader.Close();
+        FILE *file = fopen(path.str().c_str(), "r+b");
+        int32_t bogus = 1 << 20;
+        fCorruptRefused = file != NULL && fseek(file, sizeof(ECTripTableHeader), SEEK_SET) == 0 &&
+                          fwrite(&bogus, sizeof(bogus), 1, file) == 1 && fclose(file) == 0 && !reader.Open(path.str());
+    }
+    unlink(path.str().c_str());
+
+    // Every write to /dev/full fails as on a full disk
+    ECTripTableWriter full("/dev/full", 3);
+    bool fFullRefused = true;
+    if (full.Open()) {
+        full.AddTrip(1, 1, 2, 1, 2, 0);
+        fFullRefused = !full.Close();
+    }
+
+    std::ostringstream detail;
+    detail << filename << ": " << numRead << " of " << sim.GetTotalAlightings() << " trips read back, waits " << waitSum << " vs "
+           << sim.GetWaitTimes().GetSum() << ", corrupt group " << (fCorruptRefused ? "refused" : "accepted")
+           << ", full disk " << (fFullRefused ? "reported" : "not reported");
+    return Report("trips", fRead && numRead == sim.GetTotalAlightings() && waitSum == sim.GetWaitTimes().GetSum() &&
+                  fCorruptRefused && fFullRefused, detail.str());
+}
+
+//*****************************************************************************
+// Batch engine
+
+static bool CheckBatchRefusesBadFloors(const std::string &filename, const std::vector<ECElevatorSimRequest> &requests) {
+    int numFloors = HighestFloor(requests);
+    if (numFloors > ECBatchElevatorSim::MAX_FLOORS) {
+        return Report("batch", true, filename + ", taller than a batch; skipped");
+    }
+    bool fHeightsRefused = !ECBatchElevatorSim(0).IsValid() && !ECBatchElevatorSim(ECBatchElevatorSim::MAX_FLOORS + 10).IsValid() &&
+                           ECBatchElevatorSim(ECBatchElevatorSim::MAX_FLOORS).IsValid();
+
+    ECBatchElevatorSim batch(numFloors);
+    int good = batch.AddBuilding(requests);
+    std::vector<ECElevatorSimRequest> above(requests), below(requests);
+    above.emplace_back(1, 1, numFloors + 1);
+    below.emplace_back(1, 0, 1);
+    int badAbove = batch.AddBuilding(above);
+    int badBelow = batch.AddBuilding(below);
+    batch.StepN(4 * numFloors + 10);
+
+    std::ostringstream detail;
+    detail << filename << ", " << numFloors << " floors: file " << (good >= 0 ? "accepted" : "refused") << ", floor "
+           << numFloors + 1 << " " << (badAbove < 0 ? "refused" : "accepted") << ", floor 0 " << (badBelow < 0 ? "refused" : "accepted")
+           << ", heights 0 and " << ECBatchElevatorSim::MAX_FLOORS + 10 << (fHeightsRefused ? " refused" : " accepted");
+    return Report("batch", fHeightsRefused && good == 0 && badAbove < 0 && badBelow < 0 && batch.GetNumBuildings() == 1, detail.str());
+}
+
+//*****************************************************************************
+// Group dispatch
+
+static bool CheckGroupPredictions(const std::string &filename, const std::vector<ECElevatorSimRequest> &requests) {
+    int numFloors = HighestFloor(requests);
+    // The file's calls, moved far enough apart that every car is idle when the next is made
+    std::vector<ECElevatorSimRequest> spaced;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (requests[i].GetFloorSrc() != requests[i].GetFloorDest()) {
+            spaced.emplace_back(static_cast<int>(spaced.size()) * (4 * numFloors + 20), requests[i].GetFloorSrc(), requests[i].GetFloorDest());
+        }
+    }
+
+    long long predictedWait = 0, predictedRide = 0;
+    ECGroupElevatorSim sim(numFloors, 2, spaced);
+    sim.GetController().SetDwellTicks(3);
+    for (const ECElevatorSimRequest &request : spaced) {
+        sim.StepN(request.GetTime() - sim.GetCurrentTime());
+        ECCallAssignment assignment = sim.GetController().Evaluate(request.GetFloorSrc(), request.GetFloorDest());
+        predictedWait += assignment.waitTicks;
+        predictedRide += assignment.rideTicks;
+    }
+    ECElevatorStepResult result = sim.StepN(4 * numFloors + 20);
+
+    std::ostringstream detail;
+    detail << filename << ", " << spaced.size() << " calls: waits " << predictedWait << " predicted, " << sim.GetWaitTimes().GetSum()
+           << " simulated; rides " << predictedRide << " predicted, " << sim.GetRideTimes().GetSum() << " simulated";
+    return Report("group", result.fComplete && predictedWait == sim.GetWaitTimes().GetSum() && predictedRide == sim.GetRideTimes().GetSum(),
+                  detail.str());
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <input_file>..." << std::endl;
+        return 2;
+    }
+    bool fAllOk = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string text;
+        std::vector<ECElevatorSimRequest> requests;
+        if (!ReadFile(argv[i], text, requests)) {
+            return 2;
+        }
+        fAllOk = CheckResume(argv[i], requests) && fAllOk;
+        fAllOk = CheckLiveSource(argv[i], text, requests) && fAllOk;
+        fAllOk = CheckTripTable(argv[i], requests) && fAllOk;
+        fAllOk = CheckBatchRefusesBadFloors(argv[i], requests) && fAllOk;
+        fAllOk = CheckGroupPredictions(argv[i], requests) && fAllOk;
+    }
+    return fAllOk ? 0 : 1;
+}
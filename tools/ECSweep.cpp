@@ -0,0 +1,244 @@
+//
+//  ECSweep.cpp
+//
+//  Sweeps building configurations (floors x call rate x lobby share). Every
+//  configuration is first scored with ECSurrogateEstimator; those predicted to
+//  miss --max-wait by more than the surrogate's error margin are pruned, the
+//  rest are ranked by the prediction and the best --keep are simulated with
+//  ECElevatorSim. Each sweep starts with the surrogate's accuracy on the
+//  built-in workloads; --accuracy prints that check in full.
+//
+
+#include "ECElevatorSim1.h"
+#include "ECTrafficGenerator.h"
+#include "ECSurrogateEstimator.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+struct ECSweepCandidate
+{
+    ECTrafficConfig traffic;
+    ECSurrogateEstimate predicted;
+    double simMeanWait;
+    double simP95Wait;
+    bool fSimulated;
+};
+
+static std::vector<double> ParseList(const std::string &text) {
+    std::vector<double> values;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(atof(item.c_str()));
+        }
+    }
+    return values;
+}
+
+// Mean and p95 wait over a few seeds of the configuration's traffic
+static void Simulate(const ECTrafficConfig &traffic, int numSeeds, double &meanWait, double &p95Wait) {
+    meanWait = p95Wait = 0;
+    for (int seed = 1; seed <= numSeeds; ++seed) {
+        std::vector<ECElevatorSimRequest> requests = ECTrafficGenerator(traffic).Generate(ECTrafficGenerator::StreamSeed(seed, 0));
+        ECElevatorSim sim(traffic.numFloors, requests);
+        sim.StepN(4 * traffic.duration);
+        meanWait += sim.GetWaitTimes().GetMean() / numSeeds;
+        p95Wait += static_cast<double>(sim.GetWaitTimes().GetPercentile(0.95)) / numSeeds;
+    }
+}
+
+// Built-in workloads: the heights and loads the fleet sees, from quiet to saturated
+static std::vector<ECTrafficConfig> GetBuiltinWorkloads() {
+    std::vector<ECTrafficConfig> workloads;
+    const int floors[] = { 5, 10, 20, 40 };
+    const double lobbyShares[] = { 0.0, 0.3, 0.8 };
+    const double rates[] = { 0.1, 0.3, 0.5, 0.8, 1.5 };
+    for (int numFloors : floors) {
+        for (double lobbyShare : lobbyShares) {
+            for (double rate : rates) {
+                ECTrafficConfig traffic;
+                traffic.numFloors = numFloors;
+                traffic.duration = 3600;
+                traffic.callsPerTick = rate;
+                traffic.lobbyShare = lobbyShare;
+                workloads.push_back(traffic);
+            }
+        }
+    }
+    return workloads;
+}
+
+struct ECAccuracy
+{
+    ECAccuracy() : count(0), meanError(0), meanErrorMax(0), p95Error(0), p95ErrorMax(0) {}
+
+    void Add(const ECSurrogateEstimate &predicted, double simMeanWait, double simP95Wait) {
+        double meanRel = fabs(predicted.meanWait - simMeanWait) / std::max(simMeanWait, 1e-9);
+        double p95Rel = fabs(predicted.p95Wait - simP95Wait) / std::max(simP95Wait, 1.0);
+        count++;
+        meanError += meanRel;
+        p95Error += p95Rel;
+        meanErrorMax = std::max(meanErrorMax, meanRel);
+        p95ErrorMax = std::max(p95ErrorMax, p95Rel);
+    }
+    void Print(std::ostream &out) const {
+        out << std::fixed << std::setprecision(1) << "mean wait " << 100 * meanError / std::max(count, 1) << "% average, "
+            << 100 * meanErrorMax << "% worst; p95 wait " << 100 * p95Error / std::max(count, 1) << "% average, "
+            << 100 * p95ErrorMax << "% worst";
+    }
+
+    int count;
+    double meanError;
+    double meanErrorMax;
+    double p95Error;
+    double p95ErrorMax;
+};
+
+static void PrintRow(const ECSweepCandidate &candidate) {
+    std::cout << std::fixed << std::setw(7) << candidate.traffic.numFloors << std::setprecision(2) << std::setw(8) << candidate.traffic.callsPerTick
+              << std::setw(8) << candidate.traffic.lobbyShare << std::setprecision(2) << std::setw(11) << candidate.predicted.meanWait
+              << std::setw(10) << candidate.predicted.p95Wait;
+    if (candidate.fSimulated) {
+        std::cout << std::setw(11) << candidate.simMeanWait << std::setw(10) << candidate.simP95Wait;
+    }
+    std::cout << std::endl;
+}
+
+static void PrintHeader() {
+    std::cout << std::setw(7) << "floors" << std::setw(8) << "rate" << std::setw(8) << "lobby" << std::setw(11) << "est mean"
+              << std::setw(10) << "est p95" << std::setw(11) << "sim mean" << std::setw(10) << "sim p95" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::vector<double> floorList = { 10 };
+    std::vector<double> rateList = { 0.05, 0.1, 0.2, 0.3, 0.5 };
+    std::vector<double> lobbyList = { 0.3 };
+    double maxWait = -1;
+    double margin = 0.3;
+    int keep = 10;
+    bool fRankP95 = false;
+    int numSeeds = 3;
+    int duration = 3600;
+    bool fAccuracyOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool fHasValue = i + 1 < argc;
+        if (arg == "--floors" && fHasValue) {
+            floorList = ParseList(argv[++i]);
+        } else if (arg == "--rates" && fHasValue) {
+            rateList = ParseList(argv[++i]);
+        } else if (arg == "--lobby" && fHasValue) {
+            lobbyList = ParseList(argv[++i]);
+        } else if (arg == "--max-wait" && fHasValue) {
+            maxWait = atof(argv[++i]);
+        } else if (arg == "--margin" && fHasValue) {
+            margin = atof(argv[++i]);
+        } else if (arg == "--keep" && fHasValue) {
+            keep = atoi(argv[++i]);
+        } else if (arg == "--rank" && fHasValue) {
+            fRankP95 = std::string(argv[++i]) == "p95";
+        } else if (arg == "--seeds" && fHasValue) {
+            numSeeds = std::max(atoi(argv[++i]), 1);
+        } else if (arg == "--duration" && fHasValue) {
+            duration = atoi(argv[++i]);
+        } else if (arg == "--accuracy") {
+            fAccuracyOnly = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--floors 10,20] [--rates 0.1,0.3] [--lobby 0,0.3] [--max-wait w] [--margin 0.3]"
+                      << " [--keep 10] [--rank mean|p95] [--seeds 3] [--duration 3600] [--accuracy]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Accuracy on the built-in workloads, so every sweep says how far to trust the screening
+    std::vector<ECTrafficConfig> workloads = GetBuiltinWorkloads();
+    ECAccuracy builtin;
+    double surrogateMicros = 0, simulationMicros = 0;
+    if (fAccuracyOnly) {
+        PrintHeader();
+    }
+    for (const ECTrafficConfig &traffic : workloads) {
+        ECSweepCandidate candidate;
+        candidate.traffic = traffic;
+        auto start = std::chrono::steady_clock::now();
+        candidate.predicted = ECSurrogateEstimator::Estimate(ECSurrogateInput::FromTraffic(traffic));
+        auto middle = std::chrono::steady_clock::now();
+        Simulate(traffic, 2, candidate.simMeanWait, candidate.simP95Wait);
+        auto end = std::chrono::steady_clock::now();
+        candidate.fSimulated = true;
+        surrogateMicros += std::chrono::duration<double, std::micro>(middle - start).count();
+        simulationMicros += std::chrono::duration<double, std::micro>(end - middle).count();
+        builtin.Add(candidate.predicted, candidate.simMeanWait, candidate.simP95Wait);
+        if (fAccuracyOnly) {
+            PrintRow(candidate);
+        }
+    }
+    std::cout << "Surrogate vs ECElevatorSim on " << workloads.size() << " built-in workloads: ";
+    builtin.Print(std::cout);
+    std::cout << std::endl << std::setprecision(1) << "  " << surrogateMicros / workloads.size() << " us an estimate, "
+              << simulationMicros / workloads.size() / 2000 << " ms a simulation" << std::endl;
+    if (fAccuracyOnly) {
+        return 0;
+    }
+
+    // Screen every configuration with the surrogate
+    std::vector<ECSweepCandidate> candidates;
+    for (double numFloors : floorList) {
+        for (double rate : rateList) {
+            for (double lobbyShare : lobbyList) {
+                ECSweepCandidate candidate;
+                candidate.traffic.numFloors = static_cast<int>(numFloors);
+                candidate.traffic.duration = duration;
+                candidate.traffic.callsPerTick = rate;
+                candidate.traffic.lobbyShare = lobbyShare;
+                candidate.predicted = ECSurrogateEstimator::Estimate(ECSurrogateInput::FromTraffic(candidate.traffic));
+                candidate.simMeanWait = candidate.simP95Wait = 0;
+                candidate.fSimulated = false;
+                candidates.push_back(candidate);
+            }
+        }
+    }
+    size_t numCandidates = candidates.size();
+    if (maxWait >= 0) {
+        double limit = maxWait * (1 + margin);
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [limit, fRankP95](const ECSweepCandidate &candidate) {
+            return (fRankP95 ? candidate.predicted.p95Wait : candidate.predicted.meanWait) > limit;
+        }), candidates.end());
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [fRankP95](const ECSweepCandidate &a, const ECSweepCandidate &b) {
+        return fRankP95 ? a.predicted.p95Wait < b.predicted.p95Wait : a.predicted.meanWait < b.predicted.meanWait;
+    });
+    size_t numPruned = numCandidates - candidates.size();
+    if (keep >= 0 && candidates.size() > static_cast<size_t>(keep)) {
+        candidates.resize(keep);
+    }
+
+    // Full simulations only for the survivors
+    ECAccuracy survivors;
+    for (ECSweepCandidate &candidate : candidates) {
+        Simulate(candidate.traffic, numSeeds, candidate.simMeanWait, candidate.simP95Wait);
+        candidate.fSimulated = true;
+        survivors.Add(candidate.predicted, candidate.simMeanWait, candidate.simP95Wait);
+    }
+
+    std::cout << numCandidates << " configurations: " << numPruned << " pruned by the surrogate, "
+              << candidates.size() << " simulated (" << numSeeds << " seeds each)" << std::endl;
+    PrintHeader();
+    for (const ECSweepCandidate &candidate : candidates) {
+        PrintRow(candidate);
+    }
+    if (survivors.count > 0) {
+        std::cout << "Surrogate vs ECElevatorSim on these: ";
+        survivors.Print(std::cout);
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+//
+//  ECTelemetryReader.cpp
+//
+//  Reference consumer of a simulator's shared-memory telemetry segment:
+//  attaches read-only and prints a line whenever a new tick is published.
+//
+
+#include "ECTelemetry.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+static const char *DirectionString(int direction) {
+    switch (direction) {
+        case 1: return "UP";
+        case 2: return "DOWN";
+        default: return "STOPPED";
+    }
+}
+
+static void PrintSnapshot(const ECTelemetrySnapshot &snapshot) {
+    std::cout << "t=" << snapshot.time << " floor=" << snapshot.currentFloor
+              << " dir=" << DirectionString(snapshot.direction) << " riders=" << snapshot.numRiders
+              << " waiting=";
+    // numFloors comes from shared memory; never index past the arrays on its word
+    int numFloors = std::max(0, std::min(static_cast<int>(snapshot.numFloors), EC_TELEMETRY_MAX_FLOORS));
+    for (int i = 0; i < numFloors; ++i) {
+        std::cout << (i > 0 ? "," : "") << snapshot.waitingPassengers[i];
+    }
+    std::cout << " requests=" << snapshot.requests << " boarded=" << snapshot.boardings
+              << " arrived=" << snapshot.alightings << " moves=" << snapshot.moves
+              << " wait p50/p90/p99/max=" << snapshot.waitP50 << "/" << snapshot.waitP90 << "/"
+              << snapshot.waitP99 << "/" << snapshot.waitMax << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <segment_name> [--interval <ms>] [--once]" << std::endl;
+        return 1;
+    }
+
+    std::string name = argv[1];
+    int intervalMillis = 100;
+    bool fOnce = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--interval" && i + 1 < argc) {
+            intervalMillis = atoi(argv[++i]);
+        } else if (arg == "--once") {
+            fOnce = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    ECTelemetryReader reader(name);
+    if (!reader.Open()) {
+        return 1;
+    }
+
+    // Polling is plain memory reads; only the sleep between polls is a system call
+    long long lastPublished = -1;
+    ECTelemetrySnapshot snapshot;
+    while (true) {
+        if (!reader.Read(snapshot)) {
+            std::cerr << "Warning: Writer busy, skipped a poll" << std::endl;
+        } else if (snapshot.publishCount != lastPublished) {
+            lastPublished = snapshot.publishCount;
+            PrintSnapshot(snapshot);
+            if (fOnce) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMillis));
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+//
+//  ECTripQuery.cpp
+//
+//  Filters and aggregates a trip table (see ECTripTable.h) on all cores. Row
+//  groups are handed out to threads one at a time; each thread scans the
+//  memory-mapped columns of its groups into private totals, which are added
+//  up at the end. Groups whose call times fall outside --from/--to are skipped
+//  without being read.
+//
+//  Waits are boarding time minus call time, rides arrival minus boarding, and
+//  trips arrival minus call time, all in ticks.
+//
+
+#include "ECTripTable.h"
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+
+typedef enum
+{
+    EC_TRIP_GROUP_NONE = 0,
+    EC_TRIP_GROUP_SRC,
+    EC_TRIP_GROUP_DEST,
+    EC_TRIP_GROUP_CAR,
+    EC_TRIP_GROUP_TIME       // call time, in buckets of --bucket ticks
+} EC_TRIP_GROUP_BY;
+
+struct ECTripFilter
+{
+    int floorSrc;      // -1: any
+    int floorDest;
+    int car;
+    int timeFrom;      // call time in [timeFrom, timeTo)
+    int timeTo;
+    int minWait;
+    int maxWait;
+};
+
+struct ECTripTotals
+{
+    long long count;
+    long long waitSum;
+    long long rideSum;
+    int waitMax;
+};
+
+static void ScanGroup(const ECTripGroupView &group, const ECTripFilter &filter, EC_TRIP_GROUP_BY groupBy,
+                      int bucket, ECTripTotals *totals, int numKeys) {
+    // Filters that are not set become ranges everything passes, so the loop has no special cases
+    int srcLo = filter.floorSrc < 0 ? 0 : filter.floorSrc, srcHi = filter.floorSrc < 0 ? 65535 : filter.floorSrc;
+    int destLo = filter.floorDest < 0 ? 0 : filter.floorDest, destHi = filter.floorDest < 0 ? 65535 : filter.floorDest;
+    int carLo = filter.car < 0 ? 0 : filter.car, carHi = filter.car < 0 ? 65535 : filter.car;
+
+    for (int i = 0; i < group.numRows; ++i) {
+        int timeCall = group.timeCall[i];
+        int wait = group.timeBoard[i] - timeCall;
+        int src = group.floorSrc[i];
+        int dest = group.floorDest[i];
+        int car = group.car[i];
+        bool fKeep = (timeCall >= filter.timeFrom) & (timeCall < filter.timeTo) &
+                     (wait >= filter.minWait) & (wait <= filter.maxWait) &
+                     (src >= srcLo) & (src <= srcHi) & (dest >= destLo) & (dest <= destHi) &
+                     (car >= carLo) & (car <= carHi);
+        if (!fKeep) {
+            continue;
+        }
+        int key = 0;
+        switch (groupBy) {
+            case EC_TRIP_GROUP_SRC: key = src; break;
+            case EC_TRIP_GROUP_DEST: key = dest; break;
+            case EC_TRIP_GROUP_CAR: key = car; break;
+            case EC_TRIP_GROUP_TIME: key = std::max(timeCall, 0) / bucket; break;
+            default: break;
+        }
+        if (key >= numKeys) {
+            continue;
+        }
+        ECTripTotals &total = totals[key];
+        total.count++;
+        total.waitSum += wait;
+        total.rideSum += group.timeArrive[i] - group.timeBoard[i];
+        total.waitMax = std::max(total.waitMax, wait);
+    }
+}
+
+static EC_TRIP_GROUP_BY ParseGroupBy(const std::string &name) {
+    if (name == "src") return EC_TRIP_GROUP_SRC;
+    if (name == "dest") return EC_TRIP_GROUP_DEST;
+    if (name == "car") return EC_TRIP_GROUP_CAR;
+    if (name == "time") return EC_TRIP_GROUP_TIME;
+    std::cerr << "Error: --by must be src, dest, car or time" << std::endl;
+    exit(1);
+}
+
+static void PrintTotals(const ECTripTotals &total) {
+    double count = static_cast<double>(std::max(total.count, 1LL));
+    std::cout << std::setw(12) << total.count
+              << std::setw(12) << total.waitSum / count
+              << std::setw(10) << (total.count > 0 ? total.waitMax : 0)
+              << std::setw(12) << total.rideSum / count
+              << std::setw(12) << (total.waitSum + total.rideSum) / count << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trip_table> [--src n] [--dest n] [--car n] [--from t] [--to t]"
+                  << " [--min-wait w] [--max-wait w] [--by src|dest|car|time] [--bucket 3600] [--threads n]" << std::endl;
+        return 1;
+    }
+    ECTripFilter filter = { -1, -1, -1, INT_MIN, INT_MAX, INT_MIN, INT_MAX };
+    EC_TRIP_GROUP_BY groupBy = EC_TRIP_GROUP_NONE;
+    int bucket = 3600;
+    int numThreads = static_cast<int>(std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--src") {
+            filter.floorSrc = atoi(argv[++i]);
+        } else if (arg == "--dest") {
+            filter.floorDest = atoi(argv[++i]);
+        } else if (arg == "--car") {
+            filter.car = atoi(argv[++i]);
+        } else if (arg == "--from") {
+            filter.timeFrom = atoi(argv[++i]);
+        } else if (arg == "--to") {
+            filter.timeTo = atoi(argv[++i]);
+        } else if (arg == "--min-wait") {
+            filter.minWait = atoi(argv[++i]);
+        } else if (arg == "--max-wait") {
+            filter.maxWait = atoi(argv[++i]);
+        } else if (arg == "--by") {
+            groupBy = ParseGroupBy(argv[++i]);
+        } else if (arg == "--bucket") {
+            bucket = std::max(atoi(argv[++i]), 1);
+        } else if (arg == "--threads") {
+            numThreads = atoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    numThreads = std::max(numThreads, 1);
+
+    ECTripTableReader table;
+    if (!table.Open(argv[1])) {
+        return 1;
+    }
+
+    // One totals slot per key: floors and cars fit in 16 bits; time buckets run up to the last call
+    int numKeys = 1;
+    if (groupBy == EC_TRIP_GROUP_SRC || groupBy == EC_TRIP_GROUP_DEST || groupBy == EC_TRIP_GROUP_CAR) {
+        numKeys = 65536;
+    } else if (groupBy == EC_TRIP_GROUP_TIME) {
+        int lastCall = 0;
+        for (int g = 0; g < table.GetNumGroups(); ++g) {
+            lastCall = std::max(lastCall, table.GetGroup(g).timeCallMax);
+        }
+        numKeys = lastCall / bucket + 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int> nextGroup(0);
+    std::atomic<long long> rowsScanned(0);
+    std::atomic<int> groupsSkipped(0);
+    ECTripTotals zero = { 0, 0, 0, INT_MIN };
+    std::vector<std::vector<ECTripTotals> > threadTotals(numThreads, std::vector<ECTripTotals>(numKeys, zero));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            long long rows = 0;
+            int skipped = 0;
+            int g;
+            while ((g = nextGroup.fetch_add(1)) < table.GetNumGroups()) {
+                ECTripGroupView group = table.GetGroup(g);
+                if (group.timeCallMax < filter.timeFrom || group.timeCallMin >= filter.timeTo) {
+                    skipped++;
+                    continue;
+                }
+                ScanGroup(group, filter, groupBy, bucket, threadTotals[t].data(), numKeys);
+                rows += group.numRows;
+            }
+            rowsScanned += rows;
+            groupsSkipped += skipped;
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<ECTripTotals> totals(numKeys, zero);
+    for (int t = 0; t < numThreads; ++t) {
+        for (int key = 0; key < numKeys; ++key) {
+            const ECTripTotals &part = threadTotals[t][key];
+            totals[key].count += part.count;
+            totals[key].waitSum += part.waitSum;
+            totals[key].rideSum += part.rideSum;
+            totals[key].waitMax = std::max(totals[key].waitMax, part.waitMax);
+        }
+    }
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Scanned " << rowsScanned << " of " << table.GetNumRows() << " trips (" << groupsSkipped << " of "
+              << table.GetNumGroups() << " groups skipped) on " << numThreads << " threads in " << millis << " ms" << std::endl;
+    const char *keyName = groupBy == EC_TRIP_GROUP_SRC ? "src" : groupBy == EC_TRIP_GROUP_DEST ? "dest"
+                        : groupBy == EC_TRIP_GROUP_CAR ? "car" : groupBy == EC_TRIP_GROUP_TIME ? "from" : "";
+    std::cout << std::setw(12) << keyName << std::setw(12) << "trips" << std::setw(12) << "avg wait" << std::setw(10) << "max wait"
+              << std::setw(12) << "avg ride" << std::setw(12) << "avg trip" << std::endl;
+    if (groupBy == EC_TRIP_GROUP_NONE) {
+        std::cout << std::setw(12) << "all";
+        PrintTotals(totals[0]);
+        return 0;
+    }
+    for (int key = 0; key < numKeys; ++key) {
+        if (totals[key].count == 0) {
+            continue;
+        }
+        std::cout << std::setw(12) << (groupBy == EC_TRIP_GROUP_TIME ? static_cast<long long>(key) * bucket : key);
+        PrintTotals(totals[key]);
+    }
+    return 0;
+}